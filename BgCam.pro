@@ -9,34 +9,120 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    alphablend.cpp \
+    animatedsticker.cpp \
     audiorecorder.cpp \
+    audioring.cpp \
+    bgcamengine.cpp \
+    cameraenumerator.cpp \
+    camerapipeline.cpp \
+    capturethread.cpp \
+    framepool.cpp \
+    framepreview.cpp \
+    framesource.cpp \
     humanseg.cpp \
+    jpegdecodepool.cpp \
+    livetext.cpp \
     main.cpp \
     mainwindow.cpp \
+    mediamuxer.cpp \
+    overlaycompositor.cpp \
+    playbacksource.cpp \
     previewwidget.cpp \
-    puttext.cpp
+    recordingencoder.cpp \
+    replaybuffer.cpp \
+    segmentationservice.cpp \
+    taskscheduler.cpp \
+    textrenderer.cpp \
+    vcamshm.cpp \
+    virtualcamera.cpp
 
 HEADERS += \
+    alphablend.h \
+    animatedsticker.h \
     audiorecorder.h \
-    humanseg.h \
+    audioring.h \
+    bgcamengine.h \
+    cameraenumerator.h \
+    camerapipeline.h \
+    capturethread.h \
+    framepool.h \
+    framepreview.h \
+    framesource.h \
+    HumanSeg.h \
+    jpegdecodepool.h \
+    livetext.h \
     mainwindow.h \
+    mediaclock.h \
+    mediamuxer.h \
+    overlaycompositor.h \
+    playbacksource.h \
     previewwidget.h \
-    puttext.h
+    recordingencoder.h \
+    replaybuffer.h \
+    segmentationservice.h \
+    taskscheduler.h \
+    textrenderer.h \
+    vcamshm.h \
+    virtualcamera.h
 
 FORMS += \
     mainwindow.ui
-INCLUDEPATH +=C:\Qt\opencv\forQt/install/include \
-     C:\Qt\opencv\forQt/install/include/opencv2 \
-     $${PWD}/onnxruntime-win-x64-1.23.2/include/
+# 第三方库位置可在命令行覆盖，例如 qmake OPENCV_DIR=D:/opencv ONNXRUNTIME_DIR=/opt/onnxruntime
+win32 {
+    isEmpty(OPENCV_DIR): OPENCV_DIR = C:/Qt/opencv/forQt/install
+    isEmpty(ONNXRUNTIME_DIR): ONNXRUNTIME_DIR = $${PWD}/onnxruntime-win-x64-1.23.2
+    INCLUDEPATH += $${OPENCV_DIR}/include $${OPENCV_DIR}/include/opencv2
+    LIBS += $${OPENCV_DIR}/x64/mingw/lib/libopencv_*.a
+    LIBS += -L$${ONNXRUNTIME_DIR}/lib -lonnxruntime -lonnxruntime_providers_shared
+}
+unix {
+    # OpenCV 通过 pkg-config；ONNX Runtime 默认使用解压到 /opt/onnxruntime 的官方发布包
+    isEmpty(ONNXRUNTIME_DIR): ONNXRUNTIME_DIR = /opt/onnxruntime
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv4
+    LIBS += -L$${ONNXRUNTIME_DIR}/lib -lonnxruntime
+    QMAKE_RPATHDIR += $${ONNXRUNTIME_DIR}/lib
+}
+INCLUDEPATH += $${ONNXRUNTIME_DIR}/include
+
+# FreeType 文字渲染（Windows 下使用项目目录中的预编译库，Linux 下通过 pkg-config）
+win32 {
+    INCLUDEPATH += $${PWD}/freetype/include/freetype2
+    LIBS += -L$${PWD}/freetype/lib -lfreetype
+}
+unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += freetype2 fontconfig
+}
 
-LIBS += C:\Qt\opencv\forQt/install/x64/mingw/lib/libopencv_*.a \
--L$${PWD}/onnxruntime-win-x64-1.23.2/lib/ -lonnxruntime -lonnxruntime_providers_shared
+# FFmpeg 进程内编码封装（Windows 下使用项目目录中 gpl-shared 包自带的头文件和导入库）
+win32 {
+    INCLUDEPATH += $${PWD}/ffmpeg-master-latest-win64-gpl-shared/include
+    LIBS += -L$${PWD}/ffmpeg-master-latest-win64-gpl-shared/lib -lavformat -lavcodec -lavutil -lswscale -lswresample
+}
+unix {
+    PKGCONFIG += libavformat libavcodec libavutil libswscale libswresample
+}
+
+# libjpeg-turbo 解码 MJPEG 摄像头数据（找不到时退回 cv::imdecode）
+win32:exists($${PWD}/libjpeg-turbo/include/turbojpeg.h) {
+    INCLUDEPATH += $${PWD}/libjpeg-turbo/include
+    LIBS += -L$${PWD}/libjpeg-turbo/lib -lturbojpeg
+    DEFINES += HAVE_TURBOJPEG
+}
+unix:packagesExist(libturbojpeg) {
+    PKGCONFIG += libturbojpeg
+    DEFINES += HAVE_TURBOJPEG
+}
 
-# Windows平台下链接GDI32库
 win32 {
-    LIBS += -lgdi32
     DEFINES += UNICODE
 }
+# 虚拟摄像头共享内存（POSIX shm_open 在较旧的 glibc 中位于 librt）
+unix:!macx {
+    LIBS += -lrt
+}
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
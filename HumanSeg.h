@@ -1,7 +1,6 @@
 #ifndef HUMANSEG_H
 #define HUMANSEG_H
 
-#include <onnxruntime_cxx_api.h>
 #include <opencv2/opencv.hpp>
 #include <memory>
 #include <string>
@@ -9,9 +8,8 @@
 #include <filesystem>
 #include <stdexcept>
 #include <tuple>
-#include "puttext.h"
-#include <QDebug>
-#include <QStringConverter>
+#include "segmentationservice.h"
+#include "textrenderer.h"
 namespace fs = std::filesystem;
 class HumanSeg {
 public:
@@ -21,6 +19,13 @@ public:
      */
     explicit HumanSeg(float conf_thres = 0.5f);
 
+    /**
+     * @brief 使用共享的推理服务构造（多路摄像头共用一个模型会话）
+     * @param service 推理服务
+     * @param conf_thres 分割置信度阈值
+     */
+    HumanSeg(std::shared_ptr<SegmentationService> service, float conf_thres = 0.5f);
+
     /**
      * @brief 析构函数
      */
@@ -39,14 +44,28 @@ public:
      */
     cv::Mat segmentAndReplace(const cv::Mat& frame);
 
+    /**
+     * @brief segmentAndReplace 的 NV12 版本：只把缩放到模型尺寸的小图转成 RGB，背景替换和文字在 YUV 上完成
+     * @param nv12 输入帧（CV_8UC1，高为图像高度的 1.5 倍，宽高均为偶数）
+     * @return 处理后的 NV12 帧
+     */
+    cv::Mat segmentAndReplaceNV12(const cv::Mat& nv12);
+
     /**
      * @brief 释放所有资源
      */
     void release();
 
     /**
-     * @brief 设置绘制的文字属性（仅支持ASCII字符）
-     * @param title 文字内容（ASCII）
+     * @brief 是否作为推理服务的使用者参与凑 batch（构造后默认参与）
+     *
+     * 不做背景替换时应设为 false，否则其他摄像头每次推理都要白等这一路的请求
+     */
+    void setActive(bool active);
+
+    /**
+     * @brief 设置绘制的文字属性（支持中文）
+     * @param title 文字内容（UTF-8）
      * @param x 横坐标
      * @param y 纵坐标
      * @param font_size 字体大小
@@ -58,9 +77,13 @@ public:
         this->titleY = y;
         this->font_size = font_size;
         this->rgb = rgb;
+        this->titleDirty = true;
     }
     void setTitle(const std::string& title) {
-        this->title = title;
+        if (this->title != title) {
+            this->title = title;
+            this->titleDirty = true;
+        }
     }
     void setTitleX(int x){
         this->titleX=x;
@@ -69,13 +92,19 @@ public:
         this->titleY=y;
     }
     void setFontSize(int size){
-        this->font_size=size;
+        if (this->font_size != size) {
+            this->font_size=size;
+            this->titleDirty = true;
+        }
     }
     void setRgb(std::tuple<int, int, int> rgb){
         this->rgb=rgb;
     }
     void setFontName(const std::string& font_name){
-        this->font_name=font_name;
+        if (this->font_name != font_name) {
+            this->font_name=font_name;
+            this->titleDirty = true;
+        }
     }
     void setConfThreshold(float threshold){
         this->conf_threshold=threshold;
@@ -91,6 +120,15 @@ private:
      * @return 背景帧
      */
     cv::Mat getBgFrame(const std::pair<int, int>& target_size);
+    /**
+     * @brief 获取适配尺寸的 NV12 背景帧（缓存，背景内容或尺寸变化时才重新转换）
+     */
+    const cv::Mat& getBgFrameNV12(cv::Size size);
+    /**
+     * @brief 对 inputResized 归一化并推理，生成 frameSize 尺寸的人像掩码 personMask
+     */
+    void inferMask(cv::Size frameSize);
+    void updateTitleMask();
 
     /**
      * @brief 读取带中文路径的图片
@@ -100,9 +138,9 @@ private:
      */
     cv::Mat imreadChinese(const std::string& path, int flags = cv::IMREAD_UNCHANGED);
 
-    // ONNX Runtime 相关
-    std::unique_ptr<Ort::Session> ort_session;
-    Ort::Env env{OrtLoggingLevel::ORT_LOGGING_LEVEL_WARNING, "HumanSeg"};
+    // 推理服务（可与其他 HumanSeg 共享）
+    std::shared_ptr<SegmentationService> service;
+    bool registered = false;  // 已在推理服务登记为使用者
     float conf_threshold;
     int input_height = 192;  // MODNet输入高度
     int input_width = 384;   // MODNet输入宽度
@@ -115,14 +153,38 @@ private:
     std::string bg_type;
     cv::Mat bg_image;
     cv::VideoCapture bg_video;
+    cv::Mat bg_video_frame;
+    cv::Mat bg_resized;      // 缩放到画面尺寸的背景（图片背景只缩放一次）
+    cv::Mat bgI420;
+    cv::Mat bgNV12;          // bg_resized 对应的 NV12
+    bool bgNV12Dirty = true;
 
-    // 基础文字绘制相关（仅ASCII）
-    std::string title = ""; // 默认ASCII文字
+    // 每帧复用的中间结果
+    cv::Mat inputResized;
+    std::vector<float> inputTensor;
+    std::vector<float> outputTensor;
+    cv::Mat segMapResized;
+    cv::Mat personMask;
+    cv::Mat personMask3ch;
+    cv::Mat invMask3ch;
+    cv::Mat bgPart;
+    cv::Mat modelY;          // NV12 路径：缩放到模型尺寸的 Y/UV 平面
+    cv::Mat modelUV;
+    cv::Mat invMask;
+    cv::Mat invMaskHalf;
+
+    // 文字绘制相关（UTF-8，FreeType渲染）
+    std::string title = "";
     int titleX = 10;
     int titleY = 10;
     int font_size = 40;
     std::string font_name = "微软雅黑";
     std::tuple<int, int, int> rgb = {0, 0, 0}; // 默认黑色
+
+    // 标题覆盖率蒙版缓存：只在文字/字体/字号变化时重新栅格化，位置和颜色在混合时应用
+    cv::Mat titleMask;
+    cv::Point titleMaskOffset;
+    bool titleDirty = true;
 };
 
 #endif // HUMANSEG_H
@@ -0,0 +1,181 @@
+#include "alphablend.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <algorithm>
+
+namespace {
+// BT.601 有限范围；输入为预乘颜色时 a 为其 alpha，偏置量同样按 a 缩放
+inline void bgrToYuv(int b, int g, int r, int a, int yuv[3])
+{
+    yuv[0] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + div255(16 * a);
+    yuv[1] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + div255(128 * a);
+    yuv[2] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + div255(128 * a);
+}
+
+inline uchar blendChannel(int src, int dst, int a)
+{
+    return cv::saturate_cast<uchar>(div255(src * a + dst * (255 - a)));
+}
+}
+
+void alphaBlendColorRow(uchar* dst, const uchar* alpha, int width, const uchar bgr[3])
+{
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    using namespace cv;
+    const int lanes = VTraits<v_uint8>::vlanes();
+    const v_uint16 v255 = vx_setall_u16(255);
+    const v_uint16 v128 = vx_setall_u16(128);
+    const v_uint16 cb = vx_setall_u16(bgr[0]);
+    const v_uint16 cg = vx_setall_u16(bgr[1]);
+    const v_uint16 cr = vx_setall_u16(bgr[2]);
+    // c*a + d*(255-a) 最大 65025，加上舍入项仍在 16 位范围内
+    auto blend = [&](const v_uint8& d, const v_uint16& c, const v_uint16& a0, const v_uint16& a1,
+                     const v_uint16& i0, const v_uint16& i1) {
+        v_uint16 d0, d1;
+        v_expand(d, d0, d1);
+        v_uint16 t0 = v_add(v_add(v_mul_wrap(c, a0), v_mul_wrap(d0, i0)), v128);
+        v_uint16 t1 = v_add(v_add(v_mul_wrap(c, a1), v_mul_wrap(d1, i1)), v128);
+        t0 = v_shr<8>(v_add(t0, v_shr<8>(t0)));
+        t1 = v_shr<8>(v_add(t1, v_shr<8>(t1)));
+        return v_pack(t0, t1);
+    };
+    for (; x <= width - lanes; x += lanes) {
+        v_uint8 a = vx_load(alpha + x);
+        v_uint16 a0, a1;
+        v_expand(a, a0, a1);
+        const v_uint16 i0 = v_sub(v255, a0);
+        const v_uint16 i1 = v_sub(v255, a1);
+        v_uint8 b, g, r;
+        v_load_deinterleave(dst + x * 3, b, g, r);
+        b = blend(b, cb, a0, a1, i0, i1);
+        g = blend(g, cg, a0, a1, i0, i1);
+        r = blend(r, cr, a0, a1, i0, i1);
+        v_store_interleave(dst + x * 3, b, g, r);
+    }
+    vx_cleanup();
+#endif
+    for (; x < width; ++x) {
+        const int a = alpha[x];
+        if (a == 0) continue;
+        const int inv = 255 - a;
+        uchar* d = dst + x * 3;
+        d[0] = static_cast<uchar>(div255(bgr[0] * a + d[0] * inv));
+        d[1] = static_cast<uchar>(div255(bgr[1] * a + d[1] * inv));
+        d[2] = static_cast<uchar>(div255(bgr[2] * a + d[2] * inv));
+    }
+}
+
+void alphaBlendPremultipliedRow(uchar* dst, const uchar* src, int width)
+{
+    int x = 0;
+#if (CV_SIMD || CV_SIMD_SCALABLE)
+    using namespace cv;
+    const int lanes = VTraits<v_uint8>::vlanes();
+    const v_uint16 v255 = vx_setall_u16(255);
+    const v_uint16 v128 = vx_setall_u16(128);
+    auto blend = [&](const v_uint8& d, const v_uint8& s, const v_uint16& i0, const v_uint16& i1) {
+        v_uint16 d0, d1;
+        v_expand(d, d0, d1);
+        v_uint16 t0 = v_add(v_mul_wrap(d0, i0), v128);
+        v_uint16 t1 = v_add(v_mul_wrap(d1, i1), v128);
+        t0 = v_shr<8>(v_add(t0, v_shr<8>(t0)));
+        t1 = v_shr<8>(v_add(t1, v_shr<8>(t1)));
+        return v_add_wrap(s, v_pack(t0, t1));
+    };
+    for (; x <= width - lanes; x += lanes) {
+        v_uint8 sb, sg, sr, sa;
+        v_load_deinterleave(src + x * 4, sb, sg, sr, sa);
+        v_uint16 a0, a1;
+        v_expand(sa, a0, a1);
+        const v_uint16 i0 = v_sub(v255, a0);
+        const v_uint16 i1 = v_sub(v255, a1);
+        v_uint8 b, g, r;
+        v_load_deinterleave(dst + x * 3, b, g, r);
+        b = blend(b, sb, i0, i1);
+        g = blend(g, sg, i0, i1);
+        r = blend(r, sr, i0, i1);
+        v_store_interleave(dst + x * 3, b, g, r);
+    }
+    vx_cleanup();
+#endif
+    for (; x < width; ++x) {
+        const uchar* s = src + x * 4;
+        const int inv = 255 - s[3];
+        if (inv == 255) continue;
+        uchar* d = dst + x * 3;
+        d[0] = static_cast<uchar>(s[0] + div255(d[0] * inv));
+        d[1] = static_cast<uchar>(s[1] + div255(d[1] * inv));
+        d[2] = static_cast<uchar>(s[2] + div255(d[2] * inv));
+    }
+}
+
+void alphaBlendColor(cv::Mat& dst, const cv::Mat& coverage, cv::Point at, const cv::Scalar& color)
+{
+    CV_Assert(dst.type() == CV_8UC3 && coverage.type() == CV_8UC1);
+    const cv::Rect target = cv::Rect(at.x, at.y, coverage.cols, coverage.rows) & cv::Rect(0, 0, dst.cols, dst.rows);
+    if (target.empty()) {
+        return;
+    }
+    const uchar bgr[3] = {cv::saturate_cast<uchar>(color[0]),
+                          cv::saturate_cast<uchar>(color[1]),
+                          cv::saturate_cast<uchar>(color[2])};
+    for (int y = target.y; y < target.y + target.height; ++y) {
+        const uchar* a = coverage.ptr<uchar>(y - at.y) + (target.x - at.x);
+        alphaBlendColorRow(dst.ptr<uchar>(y) + target.x * 3, a, target.width, bgr);
+    }
+}
+
+void alphaBlendColorRowNV12(uchar* yRow, uchar* uvRow, int x0, const uchar* alpha, int width, const uchar bgr[3])
+{
+    int yuv[3];
+    bgrToYuv(bgr[0], bgr[1], bgr[2], 255, yuv);
+    for (int i = 0; i < width; ++i) {
+        const int a = alpha[i];
+        if (a == 0) continue;
+        const int x = x0 + i;
+        yRow[x] = blendChannel(yuv[0], yRow[x], a);
+        // 色度 2x2 共用一个样本，取块内左上角像素的覆盖率
+        if (uvRow && (x & 1) == 0) {
+            uchar* uv = uvRow + x;
+            uv[0] = blendChannel(yuv[1], uv[0], a);
+            uv[1] = blendChannel(yuv[2], uv[1], a);
+        }
+    }
+}
+
+void alphaBlendPremultipliedRowNV12(uchar* yRow, uchar* uvRow, int x0, const uchar* src, int width)
+{
+    for (int i = 0; i < width; ++i) {
+        const uchar* s = src + i * 4;
+        const int a = s[3];
+        if (a == 0) continue;
+        const int x = x0 + i;
+        int yuv[3];
+        bgrToYuv(s[0], s[1], s[2], a, yuv);
+        const int inv = 255 - a;
+        yRow[x] = cv::saturate_cast<uchar>(yuv[0] + div255(yRow[x] * inv));
+        if (uvRow && (x & 1) == 0) {
+            uchar* uv = uvRow + x;
+            uv[0] = cv::saturate_cast<uchar>(yuv[1] + div255(uv[0] * inv));
+            uv[1] = cv::saturate_cast<uchar>(yuv[2] + div255(uv[1] * inv));
+        }
+    }
+}
+
+void alphaBlendColorNV12(cv::Mat& nv12, const cv::Mat& coverage, cv::Point at, const cv::Scalar& color)
+{
+    CV_Assert(nv12.type() == CV_8UC1 && nv12.rows % 3 == 0 && coverage.type() == CV_8UC1);
+    const int height = nv12.rows * 2 / 3;
+    const cv::Rect target = cv::Rect(at.x, at.y, coverage.cols, coverage.rows) & cv::Rect(0, 0, nv12.cols, height);
+    if (target.empty()) {
+        return;
+    }
+    const uchar bgr[3] = {cv::saturate_cast<uchar>(color[0]),
+                          cv::saturate_cast<uchar>(color[1]),
+                          cv::saturate_cast<uchar>(color[2])};
+    for (int y = target.y; y < target.y + target.height; ++y) {
+        const uchar* a = coverage.ptr<uchar>(y - at.y) + (target.x - at.x);
+        uchar* uvRow = (y & 1) == 0 ? nv12.ptr<uchar>(height + y / 2) : nullptr;
+        alphaBlendColorRowNV12(nv12.ptr<uchar>(y), uvRow, target.x, a, target.width, bgr);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef ALPHABLEND_H
+#define ALPHABLEND_H
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief x/255 的整数近似，对 0~65025 精确四舍五入
+ */
+inline int div255(int v)
+{
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+/**
+ * @brief 以覆盖率为 alpha，把纯色混合进一行 BGR 像素（8位定点 SIMD）
+ * @param dst BGR 像素行（原地修改）
+ * @param alpha 覆盖率（0~255）
+ * @param width 像素个数
+ * @param bgr 颜色
+ */
+void alphaBlendColorRow(uchar* dst, const uchar* alpha, int width, const uchar bgr[3]);
+
+/**
+ * @brief 把一行预乘 BGRA 像素叠加到 BGR 像素行上：d = s + d * (255 - a) / 255
+ */
+void alphaBlendPremultipliedRow(uchar* dst, const uchar* src, int width);
+
+/**
+ * @brief 以覆盖率蒙版为 alpha 把纯色混合到图像上，只处理蒙版包围盒与图像的交集
+ * @param dst 目标图像（CV_8UC3）
+ * @param coverage 覆盖率蒙版（CV_8UC1）
+ * @param at 蒙版左上角在目标图像中的位置
+ * @param color 颜色（BGR）
+ */
+void alphaBlendColor(cv::Mat& dst, const cv::Mat& coverage, cv::Point at, const cv::Scalar& color);
+
+/**
+ * @brief alphaBlendColorRow 的 NV12 版本：混合一行 Y 平面，偶数行同时混合对应的 UV 行
+ * @param yRow Y 平面行首
+ * @param uvRow UV 平面行首，奇数行传 nullptr（色度只在偶数行、偶数列采样）
+ * @param x0 起始列
+ * @param alpha 从 x0 开始的覆盖率
+ * @param width 像素个数
+ * @param bgr 颜色，内部按 BT.601 有限范围换算为 YUV
+ */
+void alphaBlendColorRowNV12(uchar* yRow, uchar* uvRow, int x0, const uchar* alpha, int width, const uchar bgr[3]);
+
+/**
+ * @brief alphaBlendPremultipliedRow 的 NV12 版本，参数含义同 alphaBlendColorRowNV12
+ */
+void alphaBlendPremultipliedRowNV12(uchar* yRow, uchar* uvRow, int x0, const uchar* src, int width);
+
+/**
+ * @brief alphaBlendColor 的 NV12 版本
+ * @param nv12 NV12 图像（CV_8UC1，高为图像高度的 1.5 倍）
+ */
+void alphaBlendColorNV12(cv::Mat& nv12, const cv::Mat& coverage, cv::Point at, const cv::Scalar& color);
+
+#endif // ALPHABLEND_H
@@ -0,0 +1,106 @@
+#include "animatedsticker.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+// GIF 中 0 或极小的帧间隔按浏览器惯例视为 100ms
+constexpr int kMinFrameDelayMs = 20;
+constexpr int kDefaultFrameDelayMs = 100;
+constexpr int kMinStickerSide = 16;
+
+bool decodeAllFrames(const std::string& path, std::vector<cv::Mat>& frames, std::vector<int>& delays)
+{
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 11)
+    cv::Animation animation;
+    try {
+        if (cv::imreadanimation(path, animation) && !animation.frames.empty()) {
+            frames = std::move(animation.frames);
+            delays = std::move(animation.durations);
+            delays.resize(frames.size(), kDefaultFrameDelayMs);
+            return true;
+        }
+    } catch (const cv::Exception& e) {
+        std::cerr << "Error: [loadAnimatedSticker] 动图解码失败: " << e.what() << std::endl;
+    }
+#endif
+    // 旧版 OpenCV 或非动图格式：按静态图读取
+    cv::Mat still = cv::imread(path, cv::IMREAD_UNCHANGED);
+    if (still.empty()) {
+        return false;
+    }
+    frames.assign(1, still);
+    delays.assign(1, 0);
+    return true;
+}
+}
+
+bool loadAnimatedSticker(const std::string& path, const cv::Size& maxSize,
+                         size_t memoryCap, AnimatedFrames& out)
+{
+    std::vector<cv::Mat> frames;
+    std::vector<int> delays;
+    if (!decodeAllFrames(path, frames, delays)) {
+        return false;
+    }
+
+    const cv::Size srcSize = frames.front().size();
+    const int channels = frames.front().channels();
+
+    // 1. 先等比缩小到显示区域以内
+    double scale = 1.0;
+    if (maxSize.width > 0 && maxSize.height > 0) {
+        scale = std::min({1.0,
+                          static_cast<double>(maxSize.width) / srcSize.width,
+                          static_cast<double>(maxSize.height) / srcSize.height});
+    }
+
+    // 2. 仍超出内存上限时继续缩小（面积与内存成正比，按平方根缩放）
+    auto bytesAt = [&](double s, size_t count) {
+        const size_t w = std::max(1, cvRound(srcSize.width * s));
+        const size_t h = std::max(1, cvRound(srcSize.height * s));
+        return w * h * static_cast<size_t>(channels) * count;
+    };
+    if (memoryCap > 0 && bytesAt(scale, frames.size()) > memoryCap) {
+        const double shrink = std::sqrt(static_cast<double>(memoryCap) / bytesAt(scale, frames.size()));
+        const double minScale = static_cast<double>(kMinStickerSide) / std::min(srcSize.width, srcSize.height);
+        scale = std::max(scale * shrink, std::min(minScale, scale));
+    }
+
+    // 3. 缩到最小尺寸后依然超限，则抽帧（合并被丢弃帧的时长，总时长不变）
+    size_t step = 1;
+    if (memoryCap > 0) {
+        while (frames.size() / step > 1 && bytesAt(scale, (frames.size() + step - 1) / step) > memoryCap) {
+            ++step;
+        }
+    }
+
+    out.frames.clear();
+    out.frameEndMs.clear();
+    out.durationMs = 0;
+    const cv::Size dstSize(std::max(1, cvRound(srcSize.width * scale)),
+                           std::max(1, cvRound(srcSize.height * scale)));
+    for (size_t i = 0; i < frames.size(); i += step) {
+        int delay = 0;
+        for (size_t j = i; j < std::min(i + step, frames.size()); ++j) {
+            delay += delays[j] < kMinFrameDelayMs ? kDefaultFrameDelayMs : delays[j];
+        }
+        cv::Mat frame;
+        if (dstSize != srcSize) {
+            cv::resize(frames[i], frame, dstSize, 0, 0, cv::INTER_AREA);
+        } else {
+            frame = frames[i];
+        }
+        out.frames.push_back(frame);
+        out.durationMs += delay;
+        out.frameEndMs.push_back(out.durationMs);
+    }
+    if (out.frames.size() == 1) {
+        out.durationMs = 0;
+    }
+    if (step > 1 || dstSize != srcSize) {
+        std::cout << "[loadAnimatedSticker] " << frames.size() << " 帧 " << srcSize
+                  << " -> " << out.frames.size() << " 帧 " << dstSize << std::endl;
+    }
+    return true;
+}
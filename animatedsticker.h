@@ -0,0 +1,30 @@
+#ifndef ANIMATEDSTICKER_H
+#define ANIMATEDSTICKER_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 预解码后的动图帧序列（GIF/APNG/WebP）
+ */
+struct AnimatedFrames {
+    std::vector<cv::Mat> frames;   // 已缩放到显示尺寸的原始帧（BGR/BGRA）
+    std::vector<int> frameEndMs;   // 每帧结束时刻（累计毫秒），用于按时间戳二分查找
+    int durationMs = 0;            // 一次循环的总时长
+
+    bool isAnimated() const { return frames.size() > 1 && durationMs > 0; }
+};
+
+/**
+ * @brief 一次性解码动图全部帧
+ * @param path 文件路径
+ * @param maxSize 显示区域尺寸，超出时等比缩小到该尺寸以内
+ * @param memoryCap 解码后帧数据的内存上限（字节），超出时继续缩小，必要时抽帧
+ * @param out 输出帧序列
+ * @return 是否成功（静态图也返回 true，仅含一帧）
+ */
+bool loadAnimatedSticker(const std::string& path, const cv::Size& maxSize,
+                         size_t memoryCap, AnimatedFrames& out);
+
+#endif // ANIMATEDSTICKER_H
@@ -1,20 +1,12 @@
 #include "audiorecorder.h"
-#include <QMediaPlayer>
-#include <QMediaRecorder>
-#include <QAudioBuffer>
+#include "mediaclock.h"
 #include <QAudioDevice>
-#include <QAudioInput>
-#include <QDir>
-#include <QFileDialog>
-#include <QImageCapture>
+#include <QAudioSource>
+#include <QIODevice>
 #include <QMediaDevices>
-#include <QMediaFormat>
-#include <QMediaRecorder>
-#include <QMimeType>
-#include <QStandardPaths>
-#include <QMessageBox>
 #include <QVBoxLayout>
 #include <QApplication>
+#include <QDebug>
 #if QT_CONFIG(permissions)
 #include <QPermission>
 #endif
@@ -39,9 +31,6 @@ void audioRecorder::init(){
 #endif
     micChoose = new QComboBox();
     infoLabel = new QLabel("选择麦克风：");
-    m_audioRecorder = new QMediaRecorder(this);
-    m_captureSession.setRecorder(m_audioRecorder);
-    m_captureSession.setAudioInput(new QAudioInput(this));
     // audio devices
     m_mediaDevices = new QMediaDevices(this);
     connect(m_mediaDevices, &QMediaDevices::audioInputsChanged, this,
@@ -63,28 +52,86 @@ void audioRecorder::initUI()
     layout->addWidget(infoLabel);
     layout->addWidget(micChoose);
 }
-void audioRecorder::toggleRecord(QString audioPath)
+QAudioDevice audioRecorder::selectedDevice() const
 {
-    audioPath += "tempAudio";
-    if (!m_audioRecorder) {
-        return;
+    const QAudioDevice device = boxValue(micChoose).value<QAudioDevice>();
+    return device.isNull() ? QMediaDevices::defaultAudioInput() : device;
+}
+QAudioFormat audioRecorder::captureFormat() const
+{
+    if (m_source) {
+        return m_format;
+    }
+    const QAudioDevice device = selectedDevice();
+    if (device.isNull()) {
+        return QAudioFormat();
+    }
+    // 优先沿用设备的原生采样率与声道数，只把样本格式固定为 16 位，避免系统层重采样
+    QAudioFormat format = device.preferredFormat();
+    format.setSampleFormat(QAudioFormat::Int16);
+    format.setChannelCount(qBound(1, format.channelCount(), 2));
+    if (device.isFormatSupported(format)) {
+        return format;
+    }
+    for (int rate : {48000, 44100}) {
+        for (int channels : {2, 1}) {
+            format.setSampleRate(rate);
+            format.setChannelCount(channels);
+            if (device.isFormatSupported(format)) {
+                return format;
+            }
+        }
     }
-    if (m_audioRecorder->recorderState() == QMediaRecorder::StoppedState) {
-        m_audioRecorder->setOutputLocation(QUrl::fromLocalFile(audioPath));
-        m_captureSession.audioInput()->setDevice(
-            boxValue(micChoose).value<QAudioDevice>());
-        m_audioRecorder->setMediaFormat(selectedMediaFormat());
-        m_audioRecorder->setAudioSampleRate(64000);
-        m_audioRecorder->setAudioBitRate(64000);
-        m_audioRecorder->setAudioChannelCount(-1);
-        m_audioRecorder->setQuality(QMediaRecorder::Quality(QImageCapture::NormalQuality));
-        m_audioRecorder->setEncodingMode(QMediaRecorder::ConstantQualityEncoding);
-        m_audioRecorder->record();
-        qDebug()<<"m_audioRecorder->error():"<<m_audioRecorder->error();
+    return QAudioFormat();
+}
+bool audioRecorder::start(PcmSink sink)
+{
+    stop();
+    m_format = captureFormat();
+    if (!m_format.isValid()) {
+        qDebug() << "没有可用的麦克风格式";
+        return false;
+    }
+    m_sink = std::move(sink);
+    m_source = new QAudioSource(selectedDevice(), m_format, this);
+    m_io = m_source->start();
+    if (!m_io) {
+        qDebug() << "麦克风打开失败：" << m_source->error();
+        stop();
+        return false;
+    }
+    connect(m_io, &QIODevice::readyRead, this, &audioRecorder::onReadyRead);
+    qDebug() << "录音已开始：" << m_format.sampleRate() << "Hz" << m_format.channelCount() << "声道";
+    return true;
+}
+void audioRecorder::stop()
+{
+    if (m_source) {
+        if (m_io) {
+            onReadyRead(); // 取走设备缓冲中剩余的数据
+        }
+        m_source->stop();
+        m_source->deleteLater();
+        m_source = nullptr;
     }
+    m_io = nullptr;
+    m_sink = nullptr;
+    m_pending.clear();
 }
-void audioRecorder::saveAudio(){
-    m_audioRecorder->stop();
+void audioRecorder::onReadyRead()
+{
+    m_pending += m_io->readAll();
+    // 读出后立即按与视频帧相同的单调时钟打时间戳
+    const int64_t arrivalUs = mediaClockUs();
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const int frames = bytesPerFrame > 0 ? static_cast<int>(m_pending.size() / bytesPerFrame) : 0;
+    if (frames <= 0) {
+        return;
+    }
+    if (m_sink) {
+        m_sink(reinterpret_cast<const int16_t*>(m_pending.constData()), frames, arrivalUs);
+    }
+    m_pending.remove(0, frames * bytesPerFrame);
 }
 void audioRecorder::updateDevices()
 {
@@ -105,24 +152,3 @@ void audioRecorder::updateDevices()
     }
     micChoose->setCurrentIndex(currentDeviceIndex);
 }
-void audioRecorder::onStateChanged(QMediaRecorder::RecorderState state)
-{
-    switch (state) {
-    case QMediaRecorder::RecordingState:
-        qDebug() << "录制已开始！";
-        break;
-    case QMediaRecorder::StoppedState:
-        qDebug() << "录制已停止";
-        break;
-    case QMediaRecorder::PausedState:
-        qDebug() << "录制已暂停";
-        break;
-    }
-}
-QMediaFormat audioRecorder::selectedMediaFormat() const
-{
-    QMediaFormat format;
-    format.setFileFormat(QMediaFormat::Mpeg4Audio);// always mp4a
-    format.setAudioCodec(QMediaFormat::AudioCodec::AAC);// always aac
-    return format;
-}
@@ -1,35 +1,56 @@
 #ifndef AUDIORECORDER_H
 #define AUDIORECORDER_H
-#include <QMediaCaptureSession>
-#include <QMediaRecorder>
-#include <QUrl>
+#include <QAudioFormat>
+#include <QByteArray>
 #include <QWidget>
 #include <QLabel>
 #include <QComboBox>
-#include <QProcess>
+#include <cstdint>
+#include <functional>
 QT_BEGIN_NAMESPACE
-class QAudioBuffer;
+class QAudioDevice;
+class QAudioSource;
+class QIODevice;
 class QMediaDevices;
 QT_END_NAMESPACE
 class audioRecorder: public QWidget
 {
      Q_OBJECT
 public:
+    /**
+     * @brief PCM 数据回调（交错 16 位，frames 为采样帧数，arrivalUs 为读出时刻的 mediaClockUs）
+     */
+    using PcmSink = std::function<void(const int16_t* samples, int frames, int64_t arrivalUs)>;
+
     explicit audioRecorder(QWidget *parent = nullptr);
-    void toggleRecord(QString audioPath);
-    void saveAudio();
+
+    /**
+     * @brief 采集格式（16 位 PCM）：采集中返回正在使用的格式，否则返回当前选择的麦克风将使用的格式；
+     *        没有可用麦克风时返回无效格式
+     */
+    QAudioFormat captureFormat() const;
+    bool isActive() const { return m_source != nullptr; }
+
+    /**
+     * @brief 开始采集，PCM 数据到达时在 GUI 线程调用 sink
+     * @return 麦克风打开失败时返回 false
+     */
+    bool start(PcmSink sink);
+    void stop();
 private:
     void init();
     void initUI();
     void updateDevices();
-    void onStateChanged(QMediaRecorder::RecorderState state);
-    QMediaFormat selectedMediaFormat() const;
-    QMediaCaptureSession m_captureSession;
-    QMediaRecorder *m_audioRecorder = nullptr;
+    void onReadyRead();
+    QAudioDevice selectedDevice() const;
+    QAudioSource *m_source = nullptr;
+    QIODevice *m_io = nullptr;
     QMediaDevices *m_mediaDevices = nullptr;
     QComboBox *micChoose;
     QLabel *infoLabel;
-    bool  m_updatingFormats = false;
+    QAudioFormat m_format;
+    QByteArray m_pending;
+    PcmSink m_sink;
 };
 
 #endif // AUDIORECORDER_H
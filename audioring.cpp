@@ -0,0 +1,58 @@
+#include "audioring.h"
+#include <algorithm>
+#include <cstring>
+
+AudioRing::AudioRing(int channels, int sampleRate, int capacityMs, int chunkFrames)
+    : channels(std::max(1, channels)), sampleRate(std::max(1, sampleRate)), chunkFrames(std::max(1, chunkFrames))
+{
+    const int64_t capacityFrames = static_cast<int64_t>(this->sampleRate) * std::max(1, capacityMs) / 1000;
+    const size_t count = static_cast<size_t>(std::max<int64_t>(2, (capacityFrames + this->chunkFrames - 1) / this->chunkFrames));
+    slots.resize(count);
+    for (Slot& slot : slots) {
+        slot.samples.resize(static_cast<size_t>(this->chunkFrames) * this->channels);
+    }
+}
+
+bool AudioRing::write(const int16_t* samples, int frames, int64_t arrivalUs)
+{
+    if (!samples || frames <= 0) {
+        return true;
+    }
+    const size_t needed = static_cast<size_t>((frames + chunkFrames - 1) / chunkFrames);
+    const size_t writeIndex = head.load(std::memory_order_relaxed);
+    const size_t readIndex = tail.load(std::memory_order_acquire);
+    if (slots.size() - (writeIndex - readIndex) < needed) {
+        dropped.fetch_add(static_cast<uint64_t>(frames), std::memory_order_relaxed);
+        return false;
+    }
+
+    int offset = 0;
+    for (size_t i = 0; i < needed; ++i) {
+        Slot& slot = slots[(writeIndex + i) % slots.size()];
+        const int count = std::min(chunkFrames, frames - offset);
+        std::memcpy(slot.samples.data(), samples + static_cast<size_t>(offset) * channels,
+                    static_cast<size_t>(count) * channels * sizeof(int16_t));
+        slot.frames = count;
+        offset += count;
+        // 之后还有 frames - offset 个样本，按采样率倒推本块最后一个样本的到达时间
+        slot.arrivalUs = arrivalUs - static_cast<int64_t>(frames - offset) * 1000000 / sampleRate;
+    }
+    head.store(writeIndex + needed, std::memory_order_release);
+    return true;
+}
+
+bool AudioRing::peek(Chunk& chunk) const
+{
+    const size_t readIndex = tail.load(std::memory_order_relaxed);
+    if (readIndex == head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const Slot& slot = slots[readIndex % slots.size()];
+    chunk = Chunk{slot.samples.data(), slot.frames, slot.arrivalUs};
+    return true;
+}
+
+void AudioRing::pop()
+{
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
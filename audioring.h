@@ -0,0 +1,61 @@
+#ifndef AUDIORING_H
+#define AUDIORING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 单生产者单消费者的无锁 PCM 环形缓冲
+ *
+ * 采集线程写入交错 16 位 PCM 及其到达时间（mediaClockUs），编码线程按块取出后编码。
+ * 数据按固定大小的块存放，较长的一段会拆成多块，每块的时间戳按采样率推算到块内最后一个样本。
+ * 缓冲满时丢弃整段新数据并计数，采集线程永不等待。
+ */
+class AudioRing {
+public:
+    struct Chunk {
+        const int16_t* samples;
+        int frames;
+        int64_t arrivalUs;      // 块内最后一个样本的到达时间
+    };
+
+    /**
+     * @param capacityMs 缓冲时长
+     * @param chunkFrames 每块最多容纳的采样帧数
+     */
+    AudioRing(int channels, int sampleRate, int capacityMs = 2000, int chunkFrames = 1024);
+
+    /**
+     * @brief 写入一段 PCM（仅生产者线程调用）
+     * @param arrivalUs 最后一个样本的到达时间
+     * @return 空间不足被丢弃时返回 false
+     */
+    bool write(const int16_t* samples, int frames, int64_t arrivalUs);
+
+    /**
+     * @brief 查看最早的一块（仅消费者线程调用），数据在 pop 之前有效
+     */
+    bool peek(Chunk& chunk) const;
+    void pop();
+
+    uint64_t droppedFrames() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::vector<int16_t> samples;
+        int frames = 0;
+        int64_t arrivalUs = 0;
+    };
+
+    int channels;
+    int sampleRate;
+    int chunkFrames;
+    std::vector<Slot> slots;
+    std::atomic<size_t> head{0};    // 已写入的块数（生产者）
+    std::atomic<size_t> tail{0};    // 已取出的块数（消费者）
+    std::atomic<uint64_t> dropped{0};
+};
+
+#endif // AUDIORING_H
@@ -0,0 +1,25 @@
+# 录制编码对比：各 H.264 预设与 MPEG-4 的编码帧率和文件大小
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+SOURCES += \
+    encodebench.cpp \
+    ../mediamuxer.cpp
+
+HEADERS += \
+    ../mediaclock.h \
+    ../mediamuxer.h
+
+INCLUDEPATH += $${PWD}/..
+
+win32 {
+    INCLUDEPATH += C:\Qt\opencv\forQt/install/include \
+        $${PWD}/../ffmpeg-master-latest-win64-gpl-shared/include
+    LIBS += C:\Qt\opencv\forQt/install/x64/mingw/lib/libopencv_*.a \
+        -L$${PWD}/../ffmpeg-master-latest-win64-gpl-shared/lib -lavformat -lavcodec -lavutil -lswscale -lswresample
+}
+unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv4 libavformat libavcodec libavutil libswscale libswresample
+}
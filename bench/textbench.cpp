@@ -0,0 +1,60 @@
+// 文字渲染基准：在 1280x720 帧上重复绘制标题，统计每帧耗时
+// 用法：textbench [字体名称] [迭代次数]
+#include "textrenderer.h"
+#ifdef _WIN32
+#include "puttext.h"
+#include <windows.h>
+#endif
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+const char* const kTitle = "我宣誓：忠于宪法 Constitution 2026";
+
+template <typename Fn>
+double measureMs(int iterations, Fn&& fn)
+{
+    cv::Mat frame(720, 1280, CV_8UC3, cv::Scalar(40, 80, 120));
+    fn(frame); // 预热（字体加载、字形栅格化）
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn(frame);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    const std::string fontName = argc > 1 ? argv[1] : "微软雅黑";
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 500;
+
+    for (int fontSize : {24, 40, 80}) {
+        const double ft = measureMs(iterations, [&](cv::Mat& frame) {
+            TextRenderer::instance().draw(frame, kTitle, cv::Point(10, 10),
+                                          cv::Scalar(255, 255, 255), fontSize, fontName);
+        });
+        std::printf("FreeType 图集   字号 %3d: %8.3f ms/帧\n", fontSize, ft);
+#ifdef _WIN32
+        // putTextZH 使用 ANSI 接口，需要本地编码
+        const int wlen = MultiByteToWideChar(CP_UTF8, 0, kTitle, -1, nullptr, 0);
+        std::wstring wide(wlen, L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, kTitle, -1, wide.data(), wlen);
+        const int alen = WideCharToMultiByte(CP_ACP, 0, wide.c_str(), -1, nullptr, 0, nullptr, nullptr);
+        std::string local(alen, '\0');
+        WideCharToMultiByte(CP_ACP, 0, wide.c_str(), -1, local.data(), alen, nullptr, nullptr);
+        const double gdi = measureMs(iterations, [&](cv::Mat& frame) {
+            putText::putTextZH(frame, local.c_str(), Point(10, 10), Scalar(255, 255, 255),
+                               fontSize, "微软雅黑");
+        });
+        std::printf("GDI putTextZH   字号 %3d: %8.3f ms/帧 (%.1fx)\n", fontSize, gdi, gdi / ft);
+#endif
+    }
+    return 0;
+}
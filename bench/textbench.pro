@@ -0,0 +1,29 @@
+# 文字渲染性能对比：FreeType 字形图集 vs 旧版 GDI putTextZH（仅 Windows）
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+SOURCES += \
+    textbench.cpp \
+    ../alphablend.cpp \
+    ../textrenderer.cpp
+
+HEADERS += \
+    ../alphablend.h \
+    ../textrenderer.h
+
+INCLUDEPATH += $${PWD}/..
+
+win32 {
+    SOURCES += ../puttext.cpp
+    HEADERS += ../puttext.h
+    INCLUDEPATH += C:\Qt\opencv\forQt/install/include \
+        $${PWD}/../freetype/include/freetype2
+    LIBS += C:\Qt\opencv\forQt/install/x64/mingw/lib/libopencv_*.a \
+        -L$${PWD}/../freetype/lib -lfreetype -lgdi32
+    DEFINES += UNICODE
+}
+unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv4 freetype2 fontconfig
+}
@@ -0,0 +1,271 @@
+#include "bgcamengine.h"
+#include "mediaclock.h"
+#include <iostream>
+
+BgCamEngine::BgCamEngine(std::shared_ptr<SegmentationService> service)
+    : service(service ? std::move(service) : std::make_shared<SegmentationService>())
+    , humanSeg(std::make_unique<HumanSeg>(this->service, 0.5f))
+{
+    humanSeg->setActive(false); // 开启背景替换且帧源打开后才参与凑 batch
+}
+
+BgCamEngine::~BgCamEngine()
+{
+    closeSource();
+    stopPictureInPicture();
+    stopVirtualCamera();
+    stopReplay();
+    stopRecording();
+    humanSeg->release();
+}
+
+void BgCamEngine::setSource(std::unique_ptr<FrameSource> source)
+{
+    closeSource();
+    frameSource = std::move(source);
+    humanSeg->setActive(replaceBackground && frameSource);
+}
+
+void BgCamEngine::closeSource()
+{
+    if (frameSource) {
+        frameSource->release();
+        frameSource.reset();
+    }
+    humanSeg->setActive(false);
+}
+
+void BgCamEngine::setBackgroundEnabled(bool enabled)
+{
+    replaceBackground = enabled;
+    humanSeg->setActive(enabled && frameSource);
+}
+
+bool BgCamEngine::startRecording(const std::string& path, const RecordingOptions& options,
+                                 const MuxerAudioFormat* audio, size_t queueCapacity,
+                                 QueueOverflowPolicy policy, std::string* error)
+{
+    stopRecording();
+    RecordingOptions effective = options;
+    applySourceClock(effective, audio);
+    auto encoder = std::make_unique<RecordingEncoder>(queueCapacity, policy);
+    if (!encoder->open(path, effective, audio)) {
+        if (error) {
+            *error = encoder->lastError();
+        }
+        return false;
+    }
+    recordingEncoder = std::move(encoder);
+    return true;
+}
+
+std::vector<std::string> BgCamEngine::stopRecording()
+{
+    if (!recordingEncoder) {
+        return {};
+    }
+    recordingEncoder->close();
+    std::vector<std::string> segments = recordingEncoder->segments();
+    recordingEncoder.reset();
+    return segments;
+}
+
+bool BgCamEngine::startReplay(const RecordingOptions& options, const MuxerAudioFormat* audio, double seconds,
+                              size_t memoryCap, std::string* error)
+{
+    stopReplay();
+    // 回放固定使用 H.264，只编码不写文件，数据包由缓冲区按时长和内存上限淘汰
+    RecordingOptions replayOptions = options;
+    replayOptions.codec = "h264";
+    replayOptions.segmentMinutes = 0;
+    applySourceClock(replayOptions, audio);
+    auto buffer = std::make_unique<ReplayBuffer>(seconds, memoryCap);
+    auto encoder = std::make_unique<RecordingEncoder>(REPLAY_QUEUE_CAPACITY, QueueOverflowPolicy::DropOldest);
+    ReplayBuffer* tap = buffer.get();
+    encoder->setPacketTap([tap](const AVPacket* packet, bool video) {
+        tap->push(packet, video);
+    });
+    if (!encoder->open(std::string(), replayOptions, audio)) {
+        if (error) {
+            *error = encoder->lastError();
+        }
+        return false;
+    }
+    buffer->setStreams(encoder->videoContext(), encoder->audioContext());
+    replayBuffer = std::move(buffer);
+    replayEncoder = std::move(encoder);
+    return true;
+}
+
+void BgCamEngine::stopReplay()
+{
+    if (!replayEncoder) {
+        return;
+    }
+    // 先停止编码器（不再回调），再释放缓冲区；已取出的快照持有数据包引用，不受影响
+    replayEncoder->close();
+    replayEncoder.reset();
+    replayBuffer.reset();
+}
+
+void BgCamEngine::applySourceClock(RecordingOptions& options, const MuxerAudioFormat*& audio) const
+{
+    // 不限速回放的时间戳跑在墙钟前面：视频以第一帧为零点，麦克风音频无法对齐，不录制
+    if (frameSource && !frameSource->wallClockTimestamps()) {
+        options.sourceClock = true;
+        audio = nullptr;
+    }
+}
+
+bool BgCamEngine::startVirtualCamera(const std::string& name, bool loopback)
+{
+    stopVirtualCamera();
+    if (!isSourceOpen()) {
+        return false;
+    }
+    auto camera = std::make_unique<VirtualCamera>();
+    if (!camera->open(frameSource->frameSize(), name, loopback)) {
+        return false;
+    }
+    vcam = std::move(camera);
+    return true;
+}
+
+void BgCamEngine::stopVirtualCamera()
+{
+    vcam.reset(); // 析构时通知读端写端已关闭
+}
+
+bool BgCamEngine::startPictureInPicture(int deviceIndex, const CaptureFormat& format,
+                                        const std::string& backgroundPath)
+{
+    stopPictureInPicture();
+    auto pipeline = std::make_unique<CameraPipeline>(service);
+    pipeline->setBackground(backgroundPath);
+    if (!pipeline->open(deviceIndex, format)) {
+        return false;
+    }
+    pipPipeline = std::move(pipeline);
+    return true;
+}
+
+void BgCamEngine::stopPictureInPicture()
+{
+    pipPipeline.reset();
+    pipFrame.release();
+}
+
+void BgCamEngine::pushAudio(const int16_t* samples, int frames, int64_t arrivalUs)
+{
+    if (recordingEncoder) {
+        recordingEncoder->pushAudio(samples, frames, arrivalUs);
+    }
+    if (replayEncoder) {
+        replayEncoder->pushAudio(samples, frames, arrivalUs);
+    }
+}
+
+bool BgCamEngine::processFrame(cv::Mat& output, int64_t& captureUs)
+{
+    // 帧源停止后信箱中可能还留有最后一帧，只要求帧源存在
+    if (!frameSource) {
+        return false;
+    }
+    // 从信箱取最新一帧（采集线程读出时已打上时间戳），处理期间到达的旧帧已被丢弃
+    cv::Mat frame;
+    if (!frameSource->takeLatest(frame, captureUs)) {
+        return false;
+    }
+
+    // YUV 直通时帧为 NV12：Y 平面与交错的 UV 平面分别水平镜像，全程不转 BGR
+    const bool nv12 = frameSource->nv12() && frame.type() == CV_8UC1;
+    if (mirror) {
+        if (nv12) {
+            const int height = frame.rows * 2 / 3;
+            cv::Mat yPlane = frame.rowRange(0, height);
+            cv::Mat uvPlane(height / 2, frame.cols / 2, CV_8UC2, frame.ptr<uchar>(height), frame.step);
+            cv::flip(yPlane, yPlane, 1);
+            cv::flip(uvPlane, uvPlane, 1);
+        } else {
+            cv::flip(frame, frame, 1);
+        }
+    }
+
+    output = frame;
+    if (replaceBackground) {
+        try {
+            output = nv12 ? humanSeg->segmentAndReplaceNV12(frame) : humanSeg->segmentAndReplace(frame);
+        } catch (const std::exception& e) {
+            output = frame;
+            std::cerr << "[BgCamEngine] 背景替换失败：" << e.what() << std::endl;
+        }
+    }
+
+    pastePictureInPicture(output, nv12);
+    // 所有叠加层（前景图、Logo、字幕底板等）统一由合成器按 z 顺序一次性叠加
+    const int64_t nowMs = mediaClockUs() / 1000;
+    if (nv12) {
+        compositor.compositeNV12(output, nowMs);
+    } else {
+        compositor.composite(output, nowMs);
+    }
+
+    // 以采集时间戳作为 PTS（可变帧率）；输出分辨率不同时由编码线程缩放
+    if (!output.empty() && (output.channels() == 3 || nv12)) {
+        if (recordingEncoder) {
+            recordingEncoder->push(output, captureUs);
+        }
+        if (replayEncoder) {
+            replayEncoder->push(output, captureUs);
+        }
+        if (vcam) {
+            vcam->publish(output, captureUs);
+        }
+    }
+    ++processed;
+    return true;
+}
+
+void BgCamEngine::pastePictureInPicture(cv::Mat& frame, bool nv12)
+{
+    if (!pipPipeline) {
+        return;
+    }
+    // 第二路没有新结果时沿用上一帧，两路帧率不同也不会闪烁
+    int64_t pipUs = 0;
+    pipPipeline->takeLatest(pipFrame, pipUs);
+    if (pipFrame.empty() || frame.empty()) {
+        return;
+    }
+    const int frameWidth = frame.cols;
+    const int frameHeight = nv12 ? frame.rows * 2 / 3 : frame.rows;
+    const int margin = 16;
+    // 右下角，宽度为画面的三分之一；NV12 下位置和尺寸取偶数，色度平面按 2x2 对齐
+    int pipWidth = frameWidth / 3;
+    int pipHeight = pipWidth * pipFrame.rows / pipFrame.cols;
+    if (nv12) {
+        pipWidth &= ~1;
+        pipHeight &= ~1;
+    }
+    if (pipWidth <= 0 || pipHeight <= 0 || pipHeight + margin > frameHeight) {
+        return;
+    }
+    const int x = (frameWidth - pipWidth - margin) & ~1;
+    const int y = (frameHeight - pipHeight - margin) & ~1;
+    cv::resize(pipFrame, pipScaled, cv::Size(pipWidth, pipHeight), 0, 0, cv::INTER_AREA);
+    if (!nv12) {
+        pipScaled.copyTo(frame(cv::Rect(x, y, pipWidth, pipHeight)));
+        return;
+    }
+    // NV12：小图转 I420 后写入 Y 平面，U/V 交错写入 UV 平面
+    cv::cvtColor(pipScaled, pipI420, cv::COLOR_BGR2YUV_I420);
+    pipI420.rowRange(0, pipHeight).copyTo(frame(cv::Rect(x, y, pipWidth, pipHeight)));
+    const int chromaWidth = pipWidth / 2;
+    const int chromaHeight = pipHeight / 2;
+    const cv::Mat u(chromaHeight, chromaWidth, CV_8UC1, pipI420.ptr<uchar>(pipHeight));
+    const cv::Mat v(chromaHeight, chromaWidth, CV_8UC1, pipI420.ptr<uchar>(pipHeight) + chromaWidth * chromaHeight);
+    const cv::Mat planes[] = {u, v};
+    cv::Mat uvPlane(frameHeight / 2, frameWidth / 2, CV_8UC2, frame.ptr<uchar>(frameHeight), frame.step);
+    cv::Mat uvRoi = uvPlane(cv::Rect(x / 2, y / 2, chromaWidth, chromaHeight));
+    cv::merge(planes, 2, uvRoi);
+}
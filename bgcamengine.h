@@ -0,0 +1,146 @@
+#ifndef BGCAMENGINE_H
+#define BGCAMENGINE_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HumanSeg.h"
+#include "camerapipeline.h"
+#include "framesource.h"
+#include "overlaycompositor.h"
+#include "recordingencoder.h"
+#include "replaybuffer.h"
+#include "segmentationservice.h"
+#include "virtualcamera.h"
+
+/**
+ * @brief 处理引擎：帧源 -> 镜像 -> 分割换背景 -> 画中画 -> 叠加层 -> 录制 / 即时回放 / 虚拟摄像头
+ *
+ * 不依赖 Qt，桌面界面和无界面的渲染节点都通过它驱动整条管线。调用方负责打开帧源、选择背景和配置叠加层，
+ * 收到帧源的新帧通知后在自己的线程中调用 processFrame，拿到合成结果用于显示；各输出端由引擎统一推送。
+ * 除帧源回调外，所有方法都应在同一个线程中调用。
+ */
+class BgCamEngine {
+public:
+    /**
+     * @brief 构造引擎
+     * @param service 推理服务，为空时引擎自己加载模型
+     * @throws std::runtime_error 模型加载失败
+     */
+    explicit BgCamEngine(std::shared_ptr<SegmentationService> service = nullptr);
+    ~BgCamEngine();
+    BgCamEngine(const BgCamEngine&) = delete;
+    BgCamEngine& operator=(const BgCamEngine&) = delete;
+
+    // ---------- 帧源 ----------
+    /**
+     * @brief 接管一个已打开的帧源（替换并释放之前的帧源）
+     */
+    void setSource(std::unique_ptr<FrameSource> source);
+    /**
+     * @brief 停止并释放帧源，录制等输出端不受影响
+     */
+    void closeSource();
+    FrameSource* source() const { return frameSource.get(); }
+    bool isSourceOpen() const { return frameSource && frameSource->isOpened(); }
+
+    // ---------- 分割与叠加 ----------
+    HumanSeg& segmentor() { return *humanSeg; }
+    OverlayCompositor& overlays() { return compositor; }
+    std::shared_ptr<SegmentationService> segmentationService() const { return service; }
+    /**
+     * @brief 是否做背景替换（背景由 segmentor().setBackground 设置）；关闭时不占用推理服务的 batch 名额
+     */
+    void setBackgroundEnabled(bool enabled);
+    bool backgroundEnabled() const { return replaceBackground; }
+    /**
+     * @brief 是否水平镜像（默认开启，与自拍预览一致）
+     */
+    void setMirror(bool enabled) { mirror = enabled; }
+
+    // ---------- 输出端 ----------
+    /**
+     * @brief 开始录制
+     * @param audio 音频格式，为空时只录视频；音频数据通过 pushAudio 送入
+     * @param error 失败原因
+     */
+    bool startRecording(const std::string& path, const RecordingOptions& options, const MuxerAudioFormat* audio,
+                        size_t queueCapacity, QueueOverflowPolicy policy, std::string* error);
+    /**
+     * @brief 编码完队列中剩余的帧并关闭文件
+     * @return 实际写出的文件（分段录制时为各分段）
+     */
+    std::vector<std::string> stopRecording();
+    bool isRecording() const { return recordingEncoder != nullptr; }
+    RecordingEncoder* recorder() const { return recordingEncoder.get(); }
+
+    /**
+     * @brief 开始即时回放：只编码不写文件，最近 seconds 秒的数据包保存在内存中
+     */
+    bool startReplay(const RecordingOptions& options, const MuxerAudioFormat* audio, double seconds,
+                     size_t memoryCap, std::string* error);
+    void stopReplay();
+    bool isReplayActive() const { return replayEncoder != nullptr; }
+    ReplayBuffer* replay() const { return replayBuffer.get(); }
+
+    /**
+     * @brief 把合成结果发布为虚拟摄像头（尺寸取当前帧源）
+     */
+    bool startVirtualCamera(const std::string& name = VCAM_DEFAULT_NAME, bool loopback = true);
+    void stopVirtualCamera();
+    VirtualCamera* virtualCamera() const { return vcam.get(); }
+
+    /**
+     * @brief 启动第二路摄像头，结果以画中画叠加在右下角
+     * @param backgroundPath 第二路的背景图片，为空时不替换背景
+     */
+    bool startPictureInPicture(int deviceIndex, const CaptureFormat& format, const std::string& backgroundPath);
+    void stopPictureInPicture();
+    CameraPipeline* pictureInPicture() const { return pipPipeline.get(); }
+
+    /**
+     * @brief 送入麦克风数据，转发给录制和即时回放的编码器
+     */
+    void pushAudio(const int16_t* samples, int frames, int64_t arrivalUs);
+
+    // ---------- 逐帧处理 ----------
+    /**
+     * @brief 取走帧源中的最新一帧并走完整条管线，结果同时推送给各输出端
+     * @param output 合成结果：BGR，帧源为 NV12 直通时为 NV12
+     * @param captureUs 该帧的采集时间戳（mediaClockUs）
+     * @return 没有新帧时返回 false
+     */
+    bool processFrame(cv::Mat& output, int64_t& captureUs);
+    /**
+     * @brief processFrame 输出的是否为 NV12
+     */
+    bool outputNv12() const { return frameSource && frameSource->nv12(); }
+    uint64_t processedFrames() const { return processed; }
+
+private:
+    void pastePictureInPicture(cv::Mat& frame, bool nv12);
+    void applySourceClock(RecordingOptions& options, const MuxerAudioFormat*& audio) const;
+
+    static constexpr size_t REPLAY_QUEUE_CAPACITY = 8; // 即时回放编码队列容量（帧）
+
+    std::shared_ptr<SegmentationService> service;
+    std::unique_ptr<HumanSeg> humanSeg;
+    std::unique_ptr<FrameSource> frameSource;
+    OverlayCompositor compositor;
+    bool replaceBackground = false;
+    bool mirror = true;
+    uint64_t processed = 0;
+
+    std::unique_ptr<RecordingEncoder> recordingEncoder;
+    std::unique_ptr<RecordingEncoder> replayEncoder;   // 即时回放专用编码器（只编码不写文件）
+    std::unique_ptr<ReplayBuffer> replayBuffer;
+    std::unique_ptr<VirtualCamera> vcam;
+    std::unique_ptr<CameraPipeline> pipPipeline;       // 第二路摄像头，与主摄像头共享推理服务
+    cv::Mat pipFrame;                                  // 第二路最近一次的处理结果
+    cv::Mat pipScaled;
+    cv::Mat pipI420;
+};
+
+#endif // BGCAMENGINE_H
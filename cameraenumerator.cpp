@@ -0,0 +1,282 @@
+#include "cameraenumerator.h"
+#include <QCameraDevice>
+#include <QCameraFormat>
+#include <QMap>
+#include <QMediaDevices>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVideoFrameFormat>
+#include <algorithm>
+#include <memory>
+
+#ifdef Q_OS_LINUX
+#include <QDir>
+#include <QFile>
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+QString modeText(const CameraMode &mode)
+{
+    return QString("%1 %2x%3@%4").arg(mode.fourcc).arg(mode.size.width()).arg(mode.size.height())
+        .arg(mode.maxFps, 0, 'f', 0);
+}
+
+#ifdef Q_OS_LINUX
+int xioctl(int fd, unsigned long request, void *arg)
+{
+    int ret;
+    do {
+        ret = ::ioctl(fd, request, arg);
+    } while (ret == -1 && errno == EINTR);
+    return ret;
+}
+
+QString fourccText(uint32_t code)
+{
+    QString text;
+    for (int i = 0; i < 4; ++i) {
+        const char c = static_cast<char>((code >> (8 * i)) & 0xFF);
+        if (c > ' ') {
+            text += QLatin1Char(c);
+        }
+    }
+    return text;
+}
+
+double intervalFps(const v4l2_fract &interval)
+{
+    return interval.numerator > 0 ? static_cast<double>(interval.denominator) / interval.numerator : 0.0;
+}
+
+QList<CameraMode> v4l2Modes(int fd)
+{
+    QList<CameraMode> modes;
+    v4l2_fmtdesc format{};
+    format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    for (format.index = 0; xioctl(fd, VIDIOC_ENUM_FMT, &format) == 0; ++format.index) {
+        const QString fourcc = fourccText(format.pixelformat);
+        v4l2_frmsizeenum size{};
+        size.pixel_format = format.pixelformat;
+        for (size.index = 0; xioctl(fd, VIDIOC_ENUM_FRAMESIZES, &size) == 0; ++size.index) {
+            if (size.type != V4L2_FRMSIZE_TYPE_DISCRETE) {
+                // 连续/步进尺寸只记录最大值
+                modes.append({QSize(static_cast<int>(size.stepwise.max_width), static_cast<int>(size.stepwise.max_height)),
+                              0.0, fourcc});
+                break;
+            }
+            CameraMode mode{QSize(static_cast<int>(size.discrete.width), static_cast<int>(size.discrete.height)), 0.0, fourcc};
+            v4l2_frmivalenum interval{};
+            interval.pixel_format = format.pixelformat;
+            interval.width = size.discrete.width;
+            interval.height = size.discrete.height;
+            for (interval.index = 0; xioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &interval) == 0; ++interval.index) {
+                if (interval.type != V4L2_FRMIVAL_TYPE_DISCRETE) {
+                    mode.maxFps = std::max(mode.maxFps, intervalFps(interval.stepwise.min));
+                    break;
+                }
+                mode.maxFps = std::max(mode.maxFps, intervalFps(interval.discrete));
+            }
+            modes.append(mode);
+        }
+    }
+    return modes;
+}
+
+QList<CameraInfo> enumerateV4l2()
+{
+    QList<CameraInfo> cameras;
+    const QStringList nodes = QDir("/dev").entryList({"video*"}, QDir::System);
+    for (const QString &node : nodes) {
+        bool ok = false;
+        const int index = node.mid(5).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        // 非阻塞只读打开：只发能力查询 ioctl，不申请缓冲也不开流，设备被其他程序占用时同样可查询
+        const int fd = ::open(QFile::encodeName("/dev/" + node).constData(), O_RDONLY | O_NONBLOCK);
+        if (fd < 0) {
+            continue;
+        }
+        v4l2_capability cap{};
+        if (xioctl(fd, VIDIOC_QUERYCAP, &cap) == 0) {
+            const uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+            // UVC 摄像头每个设备另有一个元数据节点，只保留能采集视频的节点
+            if (caps & V4L2_CAP_VIDEO_CAPTURE) {
+                CameraInfo info;
+                info.index = index;
+                info.id = QString::fromUtf8(reinterpret_cast<const char *>(cap.bus_info));
+                info.name = QString::fromUtf8(reinterpret_cast<const char *>(cap.card));
+                info.modes = v4l2Modes(fd);
+                cameras.append(info);
+            }
+        }
+        ::close(fd);
+    }
+    std::sort(cameras.begin(), cameras.end(), [](const CameraInfo &a, const CameraInfo &b) {
+        return a.index < b.index;
+    });
+    return cameras;
+}
+#else
+QString pixelFormatText(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrameFormat::Format_Jpeg:
+        return "MJPG";
+    case QVideoFrameFormat::Format_YUYV:
+        return "YUYV";
+    case QVideoFrameFormat::Format_NV12:
+        return "NV12";
+    default:
+        return QVideoFrameFormat::pixelFormatToString(format);
+    }
+}
+#endif
+}
+
+QString CameraInfo::modeSummary() const
+{
+    QMap<QString, QStringList> byFormat;
+    for (const CameraMode &mode : modes) {
+        byFormat[mode.fourcc].append(QString("%1x%2@%3").arg(mode.size.width()).arg(mode.size.height())
+                                         .arg(mode.maxFps, 0, 'f', 0));
+    }
+    QStringList lines;
+    for (auto it = byFormat.cbegin(); it != byFormat.cend(); ++it) {
+        lines.append(it.key() + "：" + it.value().join(", "));
+    }
+    return lines.join('\n');
+}
+
+CameraEnumerator::CameraEnumerator(QObject *parent)
+    : QObject(parent)
+{
+    // 插拔时系统往往连续发出多次变化通知，合并后只枚举一次
+    debounce = new QTimer(this);
+    debounce->setSingleShot(true);
+    debounce->setInterval(300);
+    connect(debounce, &QTimer::timeout, this, &CameraEnumerator::refresh);
+    mediaDevices = new QMediaDevices(this);
+    connect(mediaDevices, &QMediaDevices::videoInputsChanged, debounce, qOverload<>(&QTimer::start));
+}
+
+CameraEnumerator::~CameraEnumerator()
+{
+    if (worker) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+QList<CameraInfo> CameraEnumerator::cachedCameras()
+{
+    QList<CameraInfo> cameras;
+    QSettings settings("BgCam", "BgCam");
+    const int count = settings.beginReadArray("cameras");
+    static const QRegularExpression modePattern("^(\\S+) (\\d+)x(\\d+)@(\\d+)$");
+    for (int i = 0; i < count; ++i) {
+        settings.setArrayIndex(i);
+        CameraInfo info;
+        info.index = settings.value("index", -1).toInt();
+        info.id = settings.value("id").toString();
+        info.name = settings.value("name").toString();
+        for (const QString &text : settings.value("modes").toStringList()) {
+            const QRegularExpressionMatch match = modePattern.match(text);
+            if (match.hasMatch()) {
+                info.modes.append({QSize(match.captured(2).toInt(), match.captured(3).toInt()),
+                                   match.captured(4).toDouble(), match.captured(1)});
+            }
+        }
+        if (info.index >= 0) {
+            cameras.append(info);
+        }
+    }
+    settings.endArray();
+    return cameras;
+}
+
+void CameraEnumerator::saveCache(const QList<CameraInfo> &cameras)
+{
+    QSettings settings("BgCam", "BgCam");
+    settings.remove("cameras");
+    settings.beginWriteArray("cameras", static_cast<int>(cameras.size()));
+    for (int i = 0; i < cameras.size(); ++i) {
+        const CameraInfo &info = cameras[i];
+        settings.setArrayIndex(i);
+        settings.setValue("index", info.index);
+        settings.setValue("id", info.id);
+        settings.setValue("name", info.name);
+        QStringList modes;
+        for (const CameraMode &mode : info.modes) {
+            modes.append(modeText(mode));
+        }
+        settings.setValue("modes", modes);
+    }
+    settings.endArray();
+}
+
+QList<CameraInfo> CameraEnumerator::enumerate()
+{
+#ifdef Q_OS_LINUX
+    return enumerateV4l2();
+#else
+    // 设备表由系统维护，查询不会打开视频流；序号与 OpenCV 默认后端的枚举顺序一致
+    QList<CameraInfo> cameras;
+    const QList<QCameraDevice> devices = QMediaDevices::videoInputs();
+    for (int i = 0; i < devices.size(); ++i) {
+        CameraInfo info;
+        info.index = i;
+        info.id = QString::fromUtf8(devices[i].id());
+        info.name = devices[i].description();
+        for (const QCameraFormat &format : devices[i].videoFormats()) {
+            info.modes.append({format.resolution(), format.maxFrameRate(), pixelFormatText(format.pixelFormat())});
+        }
+        cameras.append(info);
+    }
+    return cameras;
+#endif
+}
+
+void CameraEnumerator::refresh()
+{
+    if (worker) {
+        refreshPending = true;
+        return;
+    }
+#ifdef Q_OS_LINUX
+    auto result = std::make_shared<QList<CameraInfo>>();
+    worker = QThread::create([result]() {
+        *result = enumerate();
+    });
+    connect(worker, &QThread::finished, this, [this, result]() {
+        worker->deleteLater();
+        worker = nullptr;
+        finish(*result);
+        if (refreshPending) {
+            refreshPending = false;
+            refresh();
+        }
+    });
+    worker->start();
+#else
+    // QMediaDevices 需要在 GUI 线程访问；推迟到事件循环中执行，调用方不会被阻塞
+    QTimer::singleShot(0, this, [this]() {
+        finish(enumerate());
+    });
+#endif
+}
+
+void CameraEnumerator::finish(const QList<CameraInfo> &cameras)
+{
+    current = cameras;
+    saveCache(cameras);
+    emit camerasChanged(cameras);
+}
@@ -0,0 +1,83 @@
+#ifndef CAMERAENUMERATOR_H
+#define CAMERAENUMERATOR_H
+
+#include <QList>
+#include <QObject>
+#include <QSize>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QMediaDevices;
+class QThread;
+class QTimer;
+QT_END_NAMESPACE
+
+/**
+ * @brief 摄像头支持的一种采集模式
+ */
+struct CameraMode {
+    QSize size;
+    double maxFps = 0.0;        // 0 表示驱动未给出帧率
+    QString fourcc;             // "MJPG" / "YUYV" / "NV12" ...
+};
+
+/**
+ * @brief 一个可用的摄像头
+ */
+struct CameraInfo {
+    int index = -1;             // 传给 cv::VideoCapture 的设备序号
+    QString id;                 // 稳定标识（Linux 为总线地址），刷新列表后据此保持选择
+    QString name;
+    QList<CameraMode> modes;
+
+    /**
+     * @brief 按像素格式分组的模式列表，用作下拉框提示
+     */
+    QString modeSummary() const;
+};
+
+/**
+ * @brief 异步摄像头枚举
+ *
+ * 只查询设备能力而不打开视频流：Linux 下直接遍历 /dev/video* 并用 V4L2 ioctl 读取名称和格式，
+ * 在后台线程完成；其他平台使用 QMediaDevices 的设备表。结果写入 QSettings，下次启动时先显示缓存，
+ * 后台枚举完成后再更新。设备插拔由 QMediaDevices::videoInputsChanged 触发重新枚举。
+ */
+class CameraEnumerator : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CameraEnumerator(QObject *parent = nullptr);
+    ~CameraEnumerator() override;
+
+    /**
+     * @brief 上次运行时缓存的摄像头列表（没有缓存时为空）
+     */
+    static QList<CameraInfo> cachedCameras();
+
+    /**
+     * @brief 开始一次后台枚举；已有枚举在进行时，结束后再补一次
+     */
+    void refresh();
+
+    QList<CameraInfo> cameras() const { return current; }
+
+signals:
+    /**
+     * @brief 枚举完成（在 GUI 线程发出）
+     */
+    void camerasChanged(const QList<CameraInfo> &cameras);
+
+private:
+    static QList<CameraInfo> enumerate();
+    static void saveCache(const QList<CameraInfo> &cameras);
+    void finish(const QList<CameraInfo> &cameras);
+
+    QMediaDevices *mediaDevices = nullptr;
+    QTimer *debounce = nullptr;
+    QThread *worker = nullptr;
+    bool refreshPending = false;
+    QList<CameraInfo> current;
+};
+
+#endif // CAMERAENUMERATOR_H
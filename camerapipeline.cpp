@@ -0,0 +1,144 @@
+#include "camerapipeline.h"
+#include "HumanSeg.h"
+#include "capturethread.h"
+#include <iostream>
+
+CameraPipeline::CameraPipeline(std::shared_ptr<SegmentationService> service)
+    : service(std::move(service))
+{
+}
+
+CameraPipeline::~CameraPipeline()
+{
+    stop();
+}
+
+bool CameraPipeline::open(int deviceIndex, const CaptureFormat& format)
+{
+    stop();
+    CaptureFormat requested = format;
+    requested.keepNv12 = false;
+    auto capture = std::make_unique<CaptureThread>();
+    capture->setFrameCallback([this]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            framePending = true;
+        }
+        frameArrived.notify_one();
+    });
+    if (!capture->open(deviceIndex, requested)) {
+        return false;
+    }
+    try {
+        segmentor = std::make_unique<HumanSeg>(service, 0.5f);
+        segmentor->setActive(false); // 设置了背景才参与凑 batch
+    } catch (const std::exception& e) {
+        std::cerr << "[CameraPipeline] " << e.what() << std::endl;
+        return false;
+    }
+    source = std::move(capture);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        framePending = false;
+        hasOutput = false;
+        backgroundDirty = !backgroundPath.empty();
+    }
+    processed = 0;
+    running = true;
+    worker = std::thread(&CameraPipeline::run, this);
+    return true;
+}
+
+void CameraPipeline::stop()
+{
+    if (worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        frameArrived.notify_all();
+        worker.join();
+    }
+    running = false;
+    if (source) {
+        source->release();
+        source.reset();
+    }
+    // 销毁 HumanSeg 时注销推理服务的使用者
+    segmentor.reset();
+}
+
+void CameraPipeline::setBackground(const std::string& imagePath)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    backgroundPath = imagePath;
+    backgroundDirty = true;
+}
+
+bool CameraPipeline::takeLatest(cv::Mat& frame, int64_t& captureUs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasOutput) {
+        return false;
+    }
+    frame = std::move(output);
+    captureUs = outputUs;
+    hasOutput = false;
+    return true;
+}
+
+void CameraPipeline::run()
+{
+    bool replaceBackground = false;
+    cv::Mat frame;
+    int64_t captureUs = 0;
+    for (;;) {
+        std::string background;
+        bool backgroundChanged = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameArrived.wait(lock, [this] { return framePending || !running; });
+            if (!running) {
+                break;
+            }
+            framePending = false;
+            if (backgroundDirty) {
+                background = backgroundPath;
+                backgroundChanged = true;
+                backgroundDirty = false;
+            }
+        }
+        // 背景只在处理线程中切换，HumanSeg 不需要额外加锁
+        if (backgroundChanged) {
+            replaceBackground = false;
+            if (!background.empty()) {
+                try {
+                    segmentor->setBackground(background, "image");
+                    replaceBackground = true;
+                } catch (const std::exception& e) {
+                    std::cerr << "[CameraPipeline] " << e.what() << std::endl;
+                }
+            }
+            segmentor->setActive(replaceBackground);
+        }
+        if (!source->takeLatest(frame, captureUs)) {
+            continue;
+        }
+        cv::flip(frame, frame, 1);
+        cv::Mat result = frame;
+        if (replaceBackground) {
+            try {
+                result = segmentor->segmentAndReplace(frame);
+            } catch (const std::exception& e) {
+                std::cerr << "[CameraPipeline] 背景替换失败：" << e.what() << std::endl;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            output = result;
+            outputUs = captureUs;
+            hasOutput = true;
+        }
+        ++processed;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef CAMERAPIPELINE_H
+#define CAMERAPIPELINE_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "framesource.h"
+#include "segmentationservice.h"
+
+class HumanSeg;
+
+/**
+ * @brief 一路附加摄像头的处理管线：采集 -> 镜像 -> 分割换背景，结果放入单槽信箱
+ *
+ * 每路管线有自己的采集线程、处理线程和 HumanSeg（预处理、背景、掩码缓冲各自独立），
+ * 只有模型推理交给共享的 SegmentationService，与主摄像头的请求合并成一个 batch。
+ * 管线运行期间才登记为推理服务的使用者，停止后主摄像头恢复单路直接推理。
+ */
+class CameraPipeline {
+public:
+    explicit CameraPipeline(std::shared_ptr<SegmentationService> service);
+    ~CameraPipeline();
+    CameraPipeline(const CameraPipeline&) = delete;
+    CameraPipeline& operator=(const CameraPipeline&) = delete;
+
+    /**
+     * @brief 打开摄像头并启动处理线程
+     * @param deviceIndex 摄像头序号
+     * @param format 采集格式（NV12 直通不适用，始终按 BGR 处理）
+     */
+    bool open(int deviceIndex, const CaptureFormat& format = CaptureFormat());
+
+    /**
+     * @brief 停止处理线程并关闭摄像头（可重复调用）
+     */
+    void stop();
+
+    bool isRunning() const { return running; }
+
+    /**
+     * @brief 设置背景图片，路径为空时不做背景替换；在处理线程中生效
+     */
+    void setBackground(const std::string& imagePath);
+
+    /**
+     * @brief 取走最新的处理结果（BGR）
+     * @return 上次取走之后没有新结果时返回 false
+     */
+    bool takeLatest(cv::Mat& frame, int64_t& captureUs);
+
+    uint64_t processedFrames() const { return processed; }
+
+private:
+    void run();
+
+    std::shared_ptr<SegmentationService> service;
+    std::unique_ptr<FrameSource> source;
+    std::unique_ptr<HumanSeg> segmentor;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> processed{0};
+
+    std::mutex mutex;           // 保护以下成员
+    std::condition_variable frameArrived;
+    bool framePending = false;
+    std::string backgroundPath;
+    bool backgroundDirty = false;
+    cv::Mat output;
+    int64_t outputUs = 0;
+    bool hasOutput = false;
+};
+
+#endif // CAMERAPIPELINE_H
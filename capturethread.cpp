@@ -0,0 +1,115 @@
+#include "capturethread.h"
+#include "mediaclock.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace {
+std::string fourccToString(double value)
+{
+    const int code = static_cast<int>(value);
+    std::string text;
+    for (int i = 0; i < 4; ++i) {
+        const char c = static_cast<char>((code >> (8 * i)) & 0xFF);
+        if (c > ' ') {
+            text += c;
+        }
+    }
+    return text;
+}
+
+int decodeThreadCount()
+{
+    // 1080p MJPEG 单线程解码约 8–12 ms，两到四个线程足以跑满 30/60 fps，其余核心留给人像分割
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(cores / 4, 2, 4);
+}
+}
+
+CaptureThread::~CaptureThread()
+{
+    release();
+}
+
+bool CaptureThread::open(int deviceIndex, const CaptureFormat& requested)
+{
+    release();
+    if (!capture.open(deviceIndex) || !capture.isOpened()) {
+        return false;
+    }
+    // 先设像素格式再设分辨率和帧率：很多 UVC 摄像头只有 MJPEG 才提供高分辨率下的高帧率
+    if (requested.fourcc.size() == 4) {
+        const std::string& f = requested.fourcc;
+        capture.set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc(f[0], f[1], f[2], f[3]));
+    }
+    if (requested.size.width > 0 && requested.size.height > 0) {
+        capture.set(cv::CAP_PROP_FRAME_WIDTH, requested.size.width);
+        capture.set(cv::CAP_PROP_FRAME_HEIGHT, requested.size.height);
+    }
+    if (requested.fps > 0) {
+        capture.set(cv::CAP_PROP_FPS, requested.fps);
+    }
+
+    format.size = cv::Size(static_cast<int>(capture.get(cv::CAP_PROP_FRAME_WIDTH)),
+                           static_cast<int>(capture.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    format.fps = capture.get(cv::CAP_PROP_FPS);
+    format.fourcc = fourccToString(capture.get(cv::CAP_PROP_FOURCC));
+
+    // MJPEG 时让驱动直接交出压缩数据，后端不支持时仍会返回解码后的 BGR，run() 中按形状区分
+    rawMjpeg = format.fourcc == "MJPG" && capture.set(cv::CAP_PROP_CONVERT_RGB, 0);
+    if (rawMjpeg) {
+        decoder = std::make_unique<JpegDecodePool>(decodeThreadCount(),
+            [this](cv::Mat bgr, int64_t captureUs, uint64_t sequence) {
+                publish(std::move(bgr), captureUs, sequence);
+            });
+    }
+    // NV12 直通同样关闭后端转换；宽高必须为偶数，否则 UV 平面无法与 Y 平面对齐
+    rawNv12 = !rawMjpeg && requested.keepNv12 && format.fourcc == "NV12"
+              && format.size.width % 2 == 0 && format.size.height % 2 == 0
+              && capture.set(cv::CAP_PROP_CONVERT_RGB, 0);
+    std::cout << "[CaptureThread] " << format.size.width << "x" << format.size.height << " @" << format.fps
+              << " " << format.fourcc << (rawMjpeg ? "（多线程解码）" : rawNv12 ? "（YUV 直通）" : "") << std::endl;
+
+    start();
+    return true;
+}
+
+void CaptureThread::release()
+{
+    FrameSource::release();
+    decoder.reset(); // 等待解码线程结束，之后不会再有回调
+    if (capture.isOpened()) {
+        capture.release();
+    }
+    rawMjpeg = false;
+    rawNv12 = false;
+}
+
+void CaptureThread::run()
+{
+    while (running) {
+        // 每次读入新的 Mat：上一帧可能仍被处理线程或编码队列引用，不能原地覆盖
+        cv::Mat frame;
+        if (!capture.read(frame) || frame.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        const int64_t captureUs = mediaClockUs();
+        ++captured;
+        const uint64_t sequence = ++nextSequence;
+        if (decoder && frame.rows == 1 && frame.type() == CV_8UC1) {
+            decoder->submit(std::move(frame), captureUs, sequence); // 压缩数据（1xN）
+        } else if (rawNv12) {
+            // 各后端交出的原始缓冲形状不一（1xN 或 (h*3/2)xw），按字节数核对后统一成 (h*3/2)xw
+            const size_t bytes = static_cast<size_t>(format.size.width) * format.size.height * 3 / 2;
+            if (!frame.isContinuous() || frame.total() * frame.elemSize() != bytes) {
+                ++dropped;
+                continue;
+            }
+            publish(frame.reshape(1, format.size.height * 3 / 2), captureUs, sequence);
+        } else {
+            publish(std::move(frame), captureUs, sequence);
+        }
+    }
+}
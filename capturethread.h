@@ -0,0 +1,49 @@
+#ifndef CAPTURETHREAD_H
+#define CAPTURETHREAD_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include "framesource.h"
+#include "jpegdecodepool.h"
+
+/**
+ * @brief 摄像头帧源：独立采集线程 + 单槽信箱
+ *
+ * 采集线程按设备自身的帧率连续读取，每帧读出后立即打上 mediaClockUs 时间戳并放入信箱；
+ * 信箱只保存最新一帧，处理线程来不及取走的旧帧直接丢弃并计数，处理总是从最新的画面开始，
+ * GUI 线程也不再阻塞在驱动读帧上。
+ *
+ * 打开时显式协商分辨率、帧率和像素格式。MJPEG 格式下驱动只交出压缩数据，由 JpegDecodePool 并行解码，
+ * 解码完成顺序不固定，比信箱中已有帧更旧的解码结果直接丢弃。
+ * NV12 格式且 keepNv12 时跳过后端的颜色转换，帧以 NV12 交给处理线程（YUV 直通）。
+ */
+class CaptureThread : public FrameSource {
+public:
+    CaptureThread() = default;
+    ~CaptureThread() override;
+
+    /**
+     * @brief 打开摄像头、协商采集格式并启动采集线程
+     * @param requested 期望的格式，驱动不支持时会退回最接近的格式，实际结果见 negotiated()
+     */
+    bool open(int deviceIndex, const CaptureFormat& requested = CaptureFormat());
+
+    /**
+     * @brief 停止采集线程并关闭设备（可重复调用）
+     */
+    void release() override;
+
+    bool nv12() const override { return rawNv12; }
+    uint64_t droppedFrames() const override { return dropped + (decoder ? decoder->droppedFrames() : 0); }
+
+private:
+    void run() override;
+
+    cv::VideoCapture capture;
+    bool rawMjpeg = false;      // 驱动交出未解码的 MJPEG 数据
+    bool rawNv12 = false;       // 驱动交出未转换的 NV12 数据
+    std::unique_ptr<JpegDecodePool> decoder;
+};
+
+#endif // CAPTURETHREAD_H
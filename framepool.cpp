@@ -0,0 +1,114 @@
+#include "framepool.h"
+
+FramePool& FramePool::instance()
+{
+    static FramePool pool;
+    return pool;
+}
+
+void FramePool::install()
+{
+    cv::Mat::setDefaultAllocator(this);
+}
+
+void FramePool::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& bucket : freeLists) {
+        for (void* buffer : bucket.second) {
+            cv::fastFree(buffer);
+        }
+    }
+    freeLists.clear();
+    counters.cachedBytes = 0;
+}
+
+void FramePool::setCapacity(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = bytes;
+}
+
+FramePoolStats FramePool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+cv::UMatData* FramePool::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                  cv::AccessFlag, cv::UMatUsageFlags) const
+{
+    // 步长计算与 OpenCV 默认分配器一致
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    cv::UMatData* u = new cv::UMatData(this);
+    u->size = total;
+    if (data) {
+        // 外部内存只包装不归池
+        u->data = u->origdata = static_cast<uchar*>(data);
+        u->flags |= cv::UMatData::USER_ALLOCATED;
+        return u;
+    }
+
+    void* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = freeLists.find(total);
+        if (it != freeLists.end() && !it->second.empty()) {
+            buffer = it->second.back();
+            it->second.pop_back();
+            counters.cachedBytes -= total;
+            ++counters.reuses;
+        } else {
+            ++counters.allocations;
+        }
+        counters.liveBytes += total;
+    }
+    if (!buffer) {
+        buffer = cv::fastMalloc(total);
+    }
+    u->data = u->origdata = static_cast<uchar*>(buffer);
+    return u;
+}
+
+bool FramePool::allocate(cv::UMatData* data, cv::AccessFlag, cv::UMatUsageFlags) const
+{
+    return data != nullptr;
+}
+
+void FramePool::deallocate(cv::UMatData* u) const
+{
+    if (!u) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED) && u->origdata) {
+        bool cached = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            counters.liveBytes -= u->size;
+            if (counters.cachedBytes + u->size <= capacity) {
+                freeLists[u->size].push_back(u->origdata);
+                counters.cachedBytes += u->size;
+                cached = true;
+            }
+        }
+        if (!cached) {
+            cv::fastFree(u->origdata);
+        }
+        u->origdata = nullptr;
+    }
+    delete u;
+}
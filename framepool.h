@@ -0,0 +1,64 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 帧缓冲池统计
+ */
+struct FramePoolStats {
+    uint64_t allocations = 0;   // 实际向系统申请内存的次数（池中没有同尺寸空闲缓冲）
+    uint64_t reuses = 0;        // 直接复用空闲缓冲的次数
+    size_t liveBytes = 0;       // 正在被 cv::Mat 引用的缓冲字节数
+    size_t cachedBytes = 0;     // 池中空闲缓冲字节数
+};
+
+/**
+ * @brief 帧缓冲池：作为 cv::Mat 的默认分配器
+ *
+ * cv::Mat 本身就是引用计数句柄，最后一个引用释放时缓冲按字节数归还到池中，
+ * 下一帧同尺寸的临时图像（分割、叠加、录制、显示）直接取回，稳定运行时不再向系统申请内存。
+ * 分辨率变化后调用 trim 释放旧尺寸的空闲缓冲；空闲缓冲超出上限时直接释放。
+ * 可在任意线程使用。
+ */
+class FramePool : public cv::MatAllocator {
+public:
+    static FramePool& instance();
+
+    /**
+     * @brief 设为 cv::Mat 的默认分配器，需在创建任何图像之前调用一次
+     */
+    void install();
+
+    /**
+     * @brief 释放所有空闲缓冲
+     */
+    void trim();
+
+    /**
+     * @brief 设置空闲缓冲的总字节上限
+     */
+    void setCapacity(size_t bytes);
+
+    FramePoolStats stats() const;
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    FramePool() = default;
+
+    mutable std::mutex mutex;
+    mutable std::unordered_map<size_t, std::vector<void*>> freeLists; // 按字节数分桶
+    mutable FramePoolStats counters;
+    size_t capacity = 256 * 1024 * 1024;
+};
+
+#endif // FRAMEPOOL_H
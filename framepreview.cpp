@@ -0,0 +1,141 @@
+#include "framepreview.h"
+#include <QPainter>
+#include <QScreen>
+#include <QWindow>
+#include <algorithm>
+
+FramePreviewWidget::FramePreviewWidget(QWidget *parent)
+    : QWidget(parent)
+    , renderTimer(new QTimer(this))
+{
+    // 每次绘制都会覆盖整个控件，跳过背景擦除
+    setAttribute(Qt::WA_OpaquePaintEvent, true);
+    renderTimer->setSingleShot(true);
+    renderTimer->setTimerType(Qt::PreciseTimer);
+    connect(renderTimer, &QTimer::timeout, this, &FramePreviewWidget::renderPending);
+}
+
+bool FramePreviewWidget::isShowing() const
+{
+    if (!isVisible() || window()->isMinimized()) {
+        return false;
+    }
+    const QWindow *handle = window()->windowHandle();
+    return !handle || handle->isExposed();
+}
+
+int FramePreviewWidget::refreshIntervalMs() const
+{
+    const QScreen *current = screen();
+    const qreal rate = current ? current->refreshRate() : 60.0;
+    return std::max(1, qRound(1000.0 / (rate > 1.0 ? rate : 60.0)));
+}
+
+cv::Size FramePreviewWidget::fitSize(cv::Size frameSize, bool even) const
+{
+    const qreal ratio = devicePixelRatioF();
+    const int maxWidth = std::max(1, qRound(width() * ratio));
+    const int maxHeight = std::max(1, qRound(height() * ratio));
+    int targetWidth = maxWidth;
+    int targetHeight = static_cast<int>(static_cast<int64_t>(frameSize.height) * maxWidth / frameSize.width);
+    if (targetHeight > maxHeight) {
+        targetHeight = maxHeight;
+        targetWidth = static_cast<int>(static_cast<int64_t>(frameSize.width) * maxHeight / frameSize.height);
+    }
+    if (even) {
+        targetWidth &= ~1;
+        targetHeight &= ~1;
+    }
+    return cv::Size(std::max(targetWidth, even ? 2 : 1), std::max(targetHeight, even ? 2 : 1));
+}
+
+void FramePreviewWidget::setFrame(const cv::Mat &frame, bool nv12)
+{
+    if (frame.empty()) {
+        return;
+    }
+    if (!isShowing()) {
+        pending.release();
+        renderTimer->stop();
+        ++skipped;
+        return;
+    }
+    if (!pending.empty()) {
+        ++skipped; // 上一帧还没来得及绘制就被新帧替换
+    }
+    pending = frame;
+    pendingNv12 = nv12;
+    if (renderTimer->isActive()) {
+        return;
+    }
+    const int interval = refreshIntervalMs();
+    const qint64 elapsed = lastRender.isValid() ? lastRender.elapsed() : interval;
+    if (elapsed >= interval) {
+        renderPending();
+    } else {
+        renderTimer->start(static_cast<int>(interval - elapsed));
+    }
+}
+
+void FramePreviewWidget::renderPending()
+{
+    if (pending.empty() || !isShowing()) {
+        pending.release();
+        return;
+    }
+    const cv::Mat frame = pending;
+    const bool nv12 = pendingNv12;
+    pending.release();
+    lastRender.start();
+    ++rendered;
+    const cv::Size frameSize(frame.cols, nv12 ? frame.rows * 2 / 3 : frame.rows);
+    const cv::Size target = fitSize(frameSize, nv12);
+    // 缩小用 INTER_AREA 避免锯齿，放大用双线性
+    const int interpolation = target.width < frameSize.width ? cv::INTER_AREA : cv::INTER_LINEAR;
+    if (nv12) {
+        const cv::Mat yPlane = frame.rowRange(0, frameSize.height);
+        const cv::Mat uvPlane(frameSize.height / 2, frameSize.width / 2, CV_8UC2,
+                              const_cast<uchar *>(frame.ptr<uchar>(frameSize.height)), frame.step);
+        cv::resize(yPlane, scaledY, target, 0, 0, interpolation);
+        cv::resize(uvPlane, scaledUV, cv::Size(target.width / 2, target.height / 2), 0, 0, interpolation);
+        cv::cvtColorTwoPlane(scaledY, scaledUV, display, cv::COLOR_YUV2BGR_NV12);
+        shown = display;
+    } else if (target == frameSize) {
+        // 无需缩放时直接引用原帧（调用方不会再修改已提交的帧），不做整帧拷贝
+        shown = frame;
+    } else {
+        cv::resize(frame, display, target, 0, 0, interpolation);
+        shown = display;
+    }
+    // display 尺寸不变时 create 不重新分配，QImage 只在缓冲地址变化时重建
+    if (image.constBits() != shown.data || image.width() != shown.cols || image.height() != shown.rows
+        || image.bytesPerLine() != static_cast<qsizetype>(shown.step)) {
+        image = QImage(shown.data, shown.cols, shown.rows, static_cast<qsizetype>(shown.step),
+                       QImage::Format_BGR888);
+        image.setDevicePixelRatio(devicePixelRatioF());
+    }
+    update();
+}
+
+void FramePreviewWidget::clear()
+{
+    renderTimer->stop();
+    pending.release();
+    image = QImage();
+    shown.release();
+    display.release();
+    update();
+}
+
+void FramePreviewWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().window());
+    if (image.isNull()) {
+        return;
+    }
+    // 图像已是显示尺寸，按逻辑尺寸居中绘制，不再缩放
+    const QSizeF logical = image.deviceIndependentSize();
+    const QPointF topLeft((width() - logical.width()) / 2.0, (height() - logical.height()) / 2.0);
+    painter.drawImage(topLeft, image);
+}
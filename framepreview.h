@@ -0,0 +1,75 @@
+#ifndef FRAMEPREVIEW_H
+#define FRAMEPREVIEW_H
+
+#include <QWidget>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QTimer>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 摄像头预览控件：直接从 BGR / NV12 帧绘制
+ *
+ * 每帧只做一次缩放：帧按控件尺寸（保持宽高比，考虑设备像素比）缩放到复用的显示缓冲，
+ * paintEvent 用 Format_BGR888 的 QImage 包装该缓冲直接绘制，不再经过 RGB 转换、QPixmap 和平滑缩放。
+ * NV12 帧先分别缩放 Y/UV 平面，再在显示尺寸上转 BGR。
+ *
+ * 预览与处理解耦：setFrame 只保存最新一帧的引用，缩放按屏幕刷新率节流，间隔内到达的帧只保留最后一个；
+ * 窗口最小化、被完全遮挡或控件不可见时直接丢弃，处理和录制仍按采集帧率进行。
+ */
+class FramePreviewWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit FramePreviewWidget(QWidget *parent = nullptr);
+
+    /**
+     * @brief 提交一帧（在 GUI 线程调用）；按刷新率节流，不可见时忽略
+     * @param frame BGR（CV_8UC3）或 NV12（CV_8UC1，高为图像高度的 1.5 倍），只保存引用，调用方之后不得修改
+     * @param nv12 frame 是否为 NV12
+     */
+    void setFrame(const cv::Mat &frame, bool nv12 = false);
+
+    /**
+     * @brief 实际绘制的帧数与因节流/不可见而跳过的帧数
+     */
+    uint64_t renderedFrames() const { return rendered; }
+    uint64_t skippedFrames() const { return skipped; }
+
+    /**
+     * @brief 清空画面
+     */
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    /**
+     * @brief 按控件尺寸计算保持宽高比的显示尺寸（物理像素）
+     */
+    cv::Size fitSize(cv::Size frameSize, bool even) const;
+    /**
+     * @brief 窗口可见、未最小化且未被完全遮挡
+     */
+    bool isShowing() const;
+    int refreshIntervalMs() const;
+    void renderPending();
+
+    cv::Mat pending;        // 等待绘制的最新一帧（只持有引用）
+    bool pendingNv12 = false;
+    QTimer *renderTimer;    // 距上次绘制不足一个刷新间隔时，推迟到间隔结束再绘制
+    QElapsedTimer lastRender;
+    uint64_t rendered = 0;
+    uint64_t skipped = 0;
+
+    cv::Mat display;        // 显示尺寸的 BGR 缓冲，尺寸不变时每帧复用
+    cv::Mat scaledY;        // NV12 路径：缩放后的 Y/UV 平面
+    cv::Mat scaledUV;
+    cv::Mat shown;          // 正在显示的像素：尺寸相同时直接引用原帧，否则为 display
+    QImage image;           // 包装 shown，不拷贝像素
+};
+
+#endif // FRAMEPREVIEW_H
@@ -0,0 +1,84 @@
+#include "framesource.h"
+
+FrameSource::~FrameSource()
+{
+    stop();
+}
+
+void FrameSource::release()
+{
+    stop();
+}
+
+void FrameSource::start(bool lockstep)
+{
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest.release();
+        hasFrame = false;
+        latestSequence = 0;
+    }
+    this->lockstep = lockstep;
+    nextSequence = 0;
+    captured = 0;
+    dropped = 0;
+    running = true;
+    worker = std::thread(&FrameSource::run, this);
+}
+
+void FrameSource::stop()
+{
+    {
+        // 持锁修改，避免 publish 在检查 running 与进入等待之间错过通知
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    taken.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void FrameSource::publish(cv::Mat frame, int64_t captureUs, uint64_t sequence)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (lockstep) {
+            taken.wait(lock, [this] { return !hasFrame || !running; });
+            if (!running) {
+                return;
+            }
+        }
+        if (sequence <= latestSequence) {
+            ++dropped; // 比已发布的帧更旧（解码线程乱序完成）
+            return;
+        }
+        if (hasFrame) {
+            ++dropped; // 上一帧还没被取走，直接被新帧替换
+        }
+        latest = std::move(frame);
+        latestUs = captureUs;
+        latestSequence = sequence;
+        hasFrame = true;
+    }
+    if (onFrame) {
+        onFrame();
+    }
+}
+
+bool FrameSource::takeLatest(cv::Mat& frame, int64_t& captureUs)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!hasFrame) {
+            return false;
+        }
+        frame = std::move(latest);
+        latest = cv::Mat();
+        captureUs = latestUs;
+        hasFrame = false;
+    }
+    taken.notify_one();
+    return true;
+}
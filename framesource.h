@@ -0,0 +1,114 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief 采集格式，字段为 0 或空时沿用驱动默认值
+ */
+struct CaptureFormat {
+    cv::Size size;
+    double fps = 0.0;
+    std::string fourcc;         // "MJPG" / "YUYV" / "NV12"
+    bool keepNv12 = false;      // fourcc 为 NV12 时不让后端转 BGR，直接交出 NV12 帧
+};
+
+/**
+ * @brief 帧源节奏
+ */
+enum class SourcePacing {
+    RealTime,           // 按帧率出帧，处理跟不上时旧帧在信箱中被替换
+    AsFastAsPossible    // 不等待，上一帧被取走后立即出下一帧，不丢帧（可复现的基准测试）
+};
+
+/**
+ * @brief 帧源基类：工作线程 + 单槽信箱
+ *
+ * 摄像头、视频文件、图片序列和合成画面都从这里派生，处理线程只通过 takeLatest 取帧，
+ * 不关心帧来自哪里。派生类在 open 中准备好数据后调用 start()，在工作线程的 run() 中用 publish() 交出帧；
+ * 派生类析构时必须先调用 release()，保证工作线程不再访问派生类成员。
+ */
+class FrameSource {
+public:
+    /**
+     * @brief 新帧到达通知，在工作线程中调用
+     */
+    using FrameCallback = std::function<void()>;
+
+    FrameSource() = default;
+    virtual ~FrameSource();
+    FrameSource(const FrameSource&) = delete;
+    FrameSource& operator=(const FrameSource&) = delete;
+
+    /**
+     * @brief 停止工作线程并释放数据源（可重复调用）
+     */
+    virtual void release();
+
+    bool isOpened() const { return running; }
+    cv::Size frameSize() const { return format.size; }
+    CaptureFormat negotiated() const { return format; }
+    /**
+     * @brief 是否输出 NV12 帧（CV_8UC1，高为图像高度的 1.5 倍，Y 平面后紧跟交错的 UV 平面）
+     */
+    virtual bool nv12() const { return false; }
+    /**
+     * @brief 帧时间戳是否跟随墙钟；不限速回放的时间戳按帧号推算，会跑在墙钟前面
+     */
+    virtual bool wallClockTimestamps() const { return true; }
+
+    /**
+     * @brief 设置新帧通知，需在 open 之前调用
+     */
+    void setFrameCallback(FrameCallback callback) { onFrame = std::move(callback); }
+
+    /**
+     * @brief 取走信箱中的最新一帧
+     * @param captureUs 该帧的时间戳（mediaClockUs）
+     * @return 上次取走之后没有新帧时返回 false
+     */
+    bool takeLatest(cv::Mat& frame, int64_t& captureUs);
+
+    uint64_t capturedFrames() const { return captured; }
+    virtual uint64_t droppedFrames() const { return dropped; }
+
+protected:
+    /**
+     * @brief 清空信箱和计数并启动工作线程
+     * @param lockstep 为 true 时 publish 等到上一帧被取走才返回（不丢帧）
+     */
+    void start(bool lockstep = false);
+    void stop();
+    virtual void run() = 0;
+    /**
+     * @brief 把一帧放入信箱；序号比已发布的帧旧时直接丢弃
+     */
+    void publish(cv::Mat frame, int64_t captureUs, uint64_t sequence);
+
+    CaptureFormat format;
+    std::atomic<bool> running{false};
+    uint64_t nextSequence = 0;
+    std::atomic<uint64_t> captured{0};
+    std::atomic<uint64_t> dropped{0};
+
+private:
+    FrameCallback onFrame;
+    std::thread worker;
+    bool lockstep = false;
+
+    std::mutex mutex;           // 保护信箱
+    std::condition_variable taken;
+    cv::Mat latest;
+    int64_t latestUs = 0;
+    uint64_t latestSequence = 0; // 信箱中最新一帧的序号（取走后保留）
+    bool hasFrame = false;
+};
+
+#endif // FRAMESOURCE_H
@@ -1,52 +1,27 @@
 #include "HumanSeg.h"
+#include "alphablend.h"
+#include "taskscheduler.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <array>
 #include <numeric>
 #include <thread>
-HumanSeg::HumanSeg(float conf_thres) : conf_threshold(conf_thres) {
+HumanSeg::HumanSeg(float conf_thres)
+    : HumanSeg(std::make_shared<SegmentationService>(), conf_thres) {
+}
+
+HumanSeg::HumanSeg(std::shared_ptr<SegmentationService> service, float conf_thres)
+    : service(std::move(service)), conf_threshold(conf_thres) {
+    if (!this->service) {
+        throw std::runtime_error("No segmentation service!");
+    }
+    input_height = this->service->inputHeight();
+    input_width = this->service->inputWidth();
+    setActive(true);
     // 初始化均值和标准差
     mean = (cv::Mat_<float>(1, 3) << 0.5, 0.5, 0.5);
     std = (cv::Mat_<float>(1, 3) << 0.5, 0.5, 0.5);
-    // 加载ONNX模型
-    try {
-        const ORTCHAR_T* model_path = L"modnet.onnx";
-        Ort::SessionOptions session_options;
-        unsigned int hw = std::thread::hardware_concurrency();
-        if (hw > 0) {
-            session_options.SetIntraOpNumThreads(static_cast<int>(hw));
-        }
-        session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
-        std::vector<std::string> available_providers = Ort::GetAvailableProviders();
-        bool use_cuda = false;
-        // for (const auto& provider : available_providers) {
-        //     if (provider == "CUDAExecutionProvider") {
-        //         OrtCUDAProviderOptions cuda_options;
-        //         memset(&cuda_options, 0, sizeof(OrtCUDAProviderOptions)); // 初始化默认值
-        //         cuda_options.device_id = 0;
-        //         session_options.AppendExecutionProvider_CUDA(cuda_options);
-        //         use_cuda = true;
-        //         break;
-        //     }
-        // }
-        if (!use_cuda) {
-            qDebug() << "CPUMODE\n";
-        }
-        else{
-            qDebug() <<"CUDAMODE模式\n";
-        }
-        ort_session = std::make_unique<Ort::Session>(
-            env,
-            model_path,
-            session_options
-            );
-    } catch (const Ort::Exception& e) {
-        std::cerr << "No ONNX Model!" << e.what() << std::endl;
-        throw std::runtime_error("No ONNX Model!");
-    } catch (const std::exception& e) {
-        std::cerr << "ONNX model wrong!" << e.what() << std::endl;
-        throw std::runtime_error("ONNX model wrong!");
-    }
 }
 // 析构函数
 HumanSeg::~HumanSeg() {
@@ -57,11 +32,18 @@ HumanSeg::~HumanSeg() {
 void HumanSeg::setBackground(const std::string& bg_path, const std::string& bg_type) {
     this->bg_type = bg_type;
 
+    bg_resized.release();
     if (bg_type == "image") {
         bg_image = imreadChinese(bg_path);
         if (bg_image.empty()) {
             throw std::runtime_error("bg picture-->" + bg_path + "-->cannot load!");
         }
+        // 加载时统一为 BGR，合成时不必每帧转换
+        if (bg_image.channels() == 4) {
+            cv::cvtColor(bg_image, bg_image, cv::COLOR_BGRA2BGR);
+        } else if (bg_image.channels() == 1) {
+            cv::cvtColor(bg_image, bg_image, cv::COLOR_GRAY2BGR);
+        }
     } else if (bg_type == "video") {
         // 视频路径转宽字符（支持中文）
         std::string w_bg_path(bg_path.begin(), bg_path.end());
@@ -80,100 +62,98 @@ cv::Mat HumanSeg::getBgFrame(const std::pair<int, int>& target_size) {
     int target_w = target_size.second;
 
     if (bg_type == "image") {
-        cv::Mat resized;
-        cv::resize(bg_image, resized, cv::Size(target_w, target_h));
-        return resized;
+        // 图片背景只在尺寸变化或更换图片后缩放一次
+        if (bg_resized.size() != cv::Size(target_w, target_h)) {
+            cv::resize(bg_image, bg_resized, cv::Size(target_w, target_h));
+            bgNV12Dirty = true;
+        }
+        return bg_resized;
     } else if (bg_type == "video") {
-        cv::Mat frame;
-        bool ret = bg_video.read(frame);
+        bool ret = bg_video.read(bg_video_frame);
         if (!ret) {
             bg_video.set(cv::CAP_PROP_POS_FRAMES, 0);
-            ret = bg_video.read(frame);
+            ret = bg_video.read(bg_video_frame);
             if (!ret) {
+                bgNV12Dirty = true;
                 return cv::Mat::zeros(target_h, target_w, CV_8UC3);
             }
         }
-        cv::Mat resized;
-        cv::resize(frame, resized, cv::Size(target_w, target_h));
-        return resized;
+        cv::resize(bg_video_frame, bg_resized, cv::Size(target_w, target_h));
+        bgNV12Dirty = true;
+        return bg_resized;
     } else {
         return cv::Mat::zeros(target_h, target_w, CV_8UC3);
     }
 }
 
-// 核心：分割+背景替换+基础文字绘制（cv::putText）
-cv::Mat HumanSeg::segmentAndReplace(const cv::Mat& frame) {
-    if (frame.empty()) {
-        throw std::invalid_argument("input frame is empty!");
-    }
-
-    // 1. 预处理：缩放+转RGB+归一化
-    cv::Mat input_frame;
-    cv::resize(frame, input_frame, cv::Size(input_width, input_height));
-    cv::cvtColor(input_frame, input_frame, cv::COLOR_BGR2RGB);
-
-    // 归一化到[0,1]
-    input_frame.convertTo(input_frame, CV_32F);
-    input_frame /= 255.0f;
-
-    // 减均值/除标准差
+// 归一化+推理：输入为 inputResized（模型尺寸的 RGB），输出为原帧尺寸的 0/255 掩码 personMask
+void HumanSeg::inferMask(cv::Size frameSize) {
+    // 归一化（x/255 - mean）/ std 与 HWC -> CHW 合并为一次遍历，按行分给调度器并行
+    const size_t plane = static_cast<size_t>(input_height) * input_width;
+    std::vector<float>& input_tensor = inputTensor;
+    input_tensor.resize(3 * plane);
+    std::array<float, 3> scale;
+    std::array<float, 3> offset;
     for (int c = 0; c < 3; ++c) {
-        input_frame.forEach<cv::Vec3f>([c, this](cv::Vec3f& pixel, const int*) {
-            pixel[c] = (pixel[c] - mean.at<float>(0, c)) / std.at<float>(0, c);
-        });
+        scale[c] = 1.0f / (255.0f * std.at<float>(0, c));
+        offset[c] = -mean.at<float>(0, c) / std.at<float>(0, c);
     }
-
-    // 2. 转换为NCHW格式的输入张量
-    std::vector<int64_t> input_shape = {1, 3, input_height, input_width};
-    size_t input_size = 1 * 3 * input_height * input_width;
-    std::vector<float> input_tensor(input_size);
-
-    // HWC -> CHW
-    int idx = 0;
-    for (int c = 0; c < 3; ++c) {
-        for (int h = 0; h < input_height; ++h) {
+    float* tensor = input_tensor.data();
+    TaskScheduler::instance().parallelFor(0, input_height, [&](int firstRow, int lastRow) {
+        for (int h = firstRow; h < lastRow; ++h) {
+            const uchar* src = inputResized.ptr<uchar>(h);
+            float* dst[3] = {tensor + h * input_width, tensor + plane + h * input_width,
+                             tensor + 2 * plane + h * input_width};
             for (int w = 0; w < input_width; ++w) {
-                input_tensor[idx++] = input_frame.at<cv::Vec3f>(h, w)[c];
+                for (int c = 0; c < 3; ++c) {
+                    dst[c][w] = src[w * 3 + c] * scale[c] + offset[c];
+                }
             }
         }
-    }
+    });
 
-    // 3. ONNX推理
-    Ort::AllocatorWithDefaultOptions allocator;
-    // 显式指定输入输出名称（MODNet官方模型）
-    const char* input_name = "input";
-    const char* output_name = "output";
-
-    // 创建输入张量
-    Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
-    Ort::Value input_tensor_obj = Ort::Value::CreateTensor<float>(
-        memory_info, input_tensor.data(), input_tensor.size(),
-        input_shape.data(), input_shape.size()
-        );
-
-    // 执行推理
-    std::vector<Ort::Value> output_tensors = ort_session->Run(
-        Ort::RunOptions{nullptr},
-        &input_name, &input_tensor_obj, 1,
-        &output_name, 1
-        );
+    // 3. 推理（多路摄像头共享同一个会话，由服务合并成 batch）
+    outputTensor.resize(static_cast<size_t>(input_height) * input_width);
+    service->infer(input_tensor.data(), outputTensor.data());
 
     // 5. 生成二值掩码
-    float* seg_data = output_tensors[0].GetTensorMutableData<float>();
-    cv::Mat seg_map(input_height, input_width, CV_32F, seg_data);
+    cv::Mat seg_map(input_height, input_width, CV_32F, outputTensor.data());
 
     // 缩放掩码到原帧尺寸
-    cv::Mat seg_map_resized;
-    cv::resize(seg_map, seg_map_resized, cv::Size(frame.cols, frame.rows), 0, 0, cv::INTER_LINEAR);
+    cv::Mat& seg_map_resized = segMapResized;
+    cv::resize(seg_map, seg_map_resized, frameSize, 0, 0, cv::INTER_LINEAR);
 
     // 修正：掩码归一化到 0-255（CV_8U）
-    cv::Mat person_mask;
-    cv::threshold(seg_map_resized, person_mask, conf_threshold, 255.0, cv::THRESH_BINARY); // 关键：255而非1
-    person_mask.convertTo(person_mask, CV_8U); // 现在掩码是 0/255
-    cv::Mat person_mask_3ch;
-    cv::cvtColor(person_mask, person_mask_3ch, cv::COLOR_GRAY2BGR);
+    cv::Mat& person_mask = personMask;
+    cv::threshold(seg_map_resized, seg_map_resized, conf_threshold, 255.0, cv::THRESH_BINARY); // 关键：255而非1
+    seg_map_resized.convertTo(person_mask, CV_8U); // 现在掩码是 0/255
+}
+
+// 标题覆盖率蒙版只在文字/字体/字号变化时重新栅格化
+void HumanSeg::updateTitleMask() {
+    if (titleDirty) {
+        titleMask.release();
+        if (!title.empty()) {
+            TextRenderer::instance().renderCoverage(title, font_size, font_name, titleMask, titleMaskOffset);
+        }
+        titleDirty = false;
+    }
+}
 
-    // 6. 背景替换
+// 核心：分割+背景替换+基础文字绘制（cv::putText）
+cv::Mat HumanSeg::segmentAndReplace(const cv::Mat& frame) {
+    if (frame.empty()) {
+        throw std::invalid_argument("input frame is empty!");
+    }
+
+    // 1. 预处理：缩放+转RGB（中间图像都是成员，尺寸不变时不再分配），推理得到人像掩码
+    cv::resize(frame, inputResized, cv::Size(input_width, input_height));
+    cv::cvtColor(inputResized, inputResized, cv::COLOR_BGR2RGB);
+    inferMask(frame.size());
+    cv::Mat& person_mask_3ch = personMask3ch;
+    cv::cvtColor(personMask, person_mask_3ch, cv::COLOR_GRAY2BGR);
+
+    // 2. 背景替换
     cv::Mat bg_frame = getBgFrame({frame.rows, frame.cols});
     if (bg_frame.channels() == 4) {
         cv::cvtColor(bg_frame, bg_frame, cv::COLOR_BGRA2BGR);
@@ -182,46 +162,117 @@ cv::Mat HumanSeg::segmentAndReplace(const cv::Mat& frame) {
     }
 
     // 修正：人像区域保留原帧，背景区域替换为背景帧
+    // output_frame 会交给录制队列，每帧新建（缓冲来自 FramePool），其余中间结果复用成员
     cv::Mat output_frame;
     cv::bitwise_and(frame, person_mask_3ch, output_frame); // 人像区域（255）保留原帧，背景（0）为黑
-    cv::Mat bg_part;
-    cv::bitwise_and(bg_frame, ~person_mask_3ch, bg_part);  // 背景区域（~0=255）保留背景帧，人像（~255=0）为黑
+    cv::bitwise_not(person_mask_3ch, invMask3ch);
+    cv::Mat& bg_part = bgPart;
+    cv::bitwise_and(bg_frame, invMask3ch, bg_part);  // 背景区域（~0=255）保留背景帧，人像（~255=0）为黑
     cv::add(output_frame, bg_part, output_frame); // 叠加后：人像+新背景
-    if (!title.empty()) {
-        putText::putTextZH(output_frame,title.c_str(),Point(titleX,titleY),Scalar(std::get<2>(rgb), std::get<1>(rgb), std::get<0>(rgb)),font_size,font_name.c_str());
+    updateTitleMask();
+    if (!titleMask.empty()) {
+        alphaBlendColor(output_frame, titleMask, cv::Point(titleX, titleY) + titleMaskOffset,
+                        cv::Scalar(std::get<2>(rgb), std::get<1>(rgb), std::get<0>(rgb)));
     }
 
     return output_frame;
 }
 
+// YUV 直通：分割与背景替换都在 NV12 上完成，只在模型分辨率上做一次颜色转换
+cv::Mat HumanSeg::segmentAndReplaceNV12(const cv::Mat& nv12) {
+    if (nv12.empty() || nv12.type() != CV_8UC1 || nv12.rows % 3 != 0) {
+        throw std::invalid_argument("input frame is not NV12!");
+    }
+    const int height = nv12.rows * 2 / 3;
+    const int width = nv12.cols;
+    const cv::Mat yPlane = nv12.rowRange(0, height);
+    const cv::Mat uvPlane(height / 2, width / 2, CV_8UC2, const_cast<uchar*>(nv12.ptr<uchar>(height)), nv12.step);
+
+    // 1. 预处理：Y、UV 平面分别缩放到模型尺寸后再转 RGB，全分辨率画面不做颜色转换
+    cv::resize(yPlane, modelY, cv::Size(input_width, input_height));
+    cv::resize(uvPlane, modelUV, cv::Size(input_width / 2, input_height / 2));
+    cv::cvtColorTwoPlane(modelY, modelUV, inputResized, cv::COLOR_YUV2RGB_NV12);
+    inferMask(cv::Size(width, height));
+
+    // 2. 背景替换：Y 平面用全分辨率掩码，UV 平面用半分辨率掩码，从 NV12 背景中拷贝背景区域
+    const cv::Mat& bg = getBgFrameNV12(cv::Size(width, height));
+    cv::Mat output_frame = nv12.clone();
+    cv::bitwise_not(personMask, invMask);
+    cv::resize(invMask, invMaskHalf, cv::Size(width / 2, height / 2), 0, 0, cv::INTER_NEAREST);
+    const cv::Mat bgY = bg.rowRange(0, height);
+    cv::Mat outY = output_frame.rowRange(0, height);
+    bgY.copyTo(outY, invMask);
+    const cv::Mat bgUV(height / 2, width / 2, CV_8UC2, const_cast<uchar*>(bg.ptr<uchar>(height)), bg.step);
+    cv::Mat outUV(height / 2, width / 2, CV_8UC2, output_frame.ptr<uchar>(height), output_frame.step);
+    bgUV.copyTo(outUV, invMaskHalf);
+
+    updateTitleMask();
+    if (!titleMask.empty()) {
+        alphaBlendColorNV12(output_frame, titleMask, cv::Point(titleX, titleY) + titleMaskOffset,
+                            cv::Scalar(std::get<2>(rgb), std::get<1>(rgb), std::get<0>(rgb)));
+    }
+    return output_frame;
+}
+
+// NV12 背景：图片背景只在缩放后转换一次，视频背景每帧转换
+const cv::Mat& HumanSeg::getBgFrameNV12(cv::Size size) {
+    const cv::Mat bg = getBgFrame({size.height, size.width});
+    if (!bgNV12Dirty && bgNV12.cols == size.width && bgNV12.rows == size.height * 3 / 2) {
+        return bgNV12;
+    }
+    const int height = size.height;
+    const int width = size.width;
+    cv::cvtColor(bg, bgI420, cv::COLOR_BGR2YUV_I420);
+    bgNV12.create(height * 3 / 2, width, CV_8UC1);
+    cv::Mat bgY = bgNV12.rowRange(0, height);
+    bgI420.rowRange(0, height).copyTo(bgY);
+    // I420 的 U、V 平面各为 (h/2)x(w/2)，在 Y 平面之后连续存放；交错成 NV12 的 UV 平面
+    const int chromaSize = (height / 2) * (width / 2);
+    cv::Mat planes[] = {cv::Mat(height / 2, width / 2, CV_8UC1, bgI420.ptr<uchar>(height)),
+                        cv::Mat(height / 2, width / 2, CV_8UC1, bgI420.ptr<uchar>(height) + chromaSize)};
+    cv::Mat bgUV(height / 2, width / 2, CV_8UC2, bgNV12.ptr<uchar>(height), bgNV12.step);
+    cv::merge(planes, 2, bgUV);
+    bgNV12Dirty = false;
+    return bgNV12;
+}
+
+void HumanSeg::setActive(bool active) {
+    if (!service || active == registered) {
+        return;
+    }
+    if (active) {
+        service->addClient();
+    } else {
+        service->removeClient();
+    }
+    registered = active;
+}
+
 // 释放资源
 void HumanSeg::release() {
-    qDebug() << "开始释放HumanSeg资源..." << '\n';
+    std::cout << "开始释放HumanSeg资源..." << std::endl;
 
-    // 1. 释放ONNX Session
-    try {
-        if (ort_session) {
-            ort_session.reset();
-            qDebug() << "ONNX会话已释放" << '\n';
-        }
-    } catch (const std::exception& e) {
-        qDebug() << "ONNX会话释放警告：" << e.what() << '\n';
+    // 1. 注销推理服务（最后一个使用者释放时会话随之销毁）
+    if (service) {
+        setActive(false);
+        service.reset();
+        std::cout << "推理服务已注销" << std::endl;
     }
 
     // 2. 释放视频资源
     try {
         if (bg_video.isOpened()) {
             bg_video.release();
-            qDebug() << "背景视频已释放" << '\n';
+            std::cout << "背景视频已释放" << std::endl;
         }
     } catch (const std::exception& e) {
-        qDebug() << "背景视频释放警告：" << e.what() << '\n';
+        std::cerr << "背景视频释放警告：" << e.what() << std::endl;
     }
 
     // 3. 释放图片资源
     bg_image.release();
     bg_type.clear();
-     qDebug() << "HumanSeg资源释放完成" << '\n';
+     std::cout << "HumanSeg资源释放完成" << std::endl;
 }
 bool HumanSeg::isContainChineseUTF8(const std::string& utf8Str) {
     const uint8_t* p = reinterpret_cast<const uint8_t*>(utf8Str.c_str());
@@ -267,7 +318,7 @@ bool HumanSeg::isContainChineseUTF8(const std::string& utf8Str) {
 // 读取带中文路径的图片
 cv::Mat HumanSeg::imreadChinese(const std::string& path, int flags) {
     if(isContainChineseUTF8(path)){
-        std::filesystem::path fs_path(path);
+        const fs::path fs_path = fs::u8path(path); // 按 UTF-8 解释，Windows 下不受本地代码页影响
         std::ifstream file(fs_path, std::ios::binary);
         // 2. 检查文件是否成功打开
         if (!file.is_open()) {
@@ -297,19 +348,6 @@ cv::Mat HumanSeg::imreadChinese(const std::string& path, int flags) {
             return {};
         }
     }
-    else{
-        std::wstring wpath(path.begin(), path.end());
-        FILE* fp = _wfopen(wpath.c_str(), L"rb");
-        if (!fp) {
-            return cv::Mat();
-        }
-        fseek(fp, 0, SEEK_END);
-        long size = ftell(fp);
-        fseek(fp, 0, SEEK_SET);
-        std::vector<char> buf(size);
-        fread(buf.data(), 1, size, fp);
-        fclose(fp);
-        // 解码为Mat
-        return cv::imdecode(cv::Mat(buf), flags);
-    }
+    // 纯 ASCII / 非中文路径直接交给 OpenCV
+    return cv::imread(path, flags);
 }
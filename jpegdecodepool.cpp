@@ -0,0 +1,109 @@
+#include "jpegdecodepool.h"
+#include "taskscheduler.h"
+#include <algorithm>
+
+#ifdef HAVE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+namespace {
+#ifdef HAVE_TURBOJPEG
+bool decodeJpeg(tjhandle handle, const cv::Mat& jpeg, cv::Mat& bgr)
+{
+    const auto* data = jpeg.ptr<unsigned char>();
+    const auto size = static_cast<unsigned long>(jpeg.total() * jpeg.elemSize());
+    int width = 0;
+    int height = 0;
+    int subsamp = 0;
+    int colorspace = 0;
+    if (!handle || tjDecompressHeader3(handle, data, size, &width, &height, &subsamp, &colorspace) != 0) {
+        return false;
+    }
+    bgr.create(height, width, CV_8UC3);
+    // 预览和录制对 IDCT 精度不敏感，使用快速 IDCT
+    return tjDecompress2(handle, data, size, bgr.data, width, static_cast<int>(bgr.step), height,
+                         TJPF_BGR, TJFLAG_FASTDCT) == 0;
+}
+
+// 每个调度器线程一个解码器实例，线程退出时销毁
+struct Decompressor {
+    tjhandle handle = tjInitDecompress();
+    ~Decompressor()
+    {
+        if (handle) {
+            tjDestroy(handle);
+        }
+    }
+};
+#endif
+}
+
+JpegDecodePool::JpegDecodePool(int threads, Output output)
+    : output(std::move(output))
+    , maxPending(static_cast<size_t>(std::max(1, threads)))
+    , maxActive(std::max(1, threads))
+{
+}
+
+JpegDecodePool::~JpegDecodePool()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    stopping = true;
+    jobs.clear();
+    idle.wait(lock, [this] { return active == 0; });
+}
+
+void JpegDecodePool::submit(cv::Mat jpeg, int64_t captureUs, uint64_t sequence)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) {
+            return;
+        }
+        if (jobs.size() >= maxPending) {
+            jobs.pop_front();
+            ++dropped;
+        }
+        jobs.push_back({std::move(jpeg), captureUs, sequence});
+        if (active >= maxActive) {
+            return; // 正在运行的任务解完手上的帧会继续取队列
+        }
+        ++active;
+    }
+    TaskScheduler::instance().submit([this]() { drain(); }, TaskPriority::Frame);
+}
+
+void JpegDecodePool::drain()
+{
+#ifdef HAVE_TURBOJPEG
+    thread_local Decompressor decompressor;
+#endif
+    for (;;) {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (jobs.empty()) {
+                // 队列取空才结束任务，析构函数等到 active 归零
+                if (--active == 0) {
+                    idle.notify_all();
+                }
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        // 解码结果交给信箱，每帧使用新的 Mat（缓冲来自 FramePool）
+        cv::Mat bgr;
+#ifdef HAVE_TURBOJPEG
+        const bool ok = decodeJpeg(decompressor.handle, job.data, bgr);
+#else
+        bgr = cv::imdecode(job.data, cv::IMREAD_COLOR);
+        const bool ok = !bgr.empty();
+#endif
+        if (!ok) {
+            ++failed;
+            continue;
+        }
+        output(std::move(bgr), job.captureUs, job.sequence);
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef JPEGDECODEPOOL_H
+#define JPEGDECODEPOOL_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/**
+ * @brief MJPEG 并行解码
+ *
+ * 采集线程只取出摄像头的压缩数据，解码（libjpeg-turbo，未找到时退回 cv::imdecode）以 Frame 优先级
+ * 交给共享的 TaskScheduler，最多同时解码 threads 帧，USB 2.0 摄像头也能以 MJPEG 跑满 1080p30。
+ * 各任务完成顺序不固定，输出附带序号，由调用方丢弃过期帧。
+ */
+class JpegDecodePool {
+public:
+    /**
+     * @brief 解码完成回调，在工作线程中调用
+     */
+    using Output = std::function<void(cv::Mat bgr, int64_t captureUs, uint64_t sequence)>;
+
+    /**
+     * @param threads 同时解码的最大帧数
+     */
+    JpegDecodePool(int threads, Output output);
+    /**
+     * @brief 丢弃未开始的帧，等待正在解码的帧完成
+     */
+    ~JpegDecodePool();
+    JpegDecodePool(const JpegDecodePool&) = delete;
+    JpegDecodePool& operator=(const JpegDecodePool&) = delete;
+
+    /**
+     * @brief 提交一帧压缩数据；积压超过 threads 帧时丢弃最旧的待解码帧
+     */
+    void submit(cv::Mat jpeg, int64_t captureUs, uint64_t sequence);
+
+    uint64_t droppedFrames() const { return dropped; }
+    uint64_t failedFrames() const { return failed; }
+
+private:
+    struct Job {
+        cv::Mat data;
+        int64_t captureUs;
+        uint64_t sequence;
+    };
+
+    void drain();
+
+    Output output;
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::deque<Job> jobs;
+    size_t maxPending;
+    int maxActive;
+    int active = 0;        // 已提交给调度器、尚未结束的解码任务数
+    bool stopping = false;
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> failed{0};
+};
+
+#endif // JPEGDECODEPOOL_H
@@ -0,0 +1,122 @@
+#include "livetext.h"
+#include "textrenderer.h"
+#include <algorithm>
+
+namespace {
+// 以取最大值的方式把字形覆盖率贴到条带上（自动裁剪），重复贴同一字形结果不变
+void blitMax(cv::Mat& strip, const cv::Mat& atlas, const cv::Rect& src, cv::Point at)
+{
+    const cv::Rect target = cv::Rect(at.x, at.y, src.width, src.height) & cv::Rect(0, 0, strip.cols, strip.rows);
+    if (target.empty()) {
+        return;
+    }
+    const cv::Rect from(src.x + target.x - at.x, src.y + target.y - at.y, target.width, target.height);
+    cv::Mat dst = strip(target);
+    cv::max(dst, atlas(from), dst);
+}
+}
+
+LiveText::LiveText(const std::string& fontName, int fontSize)
+    : fontName(fontName), fontSize(fontSize)
+{
+    fontAvailable = TextRenderer::instance().withAtlas(fontName, fontSize, [this](GlyphAtlas& atlas) {
+        stripHeight = atlas.lineHeight();
+    });
+    if (fontAvailable) {
+        strip = cv::Mat::zeros(stripHeight, fontSize * 16, CV_8UC1);
+    }
+    penX.assign(1, 0);
+}
+
+void LiveText::ensureWidth(int width)
+{
+    if (width <= strip.cols) {
+        return;
+    }
+    cv::Mat grown = cv::Mat::zeros(stripHeight, std::max(width, strip.cols * 2), CV_8UC1);
+    strip.copyTo(grown.colRange(0, strip.cols));
+    strip = grown;
+}
+
+bool LiveText::setText(const std::string& utf8)
+{
+    std::u32string next = TextRenderer::decodeUtf8(utf8);
+    next.erase(std::remove(next.begin(), next.end(), U'\n'), next.end());
+    if (next == text || !fontAvailable) {
+        redrawCount = 0;
+        return false;
+    }
+
+    // 1. 找到第一个变化的字符；前面字符的位置不变。从它前一个字符开始重排，
+    //    以便正确处理字距调整和前一个字形伸入清除区域的部分
+    size_t k = 0;
+    while (k < text.size() && k < next.size() && text[k] == next[k]) {
+        ++k;
+    }
+    const size_t start = k > 0 ? k - 1 : 0;
+    const size_t reblit = start > 0 ? start - 1 : 0;
+
+    // 图集与其他图层共享，查字形和拼贴都在 TextRenderer 的锁内完成
+    int pen = 0;
+    TextRenderer::instance().withAtlas(fontName, fontSize, [&](GlyphAtlas& atlas) {
+        // 2. 计算新的笔位置；penX[start] 已包含 start-1 与 start 之间的字距，从 start 之后才累加字距
+        penX.resize(next.size() + 1);
+        pen = penX[start];
+        const GlyphInfo* prev = nullptr;
+        for (size_t i = start; i < next.size(); ++i) {
+            const GlyphInfo& g = atlas.glyph(next[i]);
+            if (prev) {
+                pen += atlas.kerning(*prev, g);
+            }
+            penX[i] = pen;
+            pen += g.advance;
+            prev = &g;
+        }
+        penX[next.size()] = pen;
+
+        // 3. 清除变化区域并重新拼贴（图集此后不再扩容，覆盖率引用在锁内有效）
+        std::vector<const GlyphInfo*> glyphs(next.size() - reblit);
+        for (size_t i = reblit; i < next.size(); ++i) {
+            glyphs[i - reblit] = &atlas.glyph(next[i]);
+        }
+        ensureWidth(pen + stripHeight);
+        const int clearX = std::min(penX[start], strip.cols);
+        strip.colRange(clearX, strip.cols).setTo(0);
+        const int baseline = atlas.ascender();
+        const cv::Mat& coverageAtlas = atlas.coverage();
+        for (size_t i = reblit; i < next.size(); ++i) {
+            const GlyphInfo* g = glyphs[i - reblit];
+            if (!g->rect.empty()) {
+                blitMax(strip, coverageAtlas, g->rect, cv::Point(penX[i] + g->bearingX, baseline - g->bearingY));
+            }
+        }
+    });
+
+    inkWidth = std::min(strip.cols, pen + (next.empty() ? 0 : stripHeight / 4));
+    redrawCount = static_cast<int>(next.size() - reblit);
+    text = std::move(next);
+    return true;
+}
+
+cv::Mat LiveText::coverage() const
+{
+    if (inkWidth <= 0 || strip.empty()) {
+        return cv::Mat();
+    }
+    return strip.colRange(0, inkWidth);
+}
+
+void TickerStrip::setText(const std::string& utf8, const std::string& fontName, int fontSize, int gap)
+{
+    std::string line = utf8;
+    std::replace(line.begin(), line.end(), '\n', ' ');
+    cv::Mat rendered;
+    cv::Point offset;
+    if (line.empty() || !TextRenderer::instance().renderCoverage(line, fontSize, fontName, rendered, offset)
+        || rendered.empty()) {
+        strip.release();
+        return;
+    }
+    strip = cv::Mat::zeros(rendered.rows, rendered.cols + std::max(gap, 0), CV_8UC1);
+    rendered.copyTo(strip.colRange(0, rendered.cols));
+}
@@ -0,0 +1,66 @@
+#ifndef LIVETEXT_H
+#define LIVETEXT_H
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 增量渲染的动态文字（时钟、录制计时等）
+ *
+ * 覆盖率条带常驻内存，文字变化时只从第一个变化的字符开始重新拼贴字形，
+ * 例如时钟每秒通常只需重画最后一两位数字。字形通过 TextRenderer::withAtlas 持锁读取。
+ */
+class LiveText {
+public:
+    LiveText(const std::string& fontName, int fontSize);
+
+    /**
+     * @brief 更新文字（UTF-8，单行）
+     * @return 内容是否发生变化
+     */
+    bool setText(const std::string& utf8);
+
+    /**
+     * @brief 当前文字的覆盖率蒙版（CV_8UC1，指向内部条带，宽度为文字实际宽度）
+     */
+    cv::Mat coverage() const;
+
+    /**
+     * @brief 上次更新时重新拼贴的字符数（用于统计）
+     */
+    int lastRedrawCount() const { return redrawCount; }
+
+private:
+    void ensureWidth(int width);
+
+    std::string fontName;
+    int fontSize;
+    bool fontAvailable = false;
+    int stripHeight = 0;
+    std::u32string text;
+    std::vector<int> penX;   // 每个字符的起始笔位置，末尾额外存一个总宽度
+    cv::Mat strip;           // CV_8UC1
+    int inkWidth = 0;
+    int redrawCount = 0;
+};
+
+/**
+ * @brief 滚动字幕：整条文字只预渲染一次，滚动时仅移动取样窗口
+ */
+class TickerStrip {
+public:
+    /**
+     * @brief 设置字幕内容并预渲染条带
+     * @param gap 首尾相接处的空白（像素）
+     */
+    void setText(const std::string& utf8, const std::string& fontName, int fontSize, int gap);
+
+    const cv::Mat& coverage() const { return strip; }
+    bool empty() const { return strip.empty(); }
+
+private:
+    cv::Mat strip;           // CV_8UC1，宽度 = 文字宽度 + gap
+};
+
+#endif // LIVETEXT_H
@@ -1,10 +1,21 @@
 #include <QApplication>
 #include <QDir>
-#include "MainWindow.h"
+#include "mainwindow.h"
+#include "framepool.h"
+#include "taskscheduler.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 int main(int argc, char *argv[])
 {
+#ifdef _WIN32
     SetConsoleOutputCP(CP_UTF8);
+#endif
+    // 所有 cv::Mat 的缓冲都从帧缓冲池分配，每帧的临时图像释放后回到池中复用
+    FramePool::instance().install();
+    // OpenCV 的并行循环、MJPEG 解码和后台素材加载共用同一组工作线程
+    TaskScheduler::instance().installOpenCvBackend();
     QApplication app(argc, argv);
     BackgroundReplaceWindow window;
     window.show();
@@ -1,31 +1,40 @@
-#include "MainWindow.h"
+#include "mainwindow.h"
+#include "framepool.h"
+#include "taskscheduler.h"
 #include <QApplication>
 #include <QScreen>
 #include <QGuiApplication>
 #include <QDir>
+#include <QFile>
 #include <QStandardPaths>
 #include <QDateTime>
 #include <QDesktopServices>
 #include <QUrl>
 #include <QMessageBox>
-#include <QProcess>
 #include <QGraphicsDropShadowEffect>
+#include <QPointer>
+#include <QSignalBlocker>
+#include <QThread>
+#include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <memory>
 
 BackgroundReplaceWindow::BackgroundReplaceWindow(QWidget *parent)
     : QMainWindow(parent)
-    , segmentor(new HumanSeg(0.5))
-    , camera(nullptr)
-    , timer(new QTimer(this))
     , carouselTimer(new QTimer(this))
     , imgIndex(0)
     , carouselInterval(5)
     , isRecording(false)
     , isPreviewFullScreen(false)
     , recordStartTime(0)
-    , videoWriter(nullptr)
     , cameraIndex(0)
     , currentSetupStep(-1)
+    , fgLayerId(-1)
+    , clockLayerId(-1)
+    , recTimerLayerId(-1)
+    , tickerLayerId(-1)
+    , tickerBandLayerId(-1)
     , fgX(0)
     , fgY(0)
     , fgScale(1.0)
@@ -37,37 +46,24 @@ BackgroundReplaceWindow::BackgroundReplaceWindow(QWidget *parent)
     setFixedSize(1500, 800);
 
     // Connect timer signals
-    connect(timer, &QTimer::timeout, this, &BackgroundReplaceWindow::updateFrame);
     connect(carouselTimer, &QTimer::timeout, this, &BackgroundReplaceWindow::printTimeUp);
+    engine.overlays().setAnimationMemoryCap(FG_ANIMATION_MEMORY_CAP);
 
     initUI();
 }
 
 BackgroundReplaceWindow::~BackgroundReplaceWindow()
 {
-    // Clean up resources
-    if (timer->isActive()) {
-        timer->stop();
-    }
+    // Clean up resources（帧源、编码器等由引擎析构时释放）
+    engine.closeSource();
     if (carouselTimer->isActive()) {
         carouselTimer->stop();
     }
-    if (isRecording && videoWriter) {
-        videoWriter->release();
-        delete videoWriter;
-        videoWriter = nullptr;
-    }
-
-    if (camera && camera->isOpened()) {
-        camera->release();
-        delete camera;
-        camera = nullptr;
-    }
-    if (segmentor) {
-        segmentor->release();
-        delete segmentor;
-        segmentor = nullptr;
-    }
+    engine.stopRecording();
+    stopReplay();
+    stopVirtualCamera();
+    stopSecondCamera();
+    waitFileThreads();
 }
 
 void BackgroundReplaceWindow::initUI()
@@ -85,7 +81,7 @@ void BackgroundReplaceWindow::initUI()
 
     // 1.1 添加 Logo 图片
     QLabel *logoLabel = new QLabel();
-    QPixmap logoPixmap("e:\\Qt-projects\\BgCam\\BgCamCPP\\build\\Desktop_Qt_6_10_1_MinGW_64_bit-Release\\release\\icon.png");
+    QPixmap logoPixmap(QCoreApplication::applicationDirPath() + "/icon.png");
     if (!logoPixmap.isNull()) {
         logoLabel->setPixmap(logoPixmap.scaled(200, 200, Qt::KeepAspectRatio, Qt::SmoothTransformation));
     } else {
@@ -346,8 +342,6 @@ void BackgroundReplaceWindow::initUI()
     // ==========================================
     centralWidget = new QWidget();
     
-    cameraNumber = detectCamera();
-
     mainLayout = new QHBoxLayout(centralWidget);
     mainLayout->setContentsMargins(10, 10, 10, 10);
     mainLayout->setSpacing(10);
@@ -368,11 +362,10 @@ void BackgroundReplaceWindow::initUI()
     previewStackLayout->setStackingMode(QStackedLayout::StackAll);
     previewStackLayout->setContentsMargins(0, 0, 0, 0);
 
-    cameraLabel = new QLabel();
-    cameraLabel->setAlignment(Qt::AlignCenter);
-    cameraLabel->setMinimumSize(640, 480);
-    cameraLabel->setMaximumSize(960, 540);
-    previewStackLayout->addWidget(cameraLabel);
+    cameraPreview = new FramePreviewWidget();
+    cameraPreview->setMinimumSize(640, 480);
+    cameraPreview->setMaximumSize(960, 540);
+    previewStackLayout->addWidget(cameraPreview);
 
     QWidget *overlayLayer = new QWidget();
     overlayLayer->setAttribute(Qt::WA_TransparentForMouseEvents, true);
@@ -427,14 +420,50 @@ void BackgroundReplaceWindow::initUI()
     controlGroupBox = new QGroupBox("控制面板");
     controlGroupBox->setVisible(false); // No longer used as a standalone group in wizard
 
+    // 视频源：除摄像头外还可以用视频文件、图片目录或合成画面驱动整条管线，便于在无摄像头的机器上复现问题
+    QHBoxLayout *sourceLayout = new QHBoxLayout();
+    sourceLayout->addWidget(new QLabel("视频源："));
+    sourceTypeBox = new QComboBox();
+    sourceTypeBox->addItem("摄像头", "camera");
+    sourceTypeBox->addItem("视频文件（循环）", "video");
+    sourceTypeBox->addItem("图片序列", "images");
+    sourceTypeBox->addItem("合成画面", "synthetic");
+    sourceLayout->addWidget(sourceTypeBox, 1);
+    sourcePathEdit = new QLineEdit();
+    sourcePathEdit->setReadOnly(true);
+    sourcePathEdit->setPlaceholderText("未选择");
+    sourceLayout->addWidget(sourcePathEdit, 1);
+    btnSourcePath = new QPushButton("浏览…");
+    connect(btnSourcePath, &QPushButton::clicked, this, &BackgroundReplaceWindow::chooseSourcePath);
+    sourceLayout->addWidget(btnSourcePath);
+    chkFastPacing = new QCheckBox("不限速");
+    chkFastPacing->setToolTip("不按帧率等待，上一帧处理完立即送下一帧，每帧都会处理（用于基准测试）");
+    sourceLayout->addWidget(chkFastPacing);
+    auto updateSourceWidgets = [this]() {
+        const QString type = sourceTypeBox->currentData().toString();
+        const bool needsPath = type == "video" || type == "images";
+        sourcePathEdit->setVisible(needsPath);
+        btnSourcePath->setVisible(needsPath);
+        chkFastPacing->setVisible(type != "camera");
+        if (needsPath) {
+            sourcePathEdit->clear();
+        }
+    };
+    connect(sourceTypeBox, &QComboBox::currentIndexChanged, this, updateSourceWidgets);
+    updateSourceWidgets();
+
     QHBoxLayout *chooseLayout = new QHBoxLayout();
     QLabel *chooseLabel = new QLabel("选择摄像头：");
     chooseLayout->addWidget(chooseLabel);
 
+    // 先显示上次枚举的缓存，后台枚举完成或设备插拔后再刷新
     comboBox = new QComboBox();
-    for (int i = 0; i < cameraNumber; ++i) {
-        comboBox->addItem("相机" + QString::number(i + 1));
-    }
+    comboBox->setPlaceholderText("正在检测摄像头…");
+    secondCameraBox = new QComboBox(); // 第二路摄像头的选择框，与 comboBox 一起刷新
+    cameraEnumerator = new CameraEnumerator(this);
+    connect(cameraEnumerator, &CameraEnumerator::camerasChanged, this, &BackgroundReplaceWindow::updateCameraList);
+    updateCameraList(CameraEnumerator::cachedCameras());
+    cameraEnumerator->refresh();
     chooseLayout->addWidget(comboBox);
     chooseLayout->setStretchFactor(comboBox, 1);
 
@@ -446,7 +475,84 @@ void BackgroundReplaceWindow::initUI()
     QLabel *cameraTipLabel = new QLabel("请先选择并启动摄像头，再进入下一步。");
     cameraTipLabel->setWordWrap(true);
     cameraTipLabel->setStyleSheet("color: #666;");
+    // 采集格式：USB 2.0 带宽下只有 MJPEG 能跑 1080p30，YUYV 通常只有 5–10 fps。
+    // 选项来自所选摄像头枚举到的模式（见 populateCaptureFormats）
+    QGridLayout *captureFormatLayout = new QGridLayout();
+    captureFormatLayout->addWidget(new QLabel("格式："), 0, 0);
+    captureFormatBox = new QComboBox();
+    captureFormatLayout->addWidget(captureFormatBox, 0, 1);
+    captureFormatLayout->addWidget(new QLabel("分辨率："), 0, 2);
+    captureSizeBox = new QComboBox();
+    captureFormatLayout->addWidget(captureSizeBox, 0, 3);
+    captureFormatLayout->addWidget(new QLabel("帧率："), 1, 0);
+    captureFpsBox = new QComboBox();
+    captureFormatLayout->addWidget(captureFpsBox, 1, 1);
+    captureInfoLabel = new QLabel();
+    captureInfoLabel->setStyleSheet("color: #666;");
+    captureFormatLayout->addWidget(captureInfoLabel, 1, 2, 1, 2);
+    // YUV 直通：NV12 帧不转 BGR，分割、合成、编码都在 NV12 上完成，只在预览时转一次 RGB
+    chkKeepNv12 = new QCheckBox("YUV 直通（NV12）");
+    chkKeepNv12->setToolTip("仅在摄像头以 NV12 输出时生效，省去每帧两次全分辨率颜色转换");
+    chkKeepNv12->setChecked(true);
+    chkKeepNv12->setEnabled(false);
+    connect(captureFormatBox, &QComboBox::currentIndexChanged, this, [this]() {
+        chkKeepNv12->setEnabled(captureFormatBox->currentData().toString() == "NV12");
+        populateCaptureSizes();
+    });
+    connect(captureSizeBox, &QComboBox::currentIndexChanged, this, &BackgroundReplaceWindow::populateCaptureRates);
+    connect(comboBox, &QComboBox::currentIndexChanged, this, &BackgroundReplaceWindow::populateCaptureFormats);
+    populateCaptureFormats();
+    captureFormatLayout->addWidget(chkKeepNv12, 2, 0, 1, 2);
+    captureFormatLayout->setColumnStretch(1, 1);
+    captureFormatLayout->setColumnStretch(3, 1);
+
+    cameraControlLayout->addLayout(sourceLayout);
     cameraControlLayout->addLayout(chooseLayout);
+    cameraControlLayout->addLayout(captureFormatLayout);
+    // 虚拟摄像头：合成结果发布到共享内存（有 v4l2loopback 时同时写入该设备），供会议软件使用
+    QHBoxLayout *virtualCameraLayout = new QHBoxLayout();
+    chkVirtualCamera = new QCheckBox("虚拟摄像头输出");
+    chkVirtualCamera->setToolTip(QString("共享内存名称：%1").arg(VCAM_DEFAULT_NAME));
+    virtualCameraLayout->addWidget(chkVirtualCamera);
+    virtualCameraLabel = new QLabel();
+    virtualCameraLabel->setStyleSheet("color: #666;");
+    virtualCameraLayout->addWidget(virtualCameraLabel, 1);
+    connect(chkVirtualCamera, &QCheckBox::toggled, this, [this](bool enabled) {
+        if (enabled) {
+            startVirtualCamera();
+        } else {
+            stopVirtualCamera();
+        }
+    });
+    cameraControlLayout->addLayout(virtualCameraLayout);
+    // 第二路摄像头：独立采集和合成，推理与主摄像头合并成一个 batch，结果以画中画叠加在右下角
+    QHBoxLayout *secondCameraLayout = new QHBoxLayout();
+    chkSecondCamera = new QCheckBox("第二路摄像头（画中画）");
+    secondCameraLayout->addWidget(chkSecondCamera);
+    secondCameraLayout->addWidget(secondCameraBox, 1);
+    btnSecondBackground = new QPushButton("背景…");
+    btnSecondBackground->setToolTip("第二路的背景图片，不选择时不替换背景");
+    secondCameraLayout->addWidget(btnSecondBackground);
+    secondCameraLabel = new QLabel();
+    secondCameraLabel->setStyleSheet("color: #666;");
+    secondCameraLayout->addWidget(secondCameraLabel);
+    connect(chkSecondCamera, &QCheckBox::toggled, this, [this](bool enabled) {
+        if (enabled) {
+            startSecondCamera();
+        } else {
+            stopSecondCamera();
+        }
+    });
+    connect(btnSecondBackground, &QPushButton::clicked, this, [this]() {
+        const QString path = QFileDialog::getOpenFileName(this, "选择第二路背景图片", QString(),
+                                                          "图片文件 (*.png *.jpg *.jpeg *.bmp);;所有文件 (*)");
+        secondBackgroundPath = path;
+        btnSecondBackground->setToolTip(path.isEmpty() ? "第二路的背景图片，不选择时不替换背景" : path);
+        if (engine.pictureInPicture()) {
+            engine.pictureInPicture()->setBackground(path.toStdString());
+        }
+    });
+    cameraControlLayout->addLayout(secondCameraLayout);
     cameraControlLayout->addWidget(btnCamera);
     cameraControlLayout->addWidget(cameraTipLabel);
     rightLayout->addWidget(cameraControlGroupBox);
@@ -472,8 +578,7 @@ void BackgroundReplaceWindow::initUI()
     connect(fontInputBox, &QLineEdit::textChanged,
             this, [this](const QString &fontName) {
                 if (!fontName.trimmed().isEmpty()) {
-                    QByteArray localFontName = fontName.trimmed().toLocal8Bit();
-                    segmentor->setFontName(std::string(localFontName.constData(), localFontName.size()));
+                    engine.segmentor().setFontName(fontName.trimmed().toStdString());
                 }
             });
     fontInputBox->setText("微软雅黑"); // 默认字体，并触发一次同步
@@ -519,6 +624,28 @@ void BackgroundReplaceWindow::initUI()
     textSettingsLayout->addLayout(posYLayout);
     textSettingsLayout->addLayout(fsLayout);
     textSettingsLayout->addWidget(colorBtn);
+
+    // 动态文字叠加：时钟、录制时长、滚动字幕（会录入视频）
+    QHBoxLayout *liveTextLayout = new QHBoxLayout();
+    chkClock = new QCheckBox("显示时钟");
+    chkRecTimer = new QCheckBox("显示录制时长");
+    connect(chkClock, &QCheckBox::toggled, this, &BackgroundReplaceWindow::updateLiveTextLayers);
+    connect(chkRecTimer, &QCheckBox::toggled, this, &BackgroundReplaceWindow::updateLiveTextLayers);
+    liveTextLayout->addWidget(chkClock);
+    liveTextLayout->addWidget(chkRecTimer);
+    liveTextLayout->addStretch();
+
+    QHBoxLayout *tickerLayout = new QHBoxLayout();
+    chkTicker = new QCheckBox("滚动字幕：");
+    tickerInput = new QLineEdit();
+    tickerInput->setPlaceholderText("请输入滚动字幕内容");
+    connect(chkTicker, &QCheckBox::toggled, this, &BackgroundReplaceWindow::updateLiveTextLayers);
+    connect(tickerInput, &QLineEdit::editingFinished, this, &BackgroundReplaceWindow::updateLiveTextLayers);
+    tickerLayout->addWidget(chkTicker);
+    tickerLayout->addWidget(tickerInput);
+
+    textSettingsLayout->addLayout(liveTextLayout);
+    textSettingsLayout->addLayout(tickerLayout);
     rightLayout->addWidget(textSettingsGroupBox);
 
     fgSettingsGroupBox = new QGroupBox("前景图片设置");
@@ -616,10 +743,132 @@ void BackgroundReplaceWindow::initUI()
     saveDirLayout->addWidget(btnOpenSaveDir);
     creationLayout->addLayout(saveDirLayout);
 
+    // Recording output
+    QGridLayout *recordOptLayout = new QGridLayout();
+    recordOptLayout->addWidget(new QLabel("录制分辨率："), 0, 0);
+    recordSizeBox = new QComboBox();
+    recordSizeBox->addItem("与画面一致", 0);
+    recordSizeBox->addItem("1080p", 1080);
+    recordSizeBox->addItem("720p", 720);
+    recordSizeBox->addItem("480p", 480);
+    recordOptLayout->addWidget(recordSizeBox, 0, 1);
+    recordOptLayout->addWidget(new QLabel("帧率："), 0, 2);
+    recordFpsInput = new QSpinBox();
+    recordFpsInput->setRange(10, 60);
+    recordFpsInput->setValue(30);
+    recordFpsInput->setToolTip("按采集时间戳以可变帧率录制，此值为帧率上限");
+    recordOptLayout->addWidget(recordFpsInput, 0, 3);
+    recordOptLayout->addWidget(new QLabel("编码："), 1, 0);
+    recordCodecBox = new QComboBox();
+    recordCodecBox->addItem("H.264 (mp4)", "h264");
+    recordCodecBox->addItem("MPEG-4 (mp4)", "mpeg4");
+    recordCodecBox->addItem("MJPEG (avi)", "mjpeg");
+    recordOptLayout->addWidget(recordCodecBox, 1, 1);
+    recordOptLayout->addWidget(new QLabel("码率："), 1, 2);
+    recordBitrateInput = new QSpinBox();
+    recordBitrateInput->setRange(0, 50000);
+    recordBitrateInput->setSingleStep(500);
+    recordBitrateInput->setSuffix(" kbps");
+    recordBitrateInput->setSpecialValueText("质量优先");
+    recordBitrateInput->setValue(0);
+    recordOptLayout->addWidget(recordBitrateInput, 1, 3);
+    // H.264 参数：预设越快 CPU 占用越低、文件越大；zerolatency 去掉 B 帧和前瞻，编码延迟最低
+    recordOptLayout->addWidget(new QLabel("预设："), 2, 0);
+    x264PresetBox = new QComboBox();
+    for (const char *preset : {"ultrafast", "superfast", "veryfast", "faster", "fast", "medium"}) {
+        x264PresetBox->addItem(preset, preset);
+    }
+    x264PresetBox->setCurrentText("veryfast");
+    recordOptLayout->addWidget(x264PresetBox, 2, 1);
+    recordOptLayout->addWidget(new QLabel("调优："), 2, 2);
+    x264TuneBox = new QComboBox();
+    x264TuneBox->addItem("zerolatency", "zerolatency");
+    x264TuneBox->addItem("film", "film");
+    x264TuneBox->addItem("无", "");
+    recordOptLayout->addWidget(x264TuneBox, 2, 3);
+    recordOptLayout->addWidget(new QLabel("CRF："), 3, 0);
+    x264CrfInput = new QSpinBox();
+    x264CrfInput->setRange(15, 35);
+    x264CrfInput->setValue(23);
+    x264CrfInput->setToolTip("码率为“质量优先”时生效，越小画质越高、文件越大");
+    recordOptLayout->addWidget(x264CrfInput, 3, 1);
+    recordOptLayout->addWidget(new QLabel("编码线程："), 3, 2);
+    encoderThreadsInput = new QSpinBox();
+    encoderThreadsInput->setRange(0, std::max(1, QThread::idealThreadCount()));
+    encoderThreadsInput->setSpecialValueText(QString("自动 (%1)").arg(defaultEncoderThreads()));
+    encoderThreadsInput->setValue(0);
+    encoderThreadsInput->setToolTip("自动时只占用一半 CPU 核心，其余留给人像分割和预览");
+    recordOptLayout->addWidget(encoderThreadsInput, 3, 3);
+    auto updateCodecWidgets = [this]() {
+        const bool h264 = recordCodecBox->currentData().toString() == "h264";
+        x264PresetBox->setEnabled(h264);
+        x264TuneBox->setEnabled(h264);
+        x264CrfInput->setEnabled(h264 && recordBitrateInput->value() == 0);
+    };
+    connect(recordCodecBox, &QComboBox::currentIndexChanged, this, updateCodecWidgets);
+    connect(recordBitrateInput, &QSpinBox::valueChanged, this, updateCodecWidgets);
+    updateCodecWidgets();
+    // 防崩溃：分片 MP4 随时可播放；分段录制把长时间录制拆成多个文件，结束后可无损合并
+    chkFragmented = new QCheckBox("防崩溃（分片 MP4）");
+    chkFragmented->setChecked(true);
+    chkFragmented->setToolTip("录制中途崩溃或断电时，已写入的内容仍可正常播放");
+    recordOptLayout->addWidget(chkFragmented, 4, 0, 1, 2);
+    recordOptLayout->addWidget(new QLabel("分段时长："), 4, 2);
+    segmentMinutesInput = new QSpinBox();
+    segmentMinutesInput->setRange(0, 120);
+    segmentMinutesInput->setSuffix(" 分钟");
+    segmentMinutesInput->setSpecialValueText("不分段");
+    segmentMinutesInput->setValue(0);
+    recordOptLayout->addWidget(segmentMinutesInput, 4, 3);
+    chkMergeSegments = new QCheckBox("结束后无损合并分段");
+    chkMergeSegments->setChecked(true);
+    recordOptLayout->addWidget(chkMergeSegments, 5, 0, 1, 4);
+    connect(segmentMinutesInput, &QSpinBox::valueChanged, this, [this](int minutes) {
+        chkMergeSegments->setEnabled(minutes > 0);
+    });
+    chkMergeSegments->setEnabled(false);
+    // 即时回放：后台持续编码最近一段画面，按 F9 把已编码的数据包直接写成文件
+    chkReplay = new QCheckBox("即时回放（F9 保存）");
+    chkReplay->setToolTip("常驻内存保留最近一段已编码的音视频，按 F9 保存，不影响正在进行的录制");
+    recordOptLayout->addWidget(chkReplay, 6, 0, 1, 2);
+    recordOptLayout->addWidget(new QLabel("回放时长："), 6, 2);
+    replaySecondsInput = new QSpinBox();
+    replaySecondsInput->setRange(5, 300);
+    replaySecondsInput->setSuffix(" 秒");
+    replaySecondsInput->setValue(30);
+    recordOptLayout->addWidget(replaySecondsInput, 6, 3);
+    replayStatusLabel = new QLabel();
+    replayStatusLabel->setWordWrap(true);
+    replayStatusLabel->setStyleSheet("color: #7f8c8d;");
+    recordOptLayout->addWidget(replayStatusLabel, 7, 0, 1, 4);
+    connect(chkReplay, &QCheckBox::toggled, this, [this](bool enabled) {
+        if (enabled) {
+            startReplay();
+        } else {
+            stopReplay();
+        }
+    });
+    connect(replaySecondsInput, &QSpinBox::valueChanged, this, [this](int seconds) {
+        if (engine.replay()) {
+            engine.replay()->setDuration(seconds);
+        }
+    });
+    recordOptLayout->setColumnStretch(1, 1);
+    creationLayout->addLayout(recordOptLayout);
+
+    // Encoder queue overflow policy
+    QHBoxLayout *overflowLayout = new QHBoxLayout();
+    overflowLayout->addWidget(new QLabel("编码跟不上时："));
+    overflowPolicyBox = new QComboBox();
+    overflowPolicyBox->addItem("丢弃最旧帧（保证预览流畅）", static_cast<int>(QueueOverflowPolicy::DropOldest));
+    overflowPolicyBox->addItem("等待编码（不丢帧）", static_cast<int>(QueueOverflowPolicy::Block));
+    overflowLayout->addWidget(overflowPolicyBox, 1);
+    creationLayout->addLayout(overflowLayout);
+
     audioRec = new audioRecorder();
     creationLayout->addWidget(audioRec);
 
-    QLabel *hotkeyHintLabel = new QLabel("热键提示：F11 全屏切换，F12 开始/停止录制，ESC 切换上一张背景图");
+    QLabel *hotkeyHintLabel = new QLabel("热键提示：F11 全屏切换，F12 开始/停止录制，F9 保存即时回放，ESC 切换上一张背景图");
     hotkeyHintLabel->setWordWrap(true);
     hotkeyHintLabel->setStyleSheet("color: #2c3e50; background: #ecf4ff; border: 1px solid #b5d3ff; border-radius: 6px; padding: 8px;");
     creationLayout->addWidget(hotkeyHintLabel);
@@ -658,7 +907,7 @@ void BackgroundReplaceWindow::initUI()
     });
     connect(setupNextBtn, &QPushButton::clicked, this, [this]() {
         if (currentSetupStep == 0) {
-            if (!camera || !camera->isOpened()) {
+            if (!engine.isSourceOpen()) {
                 QMessageBox::warning(this, "提示", "请先选择并启动摄像头，再进入下一步。");
                 return;
             }
@@ -697,7 +946,7 @@ QWidget* BackgroundReplaceWindow::createWizardHeader()
     layout->setAlignment(Qt::AlignLeft | Qt::AlignVCenter);
     
     QLabel *logoLabel = new QLabel();
-    QPixmap logoPixmap("e:\\Qt-projects\\BgCam\\BgCamCPP\\build\\Desktop_Qt_6_10_1_MinGW_64_bit-Release\\release\\icon.png");
+    QPixmap logoPixmap(QCoreApplication::applicationDirPath() + "/icon.png");
     if (!logoPixmap.isNull()) {
         logoLabel->setPixmap(logoPixmap.scaled(80, 80, Qt::KeepAspectRatio, Qt::SmoothTransformation));
     }
@@ -729,13 +978,13 @@ void BackgroundReplaceWindow::applyBackgroundSelection()
             carouselTimer->stop();
         }
         if (!imagePaths.empty()) {
-            segmentor->setBackground(imagePaths[imgIndex], "image");
+            engine.segmentor().setBackground(imagePaths[imgIndex], "image");
             currentBgPath = QString::fromStdString(imagePaths[imgIndex]);
         }
     } else if (radioVideo->isChecked()) {
         carouselTimer->stop();
         if (!currentBgPath.isEmpty()) {
-            segmentor->setBackground(currentBgPath.toStdString(), "video");
+            engine.segmentor().setBackground(currentBgPath.toStdString(), "video");
         }
     }
 }
@@ -805,46 +1054,70 @@ void BackgroundReplaceWindow::addFgImage()
         this,
         "选择前景图片",
         QDir::currentPath(),
-        "图片文件 (*.png *.jpg *.jpeg *.bmp)"
+        "图片文件 (*.png *.apng *.gif *.webp *.jpg *.jpeg *.bmp)"
     );
 
     if (!fgPath.isEmpty()) {
-        std::string pathStr = fgPath.toLocal8Bit().toStdString();
-        fgImage = cv::imread(pathStr, cv::IMREAD_UNCHANGED); // Keep alpha channel if png
-        if (fgImage.empty()) {
-            // try to load with unicode support
-            std::wstring wpath(pathStr.begin(), pathStr.end());
-            FILE* fp = _wfopen(wpath.c_str(), L"rb");
-            if (fp) {
-                fseek(fp, 0, SEEK_END);
-                long size = ftell(fp);
-                fseek(fp, 0, SEEK_SET);
-                std::vector<char> buf(size);
-                fread(buf.data(), 1, size, fp);
-                fclose(fp);
-                fgImage = cv::imdecode(cv::Mat(buf), cv::IMREAD_UNCHANGED);
+        // 动图（GIF/APNG）在加载时一次性解码全部帧，缩放到画面尺寸以内并限制内存；
+        // 解码可能要数百毫秒，作为后台任务交给调度器，不占用处理当前帧的线程，完成后回到 GUI 线程添加图层
+        const cv::Size displaySize(camWidth > 0 ? camWidth : 1920, camHeight > 0 ? camHeight : 1080);
+        btnAddFgImage->setEnabled(false);
+        QPointer<BackgroundReplaceWindow> self(this);
+        TaskScheduler::instance().submit([self, fgPath, displaySize]() {
+            auto animation = std::make_shared<AnimatedFrames>();
+            loadAnimatedSticker(fgPath.toLocal8Bit().toStdString(), displaySize, FG_ANIMATION_MEMORY_CAP / 2, *animation);
+            cv::Mat fgImage = animation->frames.empty() ? cv::Mat() : animation->frames.front();
+            if (fgImage.empty()) {
+                // 路径含非 ASCII 字符时 OpenCV 可能打不开，读出文件内容再解码
+                QFile file(fgPath);
+                if (file.open(QIODevice::ReadOnly)) {
+                    const QByteArray data = file.readAll();
+                    const std::vector<uchar> buf(data.begin(), data.end());
+                    fgImage = cv::imdecode(buf, cv::IMREAD_UNCHANGED);
+                }
             }
+            QMetaObject::invokeMethod(qApp, [self, animation, fgImage]() {
+                if (self) {
+                    self->applyFgImage(std::move(*animation), fgImage);
+                }
+            }, Qt::QueuedConnection);
+        }, TaskPriority::Background);
+    }
+}
+
+void BackgroundReplaceWindow::applyFgImage(AnimatedFrames animation, const cv::Mat &fgImage)
+{
+    btnAddFgImage->setEnabled(true);
+    if (!fgImage.empty()) {
+        QMessageBox::information(this, "成功", "前景图片加载成功，可用方向键移动，+/-缩放。");
+        fgX = 0;
+        fgY = 0;
+        fgScale = 1.0;
+        fgOpacity = 1.0;
+        if (fgLayerId >= 0) {
+            engine.overlays().removeLayer(fgLayerId);
         }
-        if (!fgImage.empty()) {
-            QMessageBox::information(this, "成功", "前景图片加载成功，可用方向键移动，+/-缩放。");
-            fgX = 0;
-            fgY = 0;
-            fgScale = 1.0;
-            fgOpacity = 1.0;
-            btnClearFgImage->setEnabled(true);
-            fgScaleSlider->setValue(100);
-            fgScaleSlider->setEnabled(true);
-            fgOpacitySlider->setValue(100);
-            fgOpacitySlider->setEnabled(true);
+        if (animation.isAnimated()) {
+            fgLayerId = engine.overlays().addAnimatedLayer(std::move(animation), fgX, fgY);
         } else {
-            QMessageBox::critical(this, "错误", "加载前景图片失败！");
+            fgLayerId = engine.overlays().addImageLayer(fgImage, fgX, fgY);
         }
+        btnClearFgImage->setEnabled(true);
+        fgScaleSlider->setValue(100);
+        fgScaleSlider->setEnabled(true);
+        fgOpacitySlider->setValue(100);
+        fgOpacitySlider->setEnabled(true);
+    } else {
+        QMessageBox::critical(this, "错误", "加载前景图片失败！");
     }
 }
 
 void BackgroundReplaceWindow::clearFgImage()
 {
-    fgImage.release();
+    if (fgLayerId >= 0) {
+        engine.overlays().removeLayer(fgLayerId);
+        fgLayerId = -1;
+    }
     fgX = 0;
     fgY = 0;
     fgScale = 1.0;
@@ -879,25 +1152,28 @@ void BackgroundReplaceWindow::chooseSaveDirectory()
 void BackgroundReplaceWindow::updateFgScale(int value)
 {
     fgScale = value / 100.0;
+    engine.overlays().setScale(fgLayerId, fgScale);
 }
 
 void BackgroundReplaceWindow::updateFgOpacity(int value)
 {
     fgOpacity = value / 100.0;
+    engine.overlays().setOpacity(fgLayerId, fgOpacity);
 }
 
 void BackgroundReplaceWindow::moveForegroundBy(int dx, int dy)
 {
-    if (fgImage.empty()) {
+    if (fgLayerId < 0) {
         return;
     }
     fgX += dx;
     fgY += dy;
+    engine.overlays().setPosition(fgLayerId, fgX, fgY);
 }
 
 void BackgroundReplaceWindow::adjustForegroundScale(int delta)
 {
-    if (fgImage.empty() || !fgScaleSlider->isEnabled()) {
+    if (fgLayerId < 0 || !fgScaleSlider->isEnabled()) {
         return;
     }
     fgScaleSlider->setValue(qBound(fgScaleSlider->minimum(),
@@ -907,11 +1183,12 @@ void BackgroundReplaceWindow::adjustForegroundScale(int delta)
 
 void BackgroundReplaceWindow::resetForegroundPosition()
 {
-    if (fgImage.empty()) {
+    if (fgLayerId < 0) {
         return;
     }
     fgX = 0;
     fgY = 0;
+    engine.overlays().setPosition(fgLayerId, fgX, fgY);
 }
 
 void BackgroundReplaceWindow::updateRecordingStatusOverlay()
@@ -936,14 +1213,69 @@ void BackgroundReplaceWindow::updateRecordingStatusOverlay()
         .arg(minutes, 2, 10, QChar('0'))
         .arg(seconds, 2, 10, QChar('0'));
 
-    QString infoStr = QString("REC  %1\nFPS  %2")
+    QString infoStr = QString("REC  %1\nFPS  %2\nALLOC  %3/s")
         .arg(timeStr)
-        .arg(currentFPS, 0, 'f', 1);
+        .arg(currentFPS, 0, 'f', 1)
+        .arg(poolAllocRate, 0, 'f', 0);
+    if (engine.recorder()) {
+        const EncoderStats stats = engine.recorder()->stats();
+        infoStr += QString("\nQUEUE  %1/%2 (max %3)\nENC  %4 ms  DROP  %5")
+            .arg(stats.queueDepth)
+            .arg(stats.capacity)
+            .arg(stats.maxQueueDepth)
+            .arg(stats.avgEncodeMs, 0, 'f', 1)
+            .arg(stats.droppedFrames);
+    }
     recordStatusLabel->setText(infoStr);
     recordStatusLabel->show();
     recordStatusLabel->raise();
 }
 
+RecordingOptions BackgroundReplaceWindow::currentRecordingOptions() const
+{
+    RecordingOptions options;
+    const int srcWidth = camWidth > 0 ? camWidth : 640;
+    const int srcHeight = camHeight > 0 ? camHeight : 480;
+    const int targetHeight = recordSizeBox->currentData().toInt();
+    if (targetHeight <= 0 || targetHeight == srcHeight) {
+        options.frameSize = cv::Size(srcWidth, srcHeight);
+    } else {
+        // 保持画面宽高比，宽高取偶数以兼容 YUV420 编码器
+        const int width = static_cast<int>(std::lround(srcWidth * static_cast<double>(targetHeight) / srcHeight));
+        options.frameSize = cv::Size(width & ~1, targetHeight & ~1);
+    }
+    options.fps = recordFpsInput->value();
+    options.codec = recordCodecBox->currentData().toString().toStdString();
+    options.preset = x264PresetBox->currentData().toString().toStdString();
+    options.tune = x264TuneBox->currentData().toString().toStdString();
+    options.crf = x264CrfInput->value();
+    options.threads = encoderThreadsInput->value() > 0 ? encoderThreadsInput->value() : defaultEncoderThreads();
+    options.fragmented = chkFragmented->isChecked();
+    options.segmentMinutes = segmentMinutesInput->value();
+    options.bitrateKbps = recordBitrateInput->value();
+    options.nv12Input = engine.outputNv12();
+    return options;
+}
+
+CaptureFormat BackgroundReplaceWindow::currentCaptureFormat() const
+{
+    CaptureFormat format;
+    const QSize size = captureSizeBox->currentData().toSize();
+    if (size.isValid()) {
+        format.size = cv::Size(size.width(), size.height());
+    }
+    format.fps = captureFpsBox->currentData().toInt();
+    format.fourcc = captureFormatBox->currentData().toString().toStdString();
+    format.keepNv12 = chkKeepNv12->isChecked();
+    return format;
+}
+
+int BackgroundReplaceWindow::defaultEncoderThreads()
+{
+    // 编码与人像分割、预览共用 CPU，默认只给编码器一半核心
+    return std::max(1, QThread::idealThreadCount() / 2);
+}
+
 void BackgroundReplaceWindow::keyPressEvent(QKeyEvent *event)
 {
     switch (event->key()) {
@@ -957,6 +1289,9 @@ void BackgroundReplaceWindow::keyPressEvent(QKeyEvent *event)
                 toggleRecording();
             }
             break;
+        case Qt::Key_F9:
+            saveReplay();
+            break;
         case Qt::Key_Escape:
             if (radioImg->isChecked() && imagePaths.size() > 0) {
                 int currentRow = imageListWidget ? imageListWidget->currentRow() : -1;
@@ -1014,8 +1349,8 @@ void BackgroundReplaceWindow::toggleFullScreenPreview()
             previewContainer->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
             previewContainer->setMinimumSize(targetWidth, targetHeight);
             previewContainer->setMaximumSize(targetWidth, targetHeight);
-            cameraLabel->setMinimumSize(targetWidth, targetHeight);
-            cameraLabel->setMaximumSize(targetWidth, targetHeight);
+            cameraPreview->setMinimumSize(targetWidth, targetHeight);
+            cameraPreview->setMaximumSize(targetWidth, targetHeight);
         }
         showFullScreen();
         isPreviewFullScreen = true;
@@ -1070,8 +1405,8 @@ void BackgroundReplaceWindow::updateCameraPreviewSize(int frameWidth, int frameH
         previewContainer->setMinimumSize(targetWidth, targetHeight);
         previewContainer->setMaximumSize(targetWidth, targetHeight);
     }
-    cameraLabel->setMinimumSize(targetWidth, targetHeight);
-    cameraLabel->setMaximumSize(targetWidth, targetHeight);
+    cameraPreview->setMinimumSize(targetWidth, targetHeight);
+    cameraPreview->setMaximumSize(targetWidth, targetHeight);
     cameraGroupBox->adjustSize();
 
     // 动态调整主窗口大小以适配预览分辨率
@@ -1109,71 +1444,111 @@ void BackgroundReplaceWindow::updateCameraPreviewSize(int frameWidth, int frameH
         this->setFixedSize(totalWidth, totalHeight);
     }
 
-    cameraLabel->updateGeometry();
+    cameraPreview->updateGeometry();
     cameraGroupBox->updateGeometry();
     camWidget->updateGeometry();
 }
 
-void BackgroundReplaceWindow::drawForeground(cv::Mat &frame)
+void BackgroundReplaceWindow::updateLiveTextLayers()
 {
-    if (fgImage.empty()) return;
-
-    cv::Mat resizedFg;
-    cv::resize(fgImage, resizedFg, cv::Size(), fgScale, fgScale);
+    const std::string fontName = fontInputBox->text().trimmed().toStdString();
+    const cv::Scalar white(255, 255, 255);
+
+    // 时钟：右上角
+    if (chkClock->isChecked() && clockLayerId < 0) {
+        clockLayerId = engine.overlays().addLiveTextLayer(QTime::currentTime().toString("hh:mm:ss").toStdString(),
+                                                 0, 0, LIVE_TEXT_SIZE, fontName, white, 10);
+    } else if (!chkClock->isChecked() && clockLayerId >= 0) {
+        engine.overlays().removeLayer(clockLayerId);
+        clockLayerId = -1;
+    }
 
-    int startX = fgX;
-    int startY = fgY;
+    // 录制时长：时钟下方，仅录制时可见
+    if (chkRecTimer->isChecked() && recTimerLayerId < 0) {
+        recTimerLayerId = engine.overlays().addLiveTextLayer("REC 00:00:00", 0, 0, LIVE_TEXT_SIZE,
+                                                    fontName, cv::Scalar(60, 60, 255), 10);
+        engine.overlays().setVisible(recTimerLayerId, isRecording);
+    } else if (!chkRecTimer->isChecked() && recTimerLayerId >= 0) {
+        engine.overlays().removeLayer(recTimerLayerId);
+        recTimerLayerId = -1;
+    }
 
-    for (int y = 0; y < resizedFg.rows; ++y) {
-        int frameY = startY + y;
-        if (frameY < 0 || frameY >= frame.rows) continue;
+    // 滚动字幕：底部半透明底板 + 横向滚动文字
+    const std::string tickerText = tickerInput->text().trimmed().toStdString();
+    const bool wantTicker = chkTicker->isChecked() && !tickerText.empty();
+    if (wantTicker && tickerLayerId < 0) {
+        tickerBandLayerId = engine.overlays().addSolidLayer(cv::Size(1, 1), cv::Scalar(0, 0, 0), 0, 0, 8);
+        engine.overlays().setOpacity(tickerBandLayerId, 0.5);
+        tickerLayerId = engine.overlays().addTickerLayer(tickerText, 0, LIVE_TEXT_SIZE, fontName, white,
+                                                TICKER_SPEED, 9);
+    } else if (wantTicker) {
+        engine.overlays().setText(tickerLayerId, tickerText);
+    } else if (tickerLayerId >= 0) {
+        engine.overlays().removeLayer(tickerLayerId);
+        engine.overlays().removeLayer(tickerBandLayerId);
+        tickerLayerId = -1;
+        tickerBandLayerId = -1;
+    }
+    layoutLiveTextLayers();
+}
 
-        for (int x = 0; x < resizedFg.cols; ++x) {
-            int frameX = startX + x;
-            if (frameX < 0 || frameX >= frame.cols) continue;
+void BackgroundReplaceWindow::layoutLiveTextLayers()
+{
+    // 按当前画面尺寸摆放时钟、录制计时和滚动字幕；帧源重新打开（分辨率可能变化）后再调用一次
+    const int width = camWidth > 0 ? camWidth : 640;
+    const int height = camHeight > 0 ? camHeight : 480;
+    if (clockLayerId >= 0) {
+        engine.overlays().setPosition(clockLayerId, width - LIVE_TEXT_SIZE * 5, 20);
+    }
+    if (recTimerLayerId >= 0) {
+        engine.overlays().setPosition(recTimerLayerId, width - LIVE_TEXT_SIZE * 7, 30 + LIVE_TEXT_SIZE * 3 / 2);
+    }
+    if (tickerLayerId >= 0) {
+        const int bandHeight = LIVE_TEXT_SIZE * 2;
+        engine.overlays().setSolidSize(tickerBandLayerId, cv::Size(width, bandHeight));
+        engine.overlays().setPosition(tickerBandLayerId, 0, height - bandHeight);
+        engine.overlays().setPosition(tickerLayerId, 0, height - bandHeight + LIVE_TEXT_SIZE / 2);
+    }
+}
 
-            if (resizedFg.channels() == 4) {
-                cv::Vec4b fgPixel = resizedFg.at<cv::Vec4b>(y, x);
-                double alpha = (fgPixel[3] / 255.0) * fgOpacity;
-                
-                if (alpha > 0) {
-                    cv::Vec3b &bgPixel = frame.at<cv::Vec3b>(frameY, frameX);
-                    for (int c = 0; c < 3; ++c) {
-                        bgPixel[c] = static_cast<uchar>(fgPixel[c] * alpha + bgPixel[c] * (1.0 - alpha));
-                    }
-                }
-            } else {
-                cv::Vec3b fgPixel = resizedFg.at<cv::Vec3b>(y, x);
-                double alpha = fgOpacity;
-                cv::Vec3b &bgPixel = frame.at<cv::Vec3b>(frameY, frameX);
-                for (int c = 0; c < 3; ++c) {
-                    bgPixel[c] = static_cast<uchar>(fgPixel[c] * alpha + bgPixel[c] * (1.0 - alpha));
-                }
-            }
+void BackgroundReplaceWindow::refreshLiveTextLayers()
+{
+    // 每帧调用：文字不变时 setText 直接返回，变化时只重画变化的字符
+    if (clockLayerId >= 0) {
+        engine.overlays().setText(clockLayerId, QTime::currentTime().toString("hh:mm:ss").toStdString());
+    }
+    if (recTimerLayerId >= 0) {
+        engine.overlays().setVisible(recTimerLayerId, isRecording);
+        if (isRecording) {
+            const qint64 elapsedSec = (QDateTime::currentMSecsSinceEpoch() - recordStartTime) / 1000;
+            engine.overlays().setText(recTimerLayerId, QString("REC %1:%2:%3")
+                                                  .arg(elapsedSec / 3600, 2, 10, QChar('0'))
+                                                  .arg((elapsedSec / 60) % 60, 2, 10, QChar('0'))
+                                                  .arg(elapsedSec % 60, 2, 10, QChar('0'))
+                                                  .toStdString());
         }
     }
 }
 
 void BackgroundReplaceWindow::onTextChanged(const QString &text)
 {
-    //std::string stdStr=text.toStdString(); //UTF-8直接转换
-    std::string gbk_str(text.toLocal8Bit().data());
-    segmentor->setTitle(gbk_str);
+    // FreeType 渲染器直接使用 UTF-8
+    engine.segmentor().setTitle(text.toStdString());
 }
 
 void BackgroundReplaceWindow::onPosXChanged(int value)
 {
-    segmentor->setTitleX(value);
+    engine.segmentor().setTitleX(value);
 }
 
 void BackgroundReplaceWindow::onPosYChanged(int value)
 {
-    segmentor->setTitleY(value);
+    engine.segmentor().setTitleY(value);
 }
 
 void BackgroundReplaceWindow::onFontSizeChanged(int value)
 {
-    segmentor->setFontSize(value);
+    engine.segmentor().setFontSize(value);
 }
 
 void BackgroundReplaceWindow::chooseColor()
@@ -1188,14 +1563,14 @@ void BackgroundReplaceWindow::chooseColor()
 
     if (color.isValid()) {
         std::tuple<int, int, int> rgb = std::make_tuple(color.red(), color.green(), color.blue());
-        segmentor->setRgb(rgb);
+        engine.segmentor().setRgb(rgb);
     }
 }
 
 void BackgroundReplaceWindow::toggleRecording()
 {
     // ========== 检查摄像头是否已启动 ==========
-    if (!camera || !camera->isOpened()) {
+    if (!engine.isSourceOpen()) {
         QMessageBox::warning(this, "警告", "请先启动摄像头再录制！");
         return;
     }
@@ -1211,74 +1586,53 @@ void BackgroundReplaceWindow::toggleRecording()
             return;
         }
 
-        QString timestamp = QDateTime::currentDateTime().toString("yyyyMMddhhmmss");
-        QString videoPath = QDir(dirPath).filePath(timestamp + ".mp4");
+        const RecordingOptions options = currentRecordingOptions();
+        const QString codecName = QString::fromStdString(options.codec);
 
+        // 音视频在进程内编码并直接封装进最终文件，不再生成临时文件
+        QString timestamp = QDateTime::currentDateTime().toString("yyyyMMddhhmmss");
+        QString videoPath = QDir(dirPath).filePath(timestamp + (codecName == "mjpeg" ? ".avi" : ".mp4"));
         savePath = videoPath;
-        if(videoPath.endsWith(".mp4", Qt::CaseInsensitive)){
-            videoPath = extractDirPathQt(videoPath) + "tempVideo.mp4";
-        }
-        else{
-            videoPath = extractDirPathQt(videoPath) + "tempVideo.avi";
-        }
-        // ========== 开始录制 ==========
-        isRecording = true;
-        recordStartTime = QDateTime::currentMSecsSinceEpoch();
-        writtenFrames = 0;
-        audioRec->toggleRecord(extractDirPathQt(videoPath));
-        recordBtn->setText("停止录制");
-        updateRecordingStatusOverlay();
 
-        // ========== 获取摄像头画面的分辨率（强制为640x480，确保兼容性） ==========
+        const QAudioFormat audioFormat = audioRec->captureFormat();
+        MuxerAudioFormat muxerAudio;
+        muxerAudio.sampleRate = audioFormat.sampleRate();
+        muxerAudio.channels = audioFormat.channelCount();
+
         try {
-            // 固定FPS为30.0，分辨率为640x480，确保兼容性
-            const int width = camWidth;
-            const int height = camHeight;
-            const double fps = RECORD_FPS;
-            
-            // 根据用户选择的文件后缀自动选择编码格式
-            QFileInfo fileInfo(videoPath);
-            QString extension = fileInfo.suffix().toLower();
-            
-            int fourcc;
-            if (extension == "avi") {
-                fourcc = cv::VideoWriter::fourcc('X', 'V', 'I', 'D');  // AVI编码
+            // ========== 创建编码线程 ==========
+            const auto policy = static_cast<QueueOverflowPolicy>(overflowPolicyBox->currentData().toInt());
+            std::string error;
+            if (!engine.startRecording(videoPath.toStdString(), options, audioFormat.isValid() ? &muxerAudio : nullptr,
+                                       ENCODE_QUEUE_CAPACITY, policy, &error)) {
+                throw std::runtime_error(error);
+            }
+            if (audioFormat.isValid()) {
+                if (!startAudioCapture()) {
+                    qDebug() << "麦克风打开失败，本次录制没有声音" << '\n';
+                }
             } else {
-                fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');  // 默认MP4编码
+                qDebug() << "未检测到麦克风，本次录制没有声音" << '\n';
             }
 
-            // ========== 创建VideoWriter ==========
-            videoWriter = new cv::VideoWriter(
-                videoPath.toStdString(),
-                fourcc,
-                fps,
-                cv::Size(width, height)
-            );
-            
-            if (!videoWriter->isOpened()) {
-                throw std::runtime_error("视频写入器创建失败，请检查路径权限或编码格式");
-            }
-            
             recordFilename = videoPath.toStdString();
             qDebug() << "开始录制：" << videoPath << '\n';
-            qDebug() << "FPS：" << fps << "，分辨率：" << width << "x" << height << '\n';
-            
+            qDebug() << "编码器：" << QString::fromStdString(engine.recorder()->videoEncoderName())
+                     << "，预设：" << QString::fromStdString(options.preset) << "，线程：" << options.threads << '\n';
+            qDebug() << "FPS：" << options.fps << "，分辨率：" << options.frameSize.width << "x" << options.frameSize.height
+                     << "，编码：" << codecName << "，码率：" << options.bitrateKbps << "kbps" << '\n';
+
         } catch (const std::exception &e) {
-            QMessageBox::critical(this, "错误", QString("创建录制文件失败：%1").arg(e.what()));
-            isRecording = false;
-            if (currentSetupStep == 3) {
-                recordBtn->setText("开始创作");
-            } else {
-                recordBtn->setText("开始录制");
-            }
-            updateRecordingStatusOverlay();
-            if (videoWriter) {
-                delete videoWriter;
-                videoWriter = nullptr;
-            }
+            QMessageBox::critical(this, "错误", QString("创建录制文件失败：%1").arg(QString::fromStdString(e.what())));
+            engine.stopRecording();
             return;
         }
-        
+
+        // ========== 开始录制 ==========
+        isRecording = true;
+        recordStartTime = QDateTime::currentMSecsSinceEpoch();
+        recordBtn->setText("停止录制");
+        updateRecordingStatusOverlay();
     } else {
         // ========== 停止录制 ==========
         isRecording = false;
@@ -1288,15 +1642,218 @@ void BackgroundReplaceWindow::toggleRecording()
             recordBtn->setText("开始录制");
         }
         updateRecordingStatusOverlay();
-        // 释放视频写入器
-        if (videoWriter) {
-            videoWriter->release();
-            delete videoWriter;
-            videoWriter = nullptr;
+        // 先停止麦克风（即时回放仍在使用时保持采集），再编码完队列中剩余的帧并写入文件尾
+        if (!engine.isReplayActive()) {
+            audioRec->stop();
+        }
+        QStringList segments;
+        for (const std::string &segment : engine.stopRecording()) {
+            segments << QString::fromStdString(segment);
         }
-        audioRec->saveAudio();
-        startMix(savePath);
-        qDebug() << "录制已停止，开始混合音视频：" << savePath << '\n';
+        qDebug() << "录制已停止：" << segments << '\n';
+
+        if (segments.size() == 1 && segments.first() != savePath) {
+            // 分段录制但只产生了一个分段，直接改名为最终文件；QFile::rename 不覆盖，保存对话框已确认过覆盖
+            if (QFile::exists(savePath)) {
+                QFile::remove(savePath);
+            }
+            if (!QFile::rename(segments.first(), savePath)) {
+                QMessageBox::warning(this, "提示",
+                                     QString("无法写入 %1，录像保留在分段文件中").arg(savePath));
+                showRecordingSaved(segments.first());
+                return;
+            }
+        } else if (segments.size() > 1 && chkMergeSegments->isChecked()) {
+            mergeSegments(segments, savePath);
+            return;
+        }
+        showRecordingSaved(segments.size() > 1 ? segments.first() : savePath);
+    }
+}
+
+void BackgroundReplaceWindow::mergeSegments(const QStringList &segments, const QString &target)
+{
+    // 无损合并只拷贝码流，仍可能需要数秒，放到后台线程避免卡住预览
+    std::vector<std::string> inputs;
+    for (const QString &segment : segments) {
+        inputs.push_back(segment.toStdString());
+    }
+    auto error = std::make_shared<std::string>();
+    auto ok = std::make_shared<bool>(false);
+    QThread *mergeThread = QThread::create([inputs, target, error, ok]() {
+        *ok = MediaMuxer::concatSegments(inputs, target.toStdString(), error.get());
+    });
+    connect(mergeThread, &QThread::finished, this, [this, segments, target, error, ok]() {
+        if (*ok) {
+            for (const QString &segment : segments) {
+                QFile::remove(segment);
+            }
+            showRecordingSaved(target);
+        } else {
+            QMessageBox::warning(this, "提示",
+                                 QString("分段合并失败，分段文件已保留：%1").arg(QString::fromStdString(*error)));
+            showRecordingSaved(segments.first());
+        }
+    });
+    startFileThread(mergeThread);
+}
+
+void BackgroundReplaceWindow::startFileThread(QThread *thread)
+{
+    // 线程对象挂在窗口下：窗口先于 finished 槽析构时也能随之释放
+    thread->setParent(this);
+    fileThreads.append(thread);
+    connect(thread, &QThread::finished, this, [this, thread]() {
+        fileThreads.removeOne(thread);
+        thread->deleteLater();
+    });
+    thread->start();
+}
+
+void BackgroundReplaceWindow::waitFileThreads()
+{
+    // 退出时让正在写的合并文件、回放文件写完，避免留下半截文件或在线程运行中析构 QThread
+    for (QThread *thread : std::as_const(fileThreads)) {
+        thread->wait();
+    }
+}
+
+bool BackgroundReplaceWindow::startAudioCapture()
+{
+    // 录制与即时回放共用一路麦克风采集，数据在 GUI 线程拷贝进各编码器的音频缓冲，编码在编码线程完成
+    if (audioRec->isActive()) {
+        return true;
+    }
+    return audioRec->start([this](const int16_t *samples, int frames, int64_t arrivalUs) {
+        engine.pushAudio(samples, frames, arrivalUs);
+    });
+}
+
+void BackgroundReplaceWindow::startReplay()
+{
+    if (engine.isReplayActive() || !chkReplay->isChecked() || !engine.isSourceOpen()) {
+        return; // 摄像头启动时再开始
+    }
+    const QAudioFormat audioFormat = audioRec->captureFormat();
+    MuxerAudioFormat muxerAudio;
+    muxerAudio.sampleRate = audioFormat.sampleRate();
+    muxerAudio.channels = audioFormat.channelCount();
+
+    std::string error;
+    if (!engine.startReplay(currentRecordingOptions(), audioFormat.isValid() ? &muxerAudio : nullptr,
+                            replaySecondsInput->value(), REPLAY_MEMORY_CAP, &error)) {
+        replayStatusLabel->setText(QString("即时回放启动失败：%1").arg(QString::fromStdString(error)));
+        return;
+    }
+    if (audioFormat.isValid() && !startAudioCapture()) {
+        qDebug() << "麦克风打开失败，即时回放没有声音" << '\n';
+    }
+    replayStatusLabel->setText(QString("即时回放已开启：保留最近 %1 秒").arg(replaySecondsInput->value()));
+}
+
+void BackgroundReplaceWindow::stopReplay()
+{
+    if (!engine.isReplayActive()) {
+        return;
+    }
+    if (!engine.isRecording() && audioRec) {
+        audioRec->stop();
+    }
+    engine.stopReplay();
+    if (replayStatusLabel) {
+        replayStatusLabel->clear();
+    }
+}
+
+void BackgroundReplaceWindow::startVirtualCamera()
+{
+    if (engine.virtualCamera() || !chkVirtualCamera->isChecked() || !engine.isSourceOpen()) {
+        return; // 摄像头启动时再开始
+    }
+    if (!engine.startVirtualCamera()) {
+        virtualCameraLabel->setText("虚拟摄像头启动失败");
+        return;
+    }
+    const QString loopback = QString::fromStdString(engine.virtualCamera()->loopbackDevice());
+    virtualCameraLabel->setText(loopback.isEmpty() ? "共享内存输出中" : QString("共享内存 + %1").arg(loopback));
+}
+
+void BackgroundReplaceWindow::stopVirtualCamera()
+{
+    engine.stopVirtualCamera();
+    if (virtualCameraLabel) {
+        virtualCameraLabel->clear();
+    }
+}
+
+void BackgroundReplaceWindow::startSecondCamera()
+{
+    if (engine.pictureInPicture() || !chkSecondCamera->isChecked() || !engine.isSourceOpen()) {
+        return; // 主摄像头启动时再开始
+    }
+    if (secondCameraBox->currentIndex() < 0) {
+        secondCameraLabel->setText("没有可用的摄像头");
+        return;
+    }
+    // 画中画只占画面的三分之一，第二路用较低的分辨率采集
+    CaptureFormat format;
+    format.size = cv::Size(640, 480);
+    if (!engine.startPictureInPicture(secondCameraBox->currentData().toInt(), format,
+                                      secondBackgroundPath.toStdString())) {
+        secondCameraLabel->setText("无法打开");
+        return;
+    }
+    secondCameraLabel->setText("运行中");
+}
+
+void BackgroundReplaceWindow::stopSecondCamera()
+{
+    engine.stopPictureInPicture();
+    if (secondCameraLabel) {
+        secondCameraLabel->clear();
+    }
+}
+
+void BackgroundReplaceWindow::saveReplay()
+{
+    if (!engine.replay()) {
+        return;
+    }
+    const QString dirPath = saveDirInput ? saveDirInput->text().trimmed() : QString();
+    if (dirPath.isEmpty() || !QDir(dirPath).exists()) {
+        replayStatusLabel->setText("请先选择有效的视频保存目录");
+        return;
+    }
+    // 快照只增加数据包引用，写文件在后台线程完成，编码和预览不受影响
+    auto clip = std::make_shared<ReplayClip>(engine.replay()->snapshot());
+    if (clip->empty()) {
+        replayStatusLabel->setText("回放缓冲区还是空的");
+        return;
+    }
+    const QString path = QDir(dirPath).filePath("replay_" + QDateTime::currentDateTime().toString("yyyyMMddhhmmss") + ".mp4");
+    auto error = std::make_shared<std::string>();
+    auto ok = std::make_shared<bool>(false);
+    QThread *saveThread = QThread::create([clip, path, error, ok]() {
+        *ok = clip->save(path.toStdString(), error.get());
+    });
+    connect(saveThread, &QThread::finished, this, [this, clip, path, error, ok]() {
+        replayStatusLabel->setText(*ok
+            ? QString("已保存回放（%1 秒）：%2").arg(clip->durationSeconds(), 0, 'f', 1).arg(QFileInfo(path).absoluteFilePath())
+            : QString("回放保存失败：%1").arg(QString::fromStdString(*error)));
+    });
+    startFileThread(saveThread);
+}
+
+void BackgroundReplaceWindow::showRecordingSaved(const QString &path)
+{
+    QString fullPath = QFileInfo(path).absoluteFilePath();
+    QMessageBox::StandardButton reply = QMessageBox::question(
+        this, "成功",
+        QString("录制成功！是否现在打开视频所在目录？\n%1").arg(fullPath),
+        QMessageBox::Yes | QMessageBox::No
+    );
+    if (reply == QMessageBox::Yes) {
+        QDesktopServices::openUrl(QUrl::fromLocalFile(QFileInfo(fullPath).absolutePath()));
     }
 }
 
@@ -1464,140 +2021,94 @@ void BackgroundReplaceWindow::printTimeUp()
 void BackgroundReplaceWindow::updateConf()
 {
     double conf = confSlider->value() / 10.0;
-    segmentor->setConfThreshold(conf);
+    engine.segmentor().setConfThreshold(conf);
 }
 
 void BackgroundReplaceWindow::toggleCamera()
 {
-    if (timer->isActive()) {
-        timer->stop();
-        if (camera != nullptr) {
-            camera->release();
-            delete camera;
-            camera = nullptr;
-        }
+    if (engine.source()) {
+        engine.closeSource();
+        stopReplay();
+        stopVirtualCamera();
+        stopSecondCamera();
         btnCamera->setText("启动摄像头");
-        cameraLabel->clear();
+        cameraPreview->clear();
         fpsLabel->setText("FPS: 0.0");
         frameTimes.clear();
         currentFPS = 0.0f;
         updateRecordingStatusOverlay();
     } else {
-        camera = new cv::VideoCapture(comboBox->currentIndex());
-        if (!camera->isOpened()) {
-            QMessageBox::critical(this, "错误", "无法打开摄像头！");
+        QString error;
+        std::unique_ptr<FrameSource> source(openFrameSource(&error));
+        if (!source) {
+            QMessageBox::critical(this, "错误", error);
             return;
         }
-        camWidth = static_cast<int>(camera->get(cv::CAP_PROP_FRAME_WIDTH));
-        camHeight = static_cast<int>(camera->get(cv::CAP_PROP_FRAME_HEIGHT));
-        camera->set(cv::CAP_PROP_FRAME_WIDTH, camWidth);
-        camera->set(cv::CAP_PROP_FRAME_HEIGHT, camHeight);
+        engine.setSource(std::move(source));
+        const CaptureFormat negotiated = engine.source()->negotiated();
+        camWidth = negotiated.size.width;
+        camHeight = negotiated.size.height;
+        layoutLiveTextLayers();
+        captureInfoLabel->setText(QString("实际：%1x%2 @%3 %4%5")
+                                      .arg(camWidth)
+                                      .arg(camHeight)
+                                      .arg(negotiated.fps, 0, 'f', 0)
+                                      .arg(QString::fromStdString(negotiated.fourcc))
+                                      .arg(engine.outputNv12() ? "（YUV 直通）" : ""));
         updateCameraPreviewSize(camWidth, camHeight);
-        timer->start(22);
+        // 分辨率可能变化，释放旧尺寸的空闲缓冲
+        FramePool::instance().trim();
+        poolSampleMs = 0;
         btnCamera->setText("停止摄像头");
+        startReplay();
+        startVirtualCamera();
+        startSecondCamera();
         
         // Reset FPS calculation
         frameTimes.clear();
         currentFPS = 0.0f;
     }
 }
-QString BackgroundReplaceWindow::extractDirPathQt(const QString& fullPath) {
-    if (fullPath.isEmpty()) {
-        return "./";
-    }
-    // QFileInfo：解析文件路径的工具类
-    QFileInfo fileInfo(fullPath);
-    // absolutePath()：获取目录路径（无末尾分隔符），再用QDir补充分隔符
-    QString dirPath = QDir(fileInfo.absolutePath()).absolutePath() + QDir::separator();
-    return dirPath;
-}
 void BackgroundReplaceWindow::updateFrame()
 {
-    if (!camera || !camera->isOpened()) {
-        return;
-    }
-
-    cv::Mat frame;
-    bool ret = camera->read(frame);
-    if (!ret) {
+    if (!engine.isSourceOpen()) {
         return;
     }
 
-    cv::flip(frame, frame, 1);
-    cv::Mat outputFrame = frame;
-
+    // 背景选择留在界面层，引擎只按开关决定是否做背景替换
+    bool replaceBackground = false;
     if (imageListWidget->currentItem()) {
         QString selectedPath = imageListWidget->currentItem()->data(Qt::UserRole).toString();
         try {
             if (radioImg->isChecked()) {
-                if (currentBgPath != selectedPath || segmentor->getBgType() != "image") {
-                    segmentor->setBackground(selectedPath.toStdString(), "image");
+                if (currentBgPath != selectedPath || engine.segmentor().getBgType() != "image") {
+                    engine.segmentor().setBackground(selectedPath.toStdString(), "image");
                     currentBgPath = selectedPath;
                 }
-                outputFrame = segmentor->segmentAndReplace(frame);
+                replaceBackground = true;
             } else if (radioVideo->isChecked()) {
-                outputFrame = segmentor->segmentAndReplace(frame);
+                replaceBackground = true;
             }
         } catch (const std::exception &e) {
-            outputFrame = frame;
              qDebug() << "背景替换失败：" << e.what() << '\n';
         }
     } else {
-        if (radioVideo->isChecked() && segmentor->getBgType() == "video") {
-            try {
-                outputFrame = segmentor->segmentAndReplace(frame);
-            } catch (const std::exception &e) {
-                 qDebug() << "视频背景渲染失败：" << e.what() << '\n';
-            }
-        }
+        replaceBackground = radioVideo->isChecked() && engine.segmentor().getBgType() == "video";
     }
+    engine.setBackgroundEnabled(replaceBackground);
+    refreshLiveTextLayers();
 
-    drawForeground(outputFrame);
-
-    if (isRecording && videoWriter) {
-        // 检查帧是否有效
-        if (!outputFrame.empty() && outputFrame.cols > 0 && outputFrame.rows > 0) {
-            cv::Mat writeFrame;
-            
-            // 将帧调整为640x480以匹配VideoWriter的配置
-            cv::resize(outputFrame, writeFrame, cv::Size(640, 480));
-            
-            // 确保帧格式正确 (BGR格式)
-            if (writeFrame.channels() == 3) {
-                // 计算理论上应该写入多少帧 (根据录制时长和设定的FPS)
-                qint64 elapsedMs = QDateTime::currentMSecsSinceEpoch() - recordStartTime;
-                int expectedFrames = static_cast<int>(elapsedMs * RECORD_FPS / 1000.0);
-                
-                // 补齐或跳过帧以保持音画同步
-                while (writtenFrames < expectedFrames) {
-                    videoWriter->write(writeFrame);
-                    writtenFrames++;
-                }
-            } else {
-                qDebug() << "警告：帧格式不正确，跳过此帧录制" << '\n';
-            }
-        } else {
-            qDebug() << "警告：输出帧为空，跳过录制" << '\n';
-        }
-
+    // 取最新一帧走完整条管线（镜像、分割、画中画、叠加层），结果已推送给录制、即时回放和虚拟摄像头
+    cv::Mat outputFrame;
+    int64_t captureUs = 0;
+    if (!engine.processFrame(outputFrame, captureUs)) {
+        return;
     }
+    const bool nv12 = engine.outputNv12() && outputFrame.type() == CV_8UC1;
 
-    cv::Mat rgbFrame;
-    cv::cvtColor(outputFrame, rgbFrame, cv::COLOR_BGR2RGB);
-
-    QImage qtImage(rgbFrame.data,
-                   rgbFrame.cols,
-                   rgbFrame.rows,
-                   rgbFrame.step,
-                   QImage::Format_RGB888);
-
-    QPixmap scaledPixmap = QPixmap::fromImage(qtImage).scaled(
-        cameraLabel->size(),
-        Qt::KeepAspectRatio,
-        Qt::SmoothTransformation
-        );
-
-    cameraLabel->setPixmap(scaledPixmap);
+    // 预览控件直接从 BGR/NV12 缩放到显示尺寸绘制，整条管线不再有全分辨率的 RGB 转换；
+    // 按屏幕刷新率节流，窗口不可见时跳过
+    cameraPreview->setFrame(outputFrame, nv12);
 
     // FPS calculation - 使用滑动时间窗口
     qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
@@ -1613,18 +2124,34 @@ void BackgroundReplaceWindow::updateFrame()
     float timeWindowSec = TIME_WINDOW_MS / 1000.0f;
     currentFPS = static_cast<float>(frameCount) / timeWindowSec;
 
-    // 更新显示
-    fpsLabel->setText(QString("FPS: %1").arg(currentFPS, 0, 'f', 1));
-    updateRecordingStatusOverlay();
+    // 每秒统计一次帧缓冲池的新分配次数
+    if (currentTime - poolSampleMs >= 1000) {
+        const uint64_t allocations = FramePool::instance().stats().allocations;
+        if (poolSampleMs > 0) {
+            poolAllocRate = (allocations - poolAllocationsAtSample) * 1000.0 / (currentTime - poolSampleMs);
+        }
+        poolAllocationsAtSample = allocations;
+        poolSampleMs = currentTime;
+    }
+
+    // 文字标签每秒只刷新几次；窗口最小化时不刷新，处理和录制不受影响
+    if (currentTime - labelUpdateMs >= LABEL_UPDATE_INTERVAL_MS && !isMinimized()) {
+        labelUpdateMs = currentTime;
+        fpsLabel->setText(QString("FPS: %1  丢帧: %2  分配: %3/s")
+                          .arg(currentFPS, 0, 'f', 1)
+                          .arg(engine.source()->droppedFrames())
+                          .arg(poolAllocRate, 0, 'f', 0));
+        updateRecordingStatusOverlay();
+    }
 }
 
 void BackgroundReplaceWindow::closeEvent(QCloseEvent *event)
 {
     qDebug() << "开始释放程序资源..." << '\n';
 
-    if (timer->isActive()) {
-        timer->stop();
-         qDebug() << "摄像头定时器已停止" << '\n';
+    if (engine.source()) {
+        engine.source()->release();
+         qDebug() << "采集线程已停止" << '\n';
     }
     if (carouselTimer->isActive()) {
         carouselTimer->stop();
@@ -1634,113 +2161,253 @@ void BackgroundReplaceWindow::closeEvent(QCloseEvent *event)
     if (isRecording) {
         isRecording = false;
         updateRecordingStatusOverlay();
-        if (videoWriter) {
-            videoWriter->release();
-            delete videoWriter;
-            videoWriter = nullptr;
-        }
+        audioRec->stop();
+        engine.stopRecording();
         qDebug() << "录制资源已释放" << '\n';
     }
+    stopReplay();
+    stopVirtualCamera();
+    stopSecondCamera();
+    if (!fileThreads.isEmpty()) {
+        waitFileThreads();
+        qDebug() << "后台文件写入已完成" << '\n';
+    }
 
     try {
-        if (camera && camera->isOpened()) {
-            camera->release();
-            delete camera;
-            camera = nullptr;
-        }
+        engine.closeSource();
         qDebug() << "摄像头已释放" << '\n';
     } catch (const std::exception &e) {
         qDebug() << "摄像头释放警告：" << e.what() << '\n';
     }
 
     try {
-        if (segmentor) {
-            segmentor->release();
-        }
+        engine.segmentor().release();
     } catch (const std::exception &e) {
         qDebug() << "HumanSeg释放警告：" << e.what() << '\n';
     }
 
     event->accept();
 }
-void BackgroundReplaceWindow::startMix(QString inputPath)
-{
-    QString basePath=extractDirPathQt(inputPath);
-    QString ffmpegPath = "ffmpeg-master-latest-win64-gpl-shared/bin/ffmpeg.exe";
-    // 构造 FFmpeg 命令（替换视频音频，裁剪到最短时长）
-    QStringList args;
-    args << "-i" <<  (inputPath.back() == '4' ? basePath+"tempVideo.mp4" : basePath+"tempVideo.avi") // 输入视频
-         << "-i" <<  basePath+"tempAudio.mp4a"     // 输入音频
-         << "-map" << "0:v"              // 选择视频流
-         << "-map" << "1:a"              // 选择音频流
-         << "-c:v" << "copy"             // 视频拷贝
-         << "-c:a" << "aac"              // 音频编码为 AAC
-         << "-shortest"                  // 裁剪到最短时长
-         << "-y"                         // 覆盖已有文件
-         << inputPath;                  // 输出文件
-    // 启动 FFmpeg 进程
-    QProcess *ffmpegProcess = new QProcess();
-    connect(ffmpegProcess, &QProcess::finished, this, [=](int exitCode, QProcess::ExitStatus exitStatus) {
-        if (exitCode == 0) {
-            qDebug()<<"混合成功！";
-            QFile videoFile( (inputPath.back() == '4' ? basePath+"tempVideo.mp4" : basePath+"tempVideo.avi"));
-            QFile audioFile(basePath+"tempAudio.mp4a");
-
-            // 视频文件删除
-            if (videoFile.exists()) {
-                if (!videoFile.remove()) {
-                    QMessageBox::warning(this, "提示",
-                                         "视频文件删除失败");
-                }
-            }
+FrameSource *BackgroundReplaceWindow::openFrameSource(QString *error)
+{
+    // 采集线程按设备帧率读帧，每到一帧通知 GUI 线程处理信箱中最新的一帧；
+    // 已有未执行的通知时不再重复投递，处理跟不上时旧帧在信箱中被替换
+    auto notify = [this]() {
+        if (!frameNotifyPending.exchange(true)) {
+            QMetaObject::invokeMethod(this, [this]() {
+                frameNotifyPending = false;
+                updateFrame();
+            }, Qt::QueuedConnection);
+        }
+    };
+    const QString type = sourceTypeBox->currentData().toString();
+    const SourcePacing pacing = chkFastPacing->isChecked() ? SourcePacing::AsFastAsPossible : SourcePacing::RealTime;
+    const CaptureFormat format = currentCaptureFormat();
+    bool opened = false;
+    FrameSource *source = nullptr;
+    if (type == "camera") {
+        auto *capture = new CaptureThread();
+        capture->setFrameCallback(notify);
+        opened = comboBox->currentIndex() >= 0 && capture->open(comboBox->currentData().toInt(), format);
+        source = capture;
+        *error = "无法打开摄像头！";
+    } else if (type == "video") {
+        auto *video = new VideoFileSource();
+        video->setFrameCallback(notify);
+        video->setPacing(pacing);
+        opened = video->open(sourcePathEdit->text().toStdString());
+        source = video;
+        *error = "无法打开视频文件！";
+    } else if (type == "images") {
+        auto *images = new ImageSequenceSource();
+        images->setFrameCallback(notify);
+        images->setPacing(pacing);
+        opened = images->open(sourcePathEdit->text().toStdString(), format.fps > 0 ? format.fps : 30.0);
+        source = images;
+        *error = "目录中没有可读取的图片！";
+    } else {
+        // 合成画面使用采集格式中选择的分辨率和帧率
+        auto *synthetic = new SyntheticSource();
+        synthetic->setFrameCallback(notify);
+        synthetic->setPacing(pacing);
+        opened = synthetic->open(format.size.empty() ? cv::Size(1280, 720) : format.size,
+                                 format.fps > 0 ? format.fps : 30.0);
+        source = synthetic;
+        *error = "无法生成合成画面！";
+    }
+    if (!opened) {
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
 
-            // 音频文件删除
-            if (audioFile.exists()) {
-                if (!audioFile.remove()) {
-                    QMessageBox::warning(this, "提示",
-                                         "音频文件删除失败：");
-                }
-            }
+void BackgroundReplaceWindow::chooseSourcePath()
+{
+    QString path;
+    if (sourceTypeBox->currentData().toString() == "video") {
+        path = QFileDialog::getOpenFileName(this, "选择视频文件", QString(),
+                                            "视频文件 (*.mp4 *.avi *.mkv *.mov);;所有文件 (*)");
+    } else {
+        path = QFileDialog::getExistingDirectory(this, "选择图片目录");
+    }
+    if (!path.isEmpty()) {
+        sourcePathEdit->setText(path);
+    }
+}
 
-            QString fullPath = QFileInfo(inputPath).absoluteFilePath();
-            QMessageBox::StandardButton reply = QMessageBox::question(
-                this, "成功", 
-                QString("录制成功！是否现在打开视频所在目录？\n%1").arg(fullPath),
-                QMessageBox::Yes | QMessageBox::No
-            );
-            if (reply == QMessageBox::Yes) {
-                QString dirPath = QFileInfo(fullPath).absolutePath();
-                QDesktopServices::openUrl(QUrl::fromLocalFile(dirPath));
-            }
-        } else {
-            // 输出错误信息
-            QString error = ffmpegProcess->readAllStandardError();
-            qDebug()<<"----MiX-ERROR----\n"<<error;
+void BackgroundReplaceWindow::updateCameraList(const QList<CameraInfo> &cameras)
+{
+    // 按设备标识保持当前选择，插拔其他设备不会改变正在使用的摄像头
+    const QString selectedId = comboBox->currentData(Qt::UserRole + 1).toString();
+    comboBox->clear();
+    for (const CameraInfo &info : cameras) {
+        comboBox->addItem(info.name.isEmpty() ? "相机" + QString::number(info.index + 1) : info.name, info.index);
+        const int row = comboBox->count() - 1;
+        comboBox->setItemData(row, info.id, Qt::UserRole + 1);
+        comboBox->setItemData(row, info.modeSummary(), Qt::ToolTipRole);
+        if (!selectedId.isEmpty() && info.id == selectedId) {
+            comboBox->setCurrentIndex(row);
         }
-        ffmpegProcess->deleteLater();
-    });
+    }
+    comboBox->setPlaceholderText(cameras.isEmpty() ? "未检测到摄像头" : QString());
+    cameraInfos = cameras;
+    if (captureFormatBox) {
+        populateCaptureFormats(); // 同一设备重新枚举后模式可能变化
+    }
 
-    // 启动进程
-    ffmpegProcess->start(ffmpegPath, args);
+    const QString secondId = secondCameraBox->currentData(Qt::UserRole + 1).toString();
+    secondCameraBox->clear();
+    for (const CameraInfo &info : cameras) {
+        secondCameraBox->addItem(info.name.isEmpty() ? "相机" + QString::number(info.index + 1) : info.name, info.index);
+        const int row = secondCameraBox->count() - 1;
+        secondCameraBox->setItemData(row, info.id, Qt::UserRole + 1);
+        if (!secondId.isEmpty() && info.id == secondId) {
+            secondCameraBox->setCurrentIndex(row);
+        }
+    }
+    if (secondId.isEmpty() && secondCameraBox->count() > 1) {
+        secondCameraBox->setCurrentIndex(1); // 默认选第二个设备，避免与主摄像头冲突
+    }
+}
 
-    // 检查 FFmpeg 是否启动成功
-    if (!ffmpegProcess->waitForStarted(3000)) {
-        QMessageBox::critical(this, "错误", "无法启动 FFmpeg，请检查路径是否正确！");
-        ffmpegProcess->deleteLater();
+QList<CameraMode> BackgroundReplaceWindow::selectedCameraModes() const
+{
+    const QString id = comboBox->currentData(Qt::UserRole + 1).toString();
+    for (const CameraInfo &info : cameraInfos) {
+        if (info.id == id) {
+            return info.modes;
+        }
     }
+    return {};
 }
-int BackgroundReplaceWindow::detectCamera()
+
+void BackgroundReplaceWindow::populateCaptureFormats()
 {
-    int i = 0;
-    while (true) {
-        cv::VideoCapture cap(i, cv::CAP_DSHOW);
-        if (cap.isOpened()) {
-            cap.release();
-            i++;
-        } else {
-            cap.release();
-            break;
+    // 按所选摄像头枚举到的模式列出格式；没有模式信息（枚举不可用）时退回常用格式
+    const QList<CameraMode> modes = selectedCameraModes();
+    QStringList fourccs;
+    for (const QString &preferred : {QString("MJPG"), QString("YUYV"), QString("NV12")}) {
+        const bool supported = std::any_of(modes.begin(), modes.end(), [&preferred](const CameraMode &mode) {
+            return mode.fourcc == preferred;
+        });
+        if (modes.isEmpty() || supported) {
+            fourccs.append(preferred);
+        }
+    }
+    for (const CameraMode &mode : modes) {
+        if (!mode.fourcc.isEmpty() && !fourccs.contains(mode.fourcc)) {
+            fourccs.append(mode.fourcc);
+        }
+    }
+
+    const bool hadItems = captureFormatBox->count() > 0;
+    const QString previous = captureFormatBox->currentData().toString();
+    {
+        const QSignalBlocker blocker(captureFormatBox);
+        captureFormatBox->clear();
+        for (const QString &fourcc : fourccs) {
+            captureFormatBox->addItem(fourcc == "MJPG" ? "MJPEG" : fourcc, fourcc);
         }
+        captureFormatBox->addItem("驱动默认", "");
+        const int keep = hadItems ? captureFormatBox->findData(previous) : -1;
+        captureFormatBox->setCurrentIndex(keep >= 0 ? keep : 0);
+    }
+    chkKeepNv12->setEnabled(captureFormatBox->currentData().toString() == "NV12");
+    populateCaptureSizes();
+}
+
+void BackgroundReplaceWindow::populateCaptureSizes()
+{
+    // 所选格式下摄像头支持的分辨率，从大到小；没有模式信息时退回常用档位
+    const QList<CameraMode> modes = selectedCameraModes();
+    const QString fourcc = captureFormatBox->currentData().toString();
+    QList<QSize> sizes;
+    for (const CameraMode &mode : modes) {
+        if ((fourcc.isEmpty() || mode.fourcc == fourcc) && mode.size.isValid() && !sizes.contains(mode.size)) {
+            sizes.append(mode.size);
+        }
+    }
+    if (sizes.isEmpty()) {
+        sizes = {QSize(1920, 1080), QSize(1280, 720), QSize(640, 480)};
+    }
+    std::sort(sizes.begin(), sizes.end(), [](const QSize &a, const QSize &b) {
+        return a.width() * a.height() > b.width() * b.height();
+    });
+
+    const bool hadItems = captureSizeBox->count() > 0;
+    const QSize previous = captureSizeBox->currentData().toSize();
+    {
+        const QSignalBlocker blocker(captureSizeBox);
+        captureSizeBox->clear();
+        for (const QSize &size : sizes) {
+            captureSizeBox->addItem(QString("%1x%2").arg(size.width()).arg(size.height()), size);
+        }
+        captureSizeBox->addItem("驱动默认", QSize());
+        int keep = hadItems ? captureSizeBox->findData(previous) : -1;
+        if (keep < 0) {
+            keep = std::max(0, captureSizeBox->findData(QSize(1280, 720)));
+        }
+        captureSizeBox->setCurrentIndex(keep);
+    }
+    populateCaptureRates();
+}
+
+void BackgroundReplaceWindow::populateCaptureRates()
+{
+    // 所选格式和分辨率下的最高帧率及其以下的常用帧率；驱动未给出帧率时退回常用档位
+    const QList<CameraMode> modes = selectedCameraModes();
+    const QString fourcc = captureFormatBox->currentData().toString();
+    const QSize size = captureSizeBox->currentData().toSize();
+    double maxFps = 0.0;
+    for (const CameraMode &mode : modes) {
+        if ((fourcc.isEmpty() || mode.fourcc == fourcc) && (!size.isValid() || mode.size == size)) {
+            maxFps = std::max(maxFps, mode.maxFps);
+        }
+    }
+    QList<int> rates;
+    if (maxFps > 0.0) {
+        rates.append(qRound(maxFps));
+        for (int rate : {60, 30, 25, 15}) {
+            if (rate < qRound(maxFps)) {
+                rates.append(rate);
+            }
+        }
+    } else {
+        rates = {60, 30, 15};
+    }
+
+    const bool hadItems = captureFpsBox->count() > 0;
+    const int previous = captureFpsBox->currentData().toInt();
+    const QSignalBlocker blocker(captureFpsBox);
+    captureFpsBox->clear();
+    for (int rate : rates) {
+        captureFpsBox->addItem(QString::number(rate), rate);
+    }
+    captureFpsBox->addItem("驱动默认", 0);
+    int keep = hadItems ? captureFpsBox->findData(previous) : -1;
+    if (keep < 0) {
+        keep = std::max(0, captureFpsBox->findData(30));
     }
-    return i;
+    captureFpsBox->setCurrentIndex(keep);
 }
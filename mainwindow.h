@@ -21,10 +21,12 @@
 #include <QLineEdit>
 #include <QCheckBox>
 #include <QStackedLayout>
+#include <QGridLayout>
 #include <QStackedWidget>
 #include <QColorDialog>
 #include <QTimer>
 #include <QDateTime>
+#include <QTime>
 #include <QImage>
 #include <QPixmap>
 #include <QColor>
@@ -32,11 +34,18 @@
 #include <QCloseEvent>
 #include <QKeyEvent>
 #include <QShortcut>
+#include <QThread>
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <string>
-#include "HumanSeg.h"
-#include "PreviewWidget.h"
+#include "bgcamengine.h"
+#include "cameraenumerator.h"
+#include "framepreview.h"
+#include "capturethread.h"
+#include "playbacksource.h"
+#include "previewwidget.h"
 #include "audiorecorder.h"
 class BackgroundReplaceWindow : public QMainWindow
 {
@@ -68,7 +77,6 @@ private slots:
     void updateFgOpacity(int value);
     void deleteSelectedImage();
     void clearAllImages();
-    void startMix(QString inputPath);
 protected:
     void keyPressEvent(QKeyEvent *event) override;
 
@@ -86,20 +94,43 @@ private:
     void onTextAlignChanged(int align);
     QWidget* createWizardHeader();
     void closeEvent(QCloseEvent *event) override;
-    int detectCamera();
-    QString extractDirPathQt(const QString& fullPath);
-    void drawForeground(cv::Mat &frame);
+    void updateCameraList(const QList<CameraInfo> &cameras);
+    QList<CameraMode> selectedCameraModes() const;
+    void populateCaptureFormats();
+    void populateCaptureSizes();
+    void populateCaptureRates();
+    FrameSource *openFrameSource(QString *error);
+    void chooseSourcePath();
     void toggleFullScreenPreview();
     void updateCameraPreviewSize(int frameWidth, int frameHeight);
     void moveForegroundBy(int dx, int dy);
     void adjustForegroundScale(int delta);
     void resetForegroundPosition();
     void updateRecordingStatusOverlay();
+    RecordingOptions currentRecordingOptions() const;
+    CaptureFormat currentCaptureFormat() const;
+    static int defaultEncoderThreads();
+    void mergeSegments(const QStringList &segments, const QString &target);
+    void startFileThread(QThread *thread);
+    void waitFileThreads();
+    void showRecordingSaved(const QString &path);
+    bool startAudioCapture();
+    void startReplay();
+    void stopReplay();
+    void startVirtualCamera();
+    void stopVirtualCamera();
+    void startSecondCamera();
+    void stopSecondCamera();
+    void saveReplay();
+    void updateLiveTextLayers();
+    void refreshLiveTextLayers();
+    void layoutLiveTextLayers();
+    void applyFgImage(AnimatedFrames animation, const cv::Mat &fgImage);
     
     // Core components
-    HumanSeg *segmentor;
-    cv::VideoCapture *camera;
-    QTimer *timer;
+    // 采集、分割、合成和各输出端都在引擎中，界面只负责配置和显示
+    BgCamEngine engine;
+    std::atomic<bool> frameNotifyPending{false}; // 已向 GUI 线程投递了一次 updateFrame，尚未执行
     QTimer *carouselTimer;
 
     // UI elements
@@ -143,7 +174,7 @@ private:
     QGroupBox *fgSettingsGroupBox;
     QGroupBox *creationSettingsGroupBox;
     QStackedLayout *previewStackLayout;
-    QLabel *cameraLabel;
+    FramePreviewWidget *cameraPreview;
     QLabel *recordStatusLabel;
     QLabel *fpsLabel;
     QLabel *setupStepLabel;
@@ -164,6 +195,39 @@ private:
     QRadioButton *radioVideo;
     QButtonGroup *bgTypeGroup;
     QComboBox *comboBox;
+    QComboBox *sourceTypeBox;
+    QLineEdit *sourcePathEdit;
+    QPushButton *btnSourcePath;
+    QCheckBox *chkFastPacing;
+    QCheckBox *chkVirtualCamera;
+    QLabel *virtualCameraLabel;
+    QCheckBox *chkSecondCamera;
+    QComboBox *secondCameraBox;
+    QPushButton *btnSecondBackground;
+    QLabel *secondCameraLabel;
+    CameraEnumerator *cameraEnumerator;
+    QList<QThread *> fileThreads;         // 分段合并、回放保存等写文件的后台线程，退出前等待其完成
+    QList<CameraInfo> cameraInfos;        // 最近一次枚举结果，采集格式下拉框据此列出所选摄像头的模式
+    QComboBox *captureFormatBox = nullptr;
+    QComboBox *captureSizeBox = nullptr;
+    QComboBox *captureFpsBox = nullptr;
+    QCheckBox *chkKeepNv12;
+    QLabel *captureInfoLabel;
+    QComboBox *overflowPolicyBox;
+    QComboBox *recordSizeBox;
+    QComboBox *recordCodecBox;
+    QSpinBox *recordFpsInput;
+    QSpinBox *recordBitrateInput;
+    QComboBox *x264PresetBox;
+    QComboBox *x264TuneBox;
+    QSpinBox *x264CrfInput;
+    QSpinBox *encoderThreadsInput;
+    QCheckBox *chkFragmented;
+    QSpinBox *segmentMinutesInput;
+    QCheckBox *chkMergeSegments;
+    QCheckBox *chkReplay;
+    QSpinBox *replaySecondsInput;
+    QLabel *replayStatusLabel;
     QPlainTextEdit *titleInputBox;
     QLineEdit *fontInputBox;
     QLineEdit *saveDirInput;
@@ -172,6 +236,10 @@ private:
     QSpinBox *posXInput;
     QSpinBox *posYInput;
     QSpinBox *fsInput;
+    QCheckBox *chkClock;
+    QCheckBox *chkRecTimer;
+    QCheckBox *chkTicker;
+    QLineEdit *tickerInput;
     audioRecorder *audioRec;
 
     QPushButton *btnAddFgImage;
@@ -180,7 +248,13 @@ private:
     QSlider *fgOpacitySlider;
     
     // Data
-    cv::Mat fgImage;
+    int fgLayerId;
+    int clockLayerId;
+    int recTimerLayerId;
+    int tickerLayerId;
+    int tickerBandLayerId;
+    static constexpr int LIVE_TEXT_SIZE = 36;      // 动态文字字号
+    static constexpr double TICKER_SPEED = 120.0;  // 滚动字幕速度（像素/秒）
     int fgX;
     int fgY;
     double fgScale;
@@ -192,12 +266,13 @@ private:
     bool isRecording;
     bool isPreviewFullScreen;
     qint64 recordStartTime;
-    int writtenFrames;
-    const double RECORD_FPS = 30.0;
-    cv::VideoWriter *videoWriter;
+    // 前景动图的内存上限：源帧最多用一半，其余留给合成器按缩放比例生成的预乘图集
+    static constexpr size_t FG_ANIMATION_MEMORY_CAP = 256 * 1024 * 1024;
+    static constexpr size_t ENCODE_QUEUE_CAPACITY = 8; // 编码队列容量（帧）
+    QString secondBackgroundPath;
+    static constexpr size_t REPLAY_MEMORY_CAP = 200 * 1024 * 1024; // 回放缓冲区内存上限
     std::string recordFilename;
     int cameraIndex;
-    int cameraNumber;
     int camWidth;
     int camHeight;
     int currentSetupStep;
@@ -207,6 +282,12 @@ private:
 
     // FPS calculation - 使用滑动时间窗口
     std::vector<qint64> frameTimes; // 存储每帧的时间戳
+    // 帧缓冲池每秒新分配次数（稳定运行时应为 0）
+    uint64_t poolAllocationsAtSample = 0;
+    qint64 poolSampleMs = 0;
+    double poolAllocRate = 0.0;
+    qint64 labelUpdateMs = 0;                           // 上次刷新 FPS/录制状态标签的时间
+    static constexpr int LABEL_UPDATE_INTERVAL_MS = 250;
     static constexpr int TIME_WINDOW_MS = 3000; // 3秒时间窗口
     float currentFPS;
 };
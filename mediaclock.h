@@ -0,0 +1,18 @@
+#ifndef MEDIACLOCK_H
+#define MEDIACLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief 录制使用的单调时钟（微秒）
+ *
+ * 视频采集时间戳与音频到达时间都取自该时钟，不受系统时间调整影响。
+ */
+inline int64_t mediaClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // MEDIACLOCK_H
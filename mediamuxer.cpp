@@ -0,0 +1,626 @@
+#include "mediamuxer.h"
+#include "mediaclock.h"
+#include <algorithm>
+#include <iostream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/audio_fifo.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/opt.h>
+#include <libavutil/samplefmt.h>
+#include <libswresample/swresample.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+std::string avError(int code)
+{
+    char buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(code, buf, sizeof(buf));
+    return buf;
+}
+
+const AVCodec* findVideoEncoder(const std::string& name)
+{
+    if (name == "h264") {
+        // 优先 libx264，其次 openh264（LGPL 构建中唯一的软件编码器），最后是系统提供的任意 H.264 编码器
+        for (const char* candidate : {"libx264", "libopenh264"}) {
+            if (const AVCodec* codec = avcodec_find_encoder_by_name(candidate)) {
+                return codec;
+            }
+        }
+        return avcodec_find_encoder(AV_CODEC_ID_H264);
+    }
+    return avcodec_find_encoder_by_name(name.c_str());
+}
+
+AVPixelFormat pickPixelFormat(const AVCodecContext* ctx, const AVCodec* codec, bool preferNv12)
+{
+    const AVPixelFormat* formats = nullptr;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    avcodec_get_supported_config(ctx, codec, AV_CODEC_CONFIG_PIX_FORMAT, 0,
+                                 reinterpret_cast<const void**>(&formats), nullptr);
+#else
+    (void)ctx;
+    formats = codec->pix_fmts;
+#endif
+    if (!formats) {
+        return AV_PIX_FMT_YUV420P;
+    }
+    if (preferNv12) {
+        for (const AVPixelFormat* f = formats; *f != AV_PIX_FMT_NONE; ++f) {
+            if (*f == AV_PIX_FMT_NV12) {
+                return *f;
+            }
+        }
+    }
+    for (const AVPixelFormat* f = formats; *f != AV_PIX_FMT_NONE; ++f) {
+        if (*f == AV_PIX_FMT_YUV420P) {
+            return *f;
+        }
+    }
+    return formats[0];
+}
+
+int pickSampleRate(const AVCodecContext* ctx, const AVCodec* codec, int preferred)
+{
+    const int* rates = nullptr;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    avcodec_get_supported_config(ctx, codec, AV_CODEC_CONFIG_SAMPLE_RATE, 0,
+                                 reinterpret_cast<const void**>(&rates), nullptr);
+#else
+    (void)ctx;
+    rates = codec->supported_samplerates;
+#endif
+    if (!rates) {
+        return preferred;
+    }
+    for (const int* r = rates; *r != 0; ++r) {
+        if (*r == preferred) {
+            return preferred;
+        }
+    }
+    return 48000;
+}
+}
+
+MediaMuxer::~MediaMuxer()
+{
+    close();
+}
+
+bool MediaMuxer::fail(const std::string& what, int code)
+{
+    std::string message = what;
+    if (code < 0) {
+        message += "：" + avError(code);
+    }
+    std::cerr << "[MediaMuxer] " << message << std::endl;
+    std::lock_guard<std::mutex> lock(errorMutex);
+    error = message;
+    return false;
+}
+
+std::string MediaMuxer::videoEncoderName() const
+{
+    return videoCodec && videoCodec->codec ? videoCodec->codec->name : std::string();
+}
+
+std::string MediaMuxer::lastError() const
+{
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return error;
+}
+
+bool MediaMuxer::open(const std::string& path, const RecordingOptions& video, const MuxerAudioFormat* audio,
+                      int64_t timelineOriginUs)
+{
+    close();
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        error.clear();
+    }
+
+    originUs = timelineOriginUs >= 0 ? timelineOriginUs : mediaClockUs();
+    // 帧源时钟与墙钟无关，无法和按到达时间对齐的麦克风音频同步，只录视频
+    videoOriginUs = originUs;
+    videoOriginPending = video.sourceClock;
+    if (video.sourceClock) {
+        audio = nullptr;
+    }
+    if (path.empty()) {
+        if (!openVideo(video) || (audio && !openAudio(*audio))) {
+            close();
+            return false;
+        }
+        ready = true;
+        return true;
+    }
+
+    int ret = avformat_alloc_output_context2(&format, nullptr, nullptr, path.c_str());
+    if (ret < 0 || !format) {
+        return fail("无法根据扩展名确定封装格式", ret);
+    }
+    if (!openVideo(video) || (audio && !openAudio(*audio))) {
+        close();
+        return false;
+    }
+
+    if (!(format->oformat->flags & AVFMT_NOFILE)) {
+        ret = avio_open(&format->pb, path.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0) {
+            fail("无法创建文件 " + path, ret);
+            close();
+            return false;
+        }
+    }
+    AVDictionary* muxerOptions = nullptr;
+    const std::string container = format->oformat->name;
+    if (video.fragmented && (container == "mp4" || container == "mov")) {
+        // moov 写在文件头，之后每个关键帧开始一个独立分片；崩溃时最多丢失最后一个未写完的分片
+        av_dict_set(&muxerOptions, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+    }
+    ret = avformat_write_header(format, &muxerOptions);
+    av_dict_free(&muxerOptions);
+    if (ret < 0) {
+        fail("写入文件头失败", ret);
+        close();
+        return false;
+    }
+    ready = true;
+    return true;
+}
+
+bool MediaMuxer::openVideo(const RecordingOptions& options)
+{
+    const AVCodec* codec = findVideoEncoder(options.codec);
+    if (!codec) {
+        return fail("找不到视频编码器 " + options.codec);
+    }
+    videoCodec = avcodec_alloc_context3(codec);
+    videoStream = format ? avformat_new_stream(format, nullptr) : nullptr;
+    videoFrame = av_frame_alloc();
+    videoPacket = av_packet_alloc();
+    if (!videoCodec || (format && !videoStream) || !videoFrame || !videoPacket) {
+        return fail("分配视频编码器失败");
+    }
+
+    // 可变帧率：PTS 以毫秒为单位取自采集时间戳，fps 只作为码控和关键帧间隔的参考
+    const AVRational fps = av_d2q(options.fps, 1001000);
+    videoCodec->width = options.frameSize.width;
+    videoCodec->height = options.frameSize.height;
+    videoCodec->time_base = AVRational{1, 1000};
+    videoCodec->framerate = fps;
+    videoCodec->pix_fmt = pickPixelFormat(videoCodec, codec, options.nv12Input);
+    videoCodec->gop_size = std::max(1, static_cast<int>(options.fps * 2)); // 2 秒一个关键帧
+    videoCodec->thread_count = std::max(0, options.threads);
+    const bool x264 = std::string(codec->name) == "libx264";
+    if (x264) {
+        // zerolatency 关闭 B 帧与前瞻，改用条带多线程，每帧编码延迟最低
+        av_opt_set(videoCodec->priv_data, "preset", options.preset.c_str(), 0);
+        if (!options.tune.empty()) {
+            av_opt_set(videoCodec->priv_data, "tune", options.tune.c_str(), 0);
+        }
+        if (options.bitrateKbps <= 0) {
+            av_opt_set_double(videoCodec->priv_data, "crf", options.crf, 0);
+        }
+    }
+    if (options.bitrateKbps > 0) {
+        videoCodec->bit_rate = static_cast<int64_t>(options.bitrateKbps) * 1000;
+        videoCodec->rc_max_rate = videoCodec->bit_rate;
+        videoCodec->rc_buffer_size = static_cast<int>(videoCodec->bit_rate);
+    } else if (codec->id == AV_CODEC_ID_H264) {
+        // 其他 H.264 编码器不支持 CRF，按约 0.1 bit/像素估算码率
+        if (!x264) {
+            videoCodec->bit_rate = static_cast<int64_t>(options.frameSize.area() * options.fps * 0.1);
+        }
+    } else {
+        // MPEG-4/MJPEG 的默认码率只有 200kbps，改用固定量化质量
+        videoCodec->flags |= AV_CODEC_FLAG_QSCALE;
+        videoCodec->global_quality = FF_QP2LAMBDA * 3;
+    }
+    if (!format || (format->oformat->flags & AVFMT_GLOBALHEADER)) { // 仅编码模式的数据包之后会写入 MP4
+        videoCodec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    int ret = avcodec_open2(videoCodec, codec, nullptr);
+    if (ret < 0) {
+        return fail("打开视频编码器失败", ret);
+    }
+    if (videoStream) {
+        ret = avcodec_parameters_from_context(videoStream->codecpar, videoCodec);
+        if (ret < 0) {
+            return fail("设置视频流参数失败", ret);
+        }
+        videoStream->time_base = videoCodec->time_base;
+    }
+
+    videoFrame->format = videoCodec->pix_fmt;
+    videoFrame->width = videoCodec->width;
+    videoFrame->height = videoCodec->height;
+    ret = av_frame_get_buffer(videoFrame, 0);
+    if (ret < 0) {
+        return fail("分配视频帧失败", ret);
+    }
+    lastVideoPts = -1;
+    return true;
+}
+
+bool MediaMuxer::openAudio(const MuxerAudioFormat& input)
+{
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    if (!codec) {
+        return fail("找不到 AAC 编码器");
+    }
+    audioCodec = avcodec_alloc_context3(codec);
+    audioStream = format ? avformat_new_stream(format, nullptr) : nullptr;
+    audioFrame = av_frame_alloc();
+    audioPacket = av_packet_alloc();
+    if (!audioCodec || (format && !audioStream) || !audioFrame || !audioPacket) {
+        return fail("分配音频编码器失败");
+    }
+
+    audioCodec->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    audioCodec->sample_rate = pickSampleRate(audioCodec, codec, input.sampleRate);
+    av_channel_layout_default(&audioCodec->ch_layout, std::min(std::max(input.channels, 1), 2));
+    audioCodec->bit_rate = static_cast<int64_t>(input.bitrateKbps) * 1000;
+    audioCodec->time_base = AVRational{1, audioCodec->sample_rate};
+    if (!format || (format->oformat->flags & AVFMT_GLOBALHEADER)) {
+        audioCodec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    int ret = avcodec_open2(audioCodec, codec, nullptr);
+    if (ret < 0) {
+        return fail("打开 AAC 编码器失败", ret);
+    }
+    if (audioStream) {
+        ret = avcodec_parameters_from_context(audioStream->codecpar, audioCodec);
+        if (ret < 0) {
+            return fail("设置音频流参数失败", ret);
+        }
+        audioStream->time_base = audioCodec->time_base;
+    }
+
+    // 交错 S16 -> 平面 float（必要时重采样、下混到双声道）
+    AVChannelLayout inLayout;
+    av_channel_layout_default(&inLayout, input.channels);
+    ret = swr_alloc_set_opts2(&swr, &audioCodec->ch_layout, AV_SAMPLE_FMT_FLTP, audioCodec->sample_rate,
+                              &inLayout, AV_SAMPLE_FMT_S16, input.sampleRate, 0, nullptr);
+    av_channel_layout_uninit(&inLayout);
+    if (ret < 0 || (ret = swr_init(swr)) < 0) {
+        return fail("初始化音频重采样失败", ret);
+    }
+
+    const int frameSize = audioCodec->frame_size > 0 ? audioCodec->frame_size : 1024;
+    audioFifo = av_audio_fifo_alloc(AV_SAMPLE_FMT_FLTP, audioCodec->ch_layout.nb_channels, frameSize * 4);
+    audioFrame->nb_samples = frameSize;
+    audioFrame->format = AV_SAMPLE_FMT_FLTP;
+    audioFrame->sample_rate = audioCodec->sample_rate;
+    av_channel_layout_copy(&audioFrame->ch_layout, &audioCodec->ch_layout);
+    ret = audioFifo ? av_frame_get_buffer(audioFrame, 0) : AVERROR(ENOMEM);
+    if (ret < 0) {
+        return fail("分配音频帧失败", ret);
+    }
+    inputSampleRate = input.sampleRate;
+    audioPts = 0;
+    audioAnchorUs = -1;
+    inputSamples = 0;
+    audioDriftEma = 0.0;
+    audioDriftUs = 0;
+    return true;
+}
+
+bool MediaMuxer::encode(AVCodecContext* codec, AVStream* stream, AVFrame* frame, AVPacket* packet)
+{
+    int ret = avcodec_send_frame(codec, frame);
+    if (ret < 0 && ret != AVERROR_EOF) {
+        return fail("送入编码器失败", ret);
+    }
+    for (;;) {
+        ret = avcodec_receive_packet(codec, packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            return true;
+        }
+        if (ret < 0) {
+            return fail("编码失败", ret);
+        }
+        if (tap) {
+            tap(packet, codec == videoCodec);
+        }
+        if (!format) {
+            av_packet_unref(packet);
+            continue;
+        }
+        // 封装器在写文件头时可能改写流的 time_base，逐包换算
+        av_packet_rescale_ts(packet, codec->time_base, stream->time_base);
+        packet->stream_index = stream->index;
+        std::lock_guard<std::mutex> lock(writeMutex);
+        ret = av_interleaved_write_frame(format, packet);
+        if (ret < 0) {
+            return fail("写入数据包失败", ret);
+        }
+    }
+}
+
+bool MediaMuxer::writeVideo(const cv::Mat& frame, int64_t captureUs)
+{
+    if (!ready || !videoCodec || frame.empty()) {
+        return false;
+    }
+    const bool nv12 = frame.type() == CV_8UC1 && frame.rows % 3 == 0 && frame.cols % 2 == 0;
+    if (!nv12 && frame.type() != CV_8UC3) {
+        return false;
+    }
+    const int srcHeight = nv12 ? frame.rows * 2 / 3 : frame.rows;
+    int ret = av_frame_make_writable(videoFrame);
+    if (ret < 0) {
+        return fail("视频帧不可写", ret);
+    }
+    const uint8_t* src[4] = {frame.data, nv12 ? frame.ptr(srcHeight) : nullptr, nullptr, nullptr};
+    const int srcStride[4] = {static_cast<int>(frame.step), nv12 ? static_cast<int>(frame.step) : 0, 0, 0};
+    if (nv12 && videoCodec->pix_fmt == AV_PIX_FMT_NV12
+        && videoCodec->width == frame.cols && videoCodec->height == srcHeight) {
+        // YUV 直通：编码器直接吃 NV12，只拷贝两个平面
+        av_image_copy(videoFrame->data, videoFrame->linesize, src, srcStride,
+                      AV_PIX_FMT_NV12, frame.cols, srcHeight);
+    } else {
+        // 缩小用区域平均，放大用双线性；尺寸不变时 sws 只做颜色转换
+        const bool shrinking = videoCodec->width <= frame.cols && videoCodec->height <= srcHeight;
+        sws = sws_getCachedContext(sws, frame.cols, srcHeight, nv12 ? AV_PIX_FMT_NV12 : AV_PIX_FMT_BGR24,
+                                   videoCodec->width, videoCodec->height, videoCodec->pix_fmt,
+                                   shrinking ? SWS_AREA : SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws) {
+            return fail("创建颜色转换上下文失败");
+        }
+        sws_scale(sws, src, srcStride, 0, srcHeight, videoFrame->data, videoFrame->linesize);
+    }
+    // 换算到音频时钟：扣除音频设备时钟的累计漂移；同一毫秒内的两帧顺延 1ms 保证 PTS 递增
+    if (videoOriginPending) {
+        videoOriginUs = captureUs;
+        videoOriginPending = false;
+    }
+    const int64_t ptsUs = std::max<int64_t>(0, captureUs - videoOriginUs - audioDriftUs.load());
+    int64_t pts = av_rescale_q(ptsUs, AVRational{1, 1000000}, videoCodec->time_base);
+    if (pts <= lastVideoPts) {
+        pts = lastVideoPts + 1;
+    }
+    lastVideoPts = pts;
+    videoFrame->quality = videoCodec->global_quality;
+    videoFrame->pts = pts;
+    return encode(videoCodec, videoStream, videoFrame, videoPacket);
+}
+
+bool MediaMuxer::writeAudio(const int16_t* samples, int frames, int64_t arrivalUs)
+{
+    std::lock_guard<std::mutex> lock(audioMutex);
+    if (!ready || !audioCodec || !samples || frames <= 0) {
+        return false;
+    }
+    const int64_t chunkUs = static_cast<int64_t>(frames) * 1000000 / inputSampleRate;
+    if (audioAnchorUs < 0) {
+        // 第一段音频决定音轨在文件时间轴上的起点，之后 PTS 只随采样数增长
+        audioAnchorUs = arrivalUs - chunkUs;
+        audioPts = av_rescale(std::max<int64_t>(0, audioAnchorUs - originUs), audioCodec->sample_rate, 1000000);
+    } else {
+        // 到达时间减去按采样数推算的时间即为设备时钟漂移（含调度抖动，用指数平均滤掉）
+        const int64_t expectedUs = audioAnchorUs + (inputSamples + frames) * 1000000 / inputSampleRate;
+        audioDriftEma += (static_cast<double>(arrivalUs - expectedUs) - audioDriftEma) * 0.01;
+        audioDriftUs = static_cast<int64_t>(audioDriftEma);
+    }
+    inputSamples += frames;
+    const int channels = audioCodec->ch_layout.nb_channels;
+    const int capacity = swr_get_out_samples(swr, frames);
+    if (convertBuffer.size() < static_cast<size_t>(capacity) * channels) {
+        convertBuffer.resize(static_cast<size_t>(capacity) * channels);
+    }
+    uint8_t* planes[2];
+    for (int c = 0; c < channels; ++c) {
+        planes[c] = reinterpret_cast<uint8_t*>(convertBuffer.data() + static_cast<size_t>(c) * capacity);
+    }
+    const uint8_t* in[1] = {reinterpret_cast<const uint8_t*>(samples)};
+    const int converted = swr_convert(swr, planes, capacity, in, frames);
+    if (converted < 0) {
+        return fail("音频重采样失败", converted);
+    }
+    if (converted > 0 && av_audio_fifo_write(audioFifo, reinterpret_cast<void**>(planes), converted) < converted) {
+        return fail("音频缓冲写入失败");
+    }
+    return drainAudioFifo(false);
+}
+
+bool MediaMuxer::drainAudioFifo(bool flush)
+{
+    const int frameSize = audioCodec->frame_size > 0 ? audioCodec->frame_size : 1024;
+    const bool smallLastFrame = audioCodec->codec->capabilities & AV_CODEC_CAP_SMALL_LAST_FRAME;
+    while (av_audio_fifo_size(audioFifo) >= frameSize || (flush && av_audio_fifo_size(audioFifo) > 0)) {
+        const int n = std::min(av_audio_fifo_size(audioFifo), frameSize);
+        int ret = av_frame_make_writable(audioFrame);
+        if (ret < 0) {
+            return fail("音频帧不可写", ret);
+        }
+        audioFrame->nb_samples = frameSize;
+        av_audio_fifo_read(audioFifo, reinterpret_cast<void**>(audioFrame->data), n);
+        if (n < frameSize) {
+            if (smallLastFrame) {
+                audioFrame->nb_samples = n;
+            } else {
+                av_samples_set_silence(audioFrame->data, n, frameSize - n,
+                                       audioCodec->ch_layout.nb_channels, AV_SAMPLE_FMT_FLTP);
+            }
+        }
+        audioFrame->pts = audioPts;
+        audioPts += audioFrame->nb_samples;
+        if (!encode(audioCodec, audioStream, audioFrame, audioPacket)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MediaMuxer::close()
+{
+    if (ready) {
+        if (videoCodec) {
+            encode(videoCodec, videoStream, nullptr, videoPacket);
+        }
+        {
+            std::lock_guard<std::mutex> lock(audioMutex);
+            if (audioCodec) {
+                // 取出重采样器内部延迟的样本，再冲刷不足一帧的尾巴
+                const int channels = audioCodec->ch_layout.nb_channels;
+                const int capacity = swr_get_out_samples(swr, 0);
+                if (capacity > 0) {
+                    convertBuffer.resize(static_cast<size_t>(capacity) * channels);
+                    uint8_t* planes[2];
+                    for (int c = 0; c < channels; ++c) {
+                        planes[c] = reinterpret_cast<uint8_t*>(convertBuffer.data() + static_cast<size_t>(c) * capacity);
+                    }
+                    const int converted = swr_convert(swr, planes, capacity, nullptr, 0);
+                    if (converted > 0) {
+                        av_audio_fifo_write(audioFifo, reinterpret_cast<void**>(planes), converted);
+                    }
+                }
+                drainAudioFifo(true);
+                encode(audioCodec, audioStream, nullptr, audioPacket);
+            }
+            ready = false;
+        }
+        if (format) {
+            std::lock_guard<std::mutex> lock(writeMutex);
+            av_write_trailer(format);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(audioMutex);
+    if (format && !(format->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&format->pb);
+    }
+    avformat_free_context(format);
+    format = nullptr;
+    ready = false;
+
+    avcodec_free_context(&videoCodec);
+    av_frame_free(&videoFrame);
+    av_packet_free(&videoPacket);
+    sws_freeContext(sws);
+    sws = nullptr;
+    videoStream = nullptr;
+
+    avcodec_free_context(&audioCodec);
+    av_frame_free(&audioFrame);
+    av_packet_free(&audioPacket);
+    swr_free(&swr);
+    if (audioFifo) {
+        av_audio_fifo_free(audioFifo);
+        audioFifo = nullptr;
+    }
+    audioStream = nullptr;
+    convertBuffer.clear();
+}
+
+bool MediaMuxer::concatSegments(const std::vector<std::string>& inputs, const std::string& output,
+                                std::string* error)
+{
+    auto report = [error](const std::string& what, int code) {
+        const std::string message = code < 0 ? what + "：" + avError(code) : what;
+        std::cerr << "[MediaMuxer] " << message << std::endl;
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    if (inputs.empty()) {
+        return report("没有需要合并的分段", 0);
+    }
+
+    AVFormatContext* out = nullptr;
+    int ret = avformat_alloc_output_context2(&out, nullptr, nullptr, output.c_str());
+    if (ret < 0 || !out) {
+        return report("无法根据扩展名确定封装格式", ret);
+    }
+    AVPacket* packet = av_packet_alloc();
+    std::vector<int64_t> lastDts;
+    int64_t offsetUs = 0;       // 当前分段在输出时间轴上的起点
+    bool ok = true;
+
+    for (size_t i = 0; i < inputs.size() && ok; ++i) {
+        AVFormatContext* in = nullptr;
+        ret = avformat_open_input(&in, inputs[i].c_str(), nullptr, nullptr);
+        if (ret < 0 || (ret = avformat_find_stream_info(in, nullptr)) < 0) {
+            ok = report("无法读取分段 " + inputs[i], ret);
+            avformat_close_input(&in);
+            break;
+        }
+        if (i == 0) {
+            // 以第一个分段的流参数建立输出流，直接拷贝码流不重新编码
+            for (unsigned int s = 0; s < in->nb_streams && ok; ++s) {
+                AVStream* stream = avformat_new_stream(out, nullptr);
+                if (!stream || avcodec_parameters_copy(stream->codecpar, in->streams[s]->codecpar) < 0) {
+                    ok = report("创建输出流失败", 0);
+                    break;
+                }
+                stream->codecpar->codec_tag = 0;
+                stream->time_base = in->streams[s]->time_base;
+            }
+            lastDts.assign(in->nb_streams, AV_NOPTS_VALUE);
+            if (ok && !(out->oformat->flags & AVFMT_NOFILE) && (ret = avio_open(&out->pb, output.c_str(), AVIO_FLAG_WRITE)) < 0) {
+                ok = report("无法创建文件 " + output, ret);
+            }
+            if (ok && (ret = avformat_write_header(out, nullptr)) < 0) {
+                ok = report("写入文件头失败", ret);
+            }
+        } else if (in->nb_streams != out->nb_streams) {
+            ok = report("分段 " + inputs[i] + " 的流数量与第一个分段不一致", 0);
+        }
+
+        int64_t segmentEndUs = 0;
+        while (ok && (ret = av_read_frame(in, packet)) >= 0) {
+            const int index = packet->stream_index;
+            const AVRational inBase = in->streams[index]->time_base;
+            const AVRational outBase = out->streams[index]->time_base;
+            const int64_t offset = av_rescale_q(offsetUs, AVRational{1, 1000000}, outBase);
+            if (packet->pts != AV_NOPTS_VALUE) {
+                const int64_t endUs = av_rescale_q(packet->pts + packet->duration, inBase, AVRational{1, 1000000});
+                segmentEndUs = std::max(segmentEndUs, endUs);
+            }
+            av_packet_rescale_ts(packet, inBase, outBase);
+            if (packet->pts != AV_NOPTS_VALUE) {
+                packet->pts += offset;
+            }
+            if (packet->dts != AV_NOPTS_VALUE) {
+                packet->dts += offset;
+                // 分段交界处可能因取整出现 DTS 回退，顺延保证单调
+                if (lastDts[index] != AV_NOPTS_VALUE && packet->dts <= lastDts[index]) {
+                    const int64_t shift = lastDts[index] + 1 - packet->dts;
+                    packet->dts += shift;
+                    if (packet->pts != AV_NOPTS_VALUE) {
+                        packet->pts = std::max(packet->pts + shift, packet->dts);
+                    }
+                }
+                lastDts[index] = packet->dts;
+            }
+            packet->pos = -1;
+            ret = av_interleaved_write_frame(out, packet);
+            if (ret < 0) {
+                ok = report("写入数据包失败", ret);
+            }
+        }
+        av_packet_unref(packet);
+        offsetUs += segmentEndUs;
+        avformat_close_input(&in);
+    }
+
+    if (ok && (ret = av_write_trailer(out)) < 0) {
+        ok = report("写入文件尾失败", ret);
+    }
+    if (!(out->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&out->pb);
+    }
+    avformat_free_context(out);
+    av_packet_free(&packet);
+    return ok;
+}
@@ -0,0 +1,169 @@
+#ifndef MEDIAMUXER_H
+#define MEDIAMUXER_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVStream;
+struct AVFrame;
+struct AVPacket;
+struct AVAudioFifo;
+struct SwsContext;
+struct SwrContext;
+
+/**
+ * @brief 录制输出参数
+ */
+struct RecordingOptions {
+    cv::Size frameSize;         // 输出分辨率；与输入帧不同时在颜色转换时一并缩放
+    double fps = 30.0;          // 输出帧率
+    std::string codec = "h264"; // 视频编码器（h264 / mpeg4 / mjpeg）
+    int bitrateKbps = 0;        // 目标码率（kbps），0 表示质量优先（H.264 用 CRF）
+    // H.264 参数（libx264 全部生效；openh264 只使用码率和线程数）
+    std::string preset = "veryfast"; // ultrafast ... medium
+    std::string tune = "zerolatency"; // 为空表示不指定
+    int crf = 23;               // bitrateKbps 为 0 时的恒定质量因子，越小质量越高
+    int threads = 0;            // 编码线程数，0 表示由编码器自行决定
+    // 防崩溃
+    bool fragmented = true;     // MP4 写成分片格式（moov 前置，每个关键帧一个分片），中途断电也能播放
+    int segmentMinutes = 0;     // 每 N 分钟滚动到新文件，0 表示不分段
+    bool nv12Input = false;     // 输入为 NV12 帧时优先让编码器直接使用 NV12，省去颜色转换
+    // 帧时间戳由帧源按帧号推算、不跟随墙钟（不限速回放）：视频时间轴以第一帧为零点，不录制音频
+    bool sourceClock = false;
+};
+
+/**
+ * @brief 音频输入格式（交错的 16 位 PCM）
+ */
+struct MuxerAudioFormat {
+    int sampleRate = 48000;
+    int channels = 2;
+    int bitrateKbps = 128;      // AAC 码率
+};
+
+/**
+ * @brief 进程内音视频编码与封装（libavformat/libavcodec）
+ *
+ * 视频帧（BGR）与麦克风 PCM 直接编码并交错写入最终文件，录制结束即可使用，无需临时文件和外部 ffmpeg。
+ * writeVideo 与 writeAudio 可以在不同线程调用，写包时内部加锁。
+ *
+ * 路径为空时只打开编码器不写文件，编码后的数据包通过 PacketTap 交给调用方（即时回放）。
+ *
+ * 时间戳：音频 PTS 由累计采样数得出（音频时钟为主时钟）；视频按采集时间戳写入真实 PTS（可变帧率），
+ * 并减去音频设备时钟相对单调时钟的漂移，长时间录制也不会逐渐音画不同步。
+ */
+class MediaMuxer {
+public:
+    /**
+     * @brief 编码输出回调，packet 的时间戳以对应编码器的 time_base 为单位，回调返回后即失效
+     */
+    using PacketTap = std::function<void(const AVPacket* packet, bool video)>;
+
+    MediaMuxer() = default;
+    ~MediaMuxer();
+    MediaMuxer(const MediaMuxer&) = delete;
+    MediaMuxer& operator=(const MediaMuxer&) = delete;
+
+    /**
+     * @brief 设置编码输出回调，需在 open 之前调用
+     */
+    void setPacketTap(PacketTap callback) { tap = std::move(callback); }
+
+    /**
+     * @brief 创建输出文件（容器由扩展名决定）
+     * @param path 为空时只编码不写文件
+     * @param audio 为空时只录制视频
+     * @param timelineOriginUs 文件时间轴零点（mediaClockUs），负数表示取打开时刻；
+     *                         续写分段时传入切换帧的采集时间，队列中积压的帧才不会挤到零点附近
+     * @return 失败时返回 false，原因见 lastError()
+     */
+    bool open(const std::string& path, const RecordingOptions& video, const MuxerAudioFormat* audio,
+              int64_t timelineOriginUs = -1);
+
+    /**
+     * @brief 编码一帧图像，尺寸与输出不同时在颜色转换的同时缩放
+     * @param frame BGR（CV_8UC3）或 NV12（CV_8UC1，高为图像高度的 1.5 倍，Y 平面后紧跟交错的 UV 平面）；
+     *              NV12 输入且编码器像素格式也是 NV12、尺寸一致时直接拷贝平面
+     * @param captureUs 采集时间戳（mediaClockUs），早于时间轴零点的帧按 0 处理；
+     *                  sourceClock 时为帧源时间戳，第一帧即为零点
+     */
+    bool writeVideo(const cv::Mat& frame, int64_t captureUs);
+
+    /**
+     * @brief 编码一段交错的 16 位 PCM
+     * @param frames 采样帧数（每帧包含所有声道）
+     * @param arrivalUs 这段数据最后一个样本的到达时间（mediaClockUs）
+     */
+    bool writeAudio(const int16_t* samples, int frames, int64_t arrivalUs);
+
+    /**
+     * @brief 冲刷编码器、写入文件尾并关闭文件
+     */
+    void close();
+
+    /**
+     * @brief 无损合并多个分段（参数需一致），按顺序平移时间戳后重新封装为普通文件
+     * @param error 失败原因（可为空）
+     */
+    static bool concatSegments(const std::vector<std::string>& inputs, const std::string& output,
+                               std::string* error = nullptr);
+
+    bool isOpened() const { return ready; }
+    const AVCodecContext* videoContext() const { return videoCodec; }
+    const AVCodecContext* audioContext() const { return audioCodec; }
+    /**
+     * @brief 实际使用的视频编码器名称（如 libx264、libopenh264）
+     */
+    std::string videoEncoderName() const;
+    bool hasAudio() const { return audioCodec != nullptr; }
+    std::string lastError() const;
+
+private:
+    bool openVideo(const RecordingOptions& options);
+    bool openAudio(const MuxerAudioFormat& input);
+    bool encode(AVCodecContext* codec, AVStream* stream, AVFrame* frame, AVPacket* packet);
+    bool drainAudioFifo(bool flush);
+    bool fail(const std::string& what, int code = 0);
+
+    std::mutex writeMutex;      // 保护 av_interleaved_write_frame
+    std::mutex audioMutex;      // 保护音频重采样与编码状态
+    AVFormatContext* format = nullptr; // 仅编码模式下为空
+    bool ready = false;         // 文件头已写入（或仅编码模式下编码器已打开），可以接收数据
+    PacketTap tap;
+    int64_t originUs = 0;       // 文件时间轴零点（mediaClockUs）
+    int64_t videoOriginUs = 0;  // 视频时间戳的零点：墙钟下等于 originUs，sourceClock 下取第一帧
+    bool videoOriginPending = false;
+
+    AVCodecContext* videoCodec = nullptr;
+    AVStream* videoStream = nullptr;
+    AVFrame* videoFrame = nullptr;
+    AVPacket* videoPacket = nullptr;
+    SwsContext* sws = nullptr;
+    int64_t lastVideoPts = -1;
+
+    AVCodecContext* audioCodec = nullptr;
+    AVStream* audioStream = nullptr;
+    AVFrame* audioFrame = nullptr;
+    AVPacket* audioPacket = nullptr;
+    SwrContext* swr = nullptr;
+    AVAudioFifo* audioFifo = nullptr;
+    std::vector<float> convertBuffer; // 重采样输出（平面格式，每声道连续存放）
+    int inputSampleRate = 0;
+    int64_t audioPts = 0;
+    int64_t audioAnchorUs = -1; // 第一个输入样本的采集时间
+    int64_t inputSamples = 0;   // 已收到的输入采样帧数
+    double audioDriftEma = 0.0; // 到达时间相对采样时钟的偏差（平滑后）
+    std::atomic<int64_t> audioDriftUs{0};
+
+    mutable std::mutex errorMutex;
+    std::string error;
+};
+
+#endif // MEDIAMUXER_H
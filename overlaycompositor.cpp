@@ -0,0 +1,547 @@
+#include "overlaycompositor.h"
+#include "alphablend.h"
+#include "textrenderer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// 动图受内存上限压缩时短边不小于该值（与 loadAnimatedSticker 一致），宁可略超上限也不缩没
+constexpr int kMinAnimatedSide = 16;
+
+// 将 BGR/BGRA/灰度图转为预乘 alpha 的 BGRA，并乘上整体不透明度
+void premultiply(const cv::Mat& src, cv::Mat& dst, double opacity)
+{
+    cv::Mat bgra;
+    if (src.channels() == 4) {
+        bgra = src;
+    } else if (src.channels() == 3) {
+        cv::cvtColor(src, bgra, cv::COLOR_BGR2BGRA);
+    } else {
+        cv::cvtColor(src, bgra, cv::COLOR_GRAY2BGRA);
+    }
+    const int op = cvRound(std::clamp(opacity, 0.0, 1.0) * 255.0);
+    dst.create(bgra.size(), CV_8UC4);
+    for (int y = 0; y < bgra.rows; ++y) {
+        const uchar* s = bgra.ptr<uchar>(y);
+        uchar* d = dst.ptr<uchar>(y);
+        for (int x = 0; x < bgra.cols; ++x, s += 4, d += 4) {
+            const int a = div255(s[3] * op);
+            d[0] = static_cast<uchar>(div255(s[0] * a));
+            d[1] = static_cast<uchar>(div255(s[1] * a));
+            d[2] = static_cast<uchar>(div255(s[2] * a));
+            d[3] = static_cast<uchar>(a);
+        }
+    }
+}
+}
+
+int OverlayCompositor::insertLayer(OverlayLayer layer)
+{
+    layer.id = nextId++;
+    layer.dirty = true;
+    const int id = layer.id;
+    layers.push_back(std::move(layer));
+    sortLayers();
+    return id;
+}
+
+int OverlayCompositor::addImageLayer(const cv::Mat& image, int x, int y, int z)
+{
+    OverlayLayer layer;
+    layer.type = OverlayLayerType::Image;
+    layer.image = image;
+    layer.x = x;
+    layer.y = y;
+    layer.z = z;
+    return insertLayer(std::move(layer));
+}
+
+int OverlayCompositor::addTextLayer(const std::string& text, int x, int y, int fontSize,
+                                    const std::string& fontName, const cv::Scalar& color, int z)
+{
+    OverlayLayer layer;
+    layer.type = OverlayLayerType::Text;
+    layer.text = text;
+    layer.fontSize = fontSize;
+    layer.fontName = fontName;
+    layer.color = color;
+    layer.x = x;
+    layer.y = y;
+    layer.z = z;
+    return insertLayer(std::move(layer));
+}
+
+int OverlayCompositor::addSolidLayer(const cv::Size& size, const cv::Scalar& color, int x, int y, int z)
+{
+    OverlayLayer layer;
+    layer.type = OverlayLayerType::Solid;
+    layer.solidSize = size;
+    layer.color = color;
+    layer.x = x;
+    layer.y = y;
+    layer.z = z;
+    return insertLayer(std::move(layer));
+}
+
+int OverlayCompositor::addAnimatedLayer(AnimatedFrames animation, int x, int y, int z)
+{
+    OverlayLayer layer;
+    layer.type = OverlayLayerType::Animated;
+    layer.animation = std::move(animation);
+    layer.x = x;
+    layer.y = y;
+    layer.z = z;
+    return insertLayer(std::move(layer));
+}
+
+int OverlayCompositor::addLiveTextLayer(const std::string& text, int x, int y, int fontSize,
+                                        const std::string& fontName, const cv::Scalar& color, int z)
+{
+    OverlayLayer layer;
+    layer.type = OverlayLayerType::LiveText;
+    layer.fontSize = fontSize;
+    layer.fontName = fontName;
+    layer.color = color;
+    layer.x = x;
+    layer.y = y;
+    layer.z = z;
+    layer.liveText = std::make_shared<LiveText>(fontName, fontSize);
+    layer.liveText->setText(text);
+    layer.text = text;
+    return insertLayer(std::move(layer));
+}
+
+int OverlayCompositor::addTickerLayer(const std::string& text, int y, int fontSize, const std::string& fontName,
+                                      const cv::Scalar& color, double speed, int z)
+{
+    OverlayLayer layer;
+    layer.type = OverlayLayerType::Ticker;
+    layer.text = text;
+    layer.fontSize = fontSize;
+    layer.fontName = fontName;
+    layer.color = color;
+    layer.y = y;
+    layer.z = z;
+    layer.tickerSpeed = speed;
+    layer.ticker = std::make_shared<TickerStrip>();
+    layer.ticker->setText(text, fontName, fontSize, fontSize * 4);
+    return insertLayer(std::move(layer));
+}
+
+void OverlayCompositor::removeLayer(int id)
+{
+    layers.erase(std::remove_if(layers.begin(), layers.end(),
+                                [id](const OverlayLayer& l) { return l.id == id; }),
+                 layers.end());
+}
+
+void OverlayCompositor::clear()
+{
+    layers.clear();
+}
+
+bool OverlayCompositor::hasLayer(int id) const
+{
+    return find(id) != nullptr;
+}
+
+OverlayLayer* OverlayCompositor::find(int id)
+{
+    for (auto& l : layers) {
+        if (l.id == id) return &l;
+    }
+    return nullptr;
+}
+
+const OverlayLayer* OverlayCompositor::find(int id) const
+{
+    for (const auto& l : layers) {
+        if (l.id == id) return &l;
+    }
+    return nullptr;
+}
+
+void OverlayCompositor::sortLayers()
+{
+    std::stable_sort(layers.begin(), layers.end(),
+                     [](const OverlayLayer& a, const OverlayLayer& b) { return a.z < b.z; });
+}
+
+void OverlayCompositor::setPosition(int id, int x, int y)
+{
+    if (OverlayLayer* l = find(id)) {
+        l->x = x;
+        l->y = y;
+    }
+}
+
+void OverlayCompositor::moveBy(int id, int dx, int dy)
+{
+    if (OverlayLayer* l = find(id)) {
+        l->x += dx;
+        l->y += dy;
+    }
+}
+
+void OverlayCompositor::setZ(int id, int z)
+{
+    if (OverlayLayer* l = find(id)) {
+        if (l->z != z) {
+            l->z = z;
+            sortLayers();
+        }
+    }
+}
+
+void OverlayCompositor::setOpacity(int id, double opacity)
+{
+    if (OverlayLayer* l = find(id)) {
+        if (l->opacity != opacity) {
+            l->opacity = opacity;
+            l->dirty = true;
+        }
+    }
+}
+
+void OverlayCompositor::setScale(int id, double scale)
+{
+    if (OverlayLayer* l = find(id)) {
+        if (l->scale != scale) {
+            l->scale = scale;
+            l->dirty = true;
+        }
+    }
+}
+
+void OverlayCompositor::setSolidSize(int id, const cv::Size& size)
+{
+    if (OverlayLayer* l = find(id)) {
+        if (l->solidSize != size) {
+            l->solidSize = size;
+            l->dirty = true;
+        }
+    }
+}
+
+void OverlayCompositor::setVisible(int id, bool visible)
+{
+    if (OverlayLayer* l = find(id)) {
+        l->visible = visible;
+    }
+}
+
+void OverlayCompositor::setImage(int id, const cv::Mat& image)
+{
+    if (OverlayLayer* l = find(id)) {
+        l->image = image;
+        l->dirty = true;
+    }
+}
+
+void OverlayCompositor::setText(int id, const std::string& text)
+{
+    if (OverlayLayer* l = find(id)) {
+        if (l->text != text) {
+            l->text = text;
+            if (l->type == OverlayLayerType::LiveText) {
+                l->liveText->setText(text); // 只重画变化的字符
+            } else if (l->type == OverlayLayerType::Ticker) {
+                l->ticker->setText(text, l->fontName, l->fontSize, l->fontSize * 4);
+            } else {
+                l->dirty = true;
+            }
+        }
+    }
+}
+
+void OverlayCompositor::setFont(int id, const std::string& fontName, int fontSize)
+{
+    if (OverlayLayer* l = find(id)) {
+        if (l->fontName != fontName || l->fontSize != fontSize) {
+            l->fontName = fontName;
+            l->fontSize = fontSize;
+            if (l->type == OverlayLayerType::LiveText) {
+                l->liveText = std::make_shared<LiveText>(fontName, fontSize);
+                l->liveText->setText(l->text);
+            } else if (l->type == OverlayLayerType::Ticker) {
+                l->ticker->setText(l->text, fontName, fontSize, fontSize * 4);
+            } else {
+                l->dirty = true;
+            }
+        }
+    }
+}
+
+void OverlayCompositor::setTickerSpeed(int id, double speed)
+{
+    if (OverlayLayer* l = find(id)) {
+        l->tickerSpeed = speed;
+    }
+}
+
+cv::Size OverlayCompositor::layerSize(int id) const
+{
+    const OverlayLayer* l = find(id);
+    return l ? l->drawRect.size() : cv::Size();
+}
+
+void OverlayCompositor::setColor(int id, const cv::Scalar& color)
+{
+    if (OverlayLayer* l = find(id)) {
+        if (l->color != color) {
+            l->color = color;
+            l->dirty = true;
+        }
+    }
+}
+
+// 重新生成某一层的预乘缓存（仅在 dirty 时调用）
+void OverlayCompositor::rasterize(OverlayLayer& layer) const
+{
+    layer.dirty = false;
+    layer.cacheOffset = cv::Point(0, 0);
+    layer.currentFrame = 0;
+
+    switch (layer.type) {
+    case OverlayLayerType::Image: {
+        if (layer.image.empty()) {
+            layer.cache.release();
+            return;
+        }
+        cv::Mat scaled = layer.image;
+        if (layer.scale != 1.0) {
+            const int interp = layer.scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR;
+            cv::resize(layer.image, scaled, cv::Size(), layer.scale, layer.scale, interp);
+        }
+        premultiply(scaled, layer.cache, layer.opacity);
+        break;
+    }
+    case OverlayLayerType::Animated: {
+        const auto& frames = layer.animation.frames;
+        if (frames.empty()) {
+            layer.cache.release();
+            break;
+        }
+        // 所有帧缩放+预乘后纵向拼成一张图集，合成时只需按帧号偏移行指针。
+        // 图集与源帧一起计入内存上限：放大后超出剩余额度时缩小实际缩放比例（帧数很多的大动图放大 3 倍可达源帧的十几倍）
+        size_t sourceBytes = 0;
+        for (const cv::Mat& f : frames) {
+            sourceBytes += f.total() * f.elemSize();
+        }
+        const double unitBytes = 4.0 * frames.front().cols * frames.front().rows * static_cast<double>(frames.size());
+        const double budget = animationMemoryCap > sourceBytes ? static_cast<double>(animationMemoryCap - sourceBytes) : 0.0;
+        double scale = layer.scale;
+        if (unitBytes * scale * scale > budget) {
+            const double minScale = static_cast<double>(kMinAnimatedSide)
+                                    / std::min(frames.front().cols, frames.front().rows);
+            scale = std::max(std::sqrt(budget / unitBytes), std::min(minScale, layer.scale));
+        }
+        const cv::Size size(std::max(1, cvRound(frames.front().cols * scale)),
+                            std::max(1, cvRound(frames.front().rows * scale)));
+        layer.cache.create(size.height * static_cast<int>(frames.size()), size.width, CV_8UC4);
+        cv::Mat scaled;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const cv::Mat* src = &frames[i];
+            if (src->size() != size) {
+                const int interp = scale < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR;
+                cv::resize(*src, scaled, size, 0, 0, interp);
+                src = &scaled;
+            }
+            cv::Mat slot = layer.cache.rowRange(static_cast<int>(i) * size.height,
+                                                static_cast<int>(i + 1) * size.height);
+            premultiply(*src, slot, layer.opacity);
+        }
+        layer.frameSize = size;
+        return;
+    }
+    case OverlayLayerType::Solid: {
+        if (layer.solidSize.empty()) {
+            layer.cache.release();
+            return;
+        }
+        cv::Mat solid(layer.solidSize, CV_8UC3, layer.color);
+        premultiply(solid, layer.cache, layer.opacity);
+        break;
+    }
+    case OverlayLayerType::Text: {
+        if (layer.text.empty()) {
+            layer.cache.release();
+            return;
+        }
+        cv::Mat coverage;
+        cv::Point offset;
+        if (!TextRenderer::instance().renderCoverage(layer.text, layer.fontSize, layer.fontName,
+                                                     coverage, offset) || coverage.empty()) {
+            layer.cache.release();
+            return;
+        }
+        const int op = cvRound(std::clamp(layer.opacity, 0.0, 1.0) * 255.0);
+        layer.cache.create(coverage.size(), CV_8UC4);
+        for (int y = 0; y < coverage.rows; ++y) {
+            const uchar* c = coverage.ptr<uchar>(y);
+            uchar* d = layer.cache.ptr<uchar>(y);
+            for (int x = 0; x < coverage.cols; ++x, d += 4) {
+                const int a = div255(c[x] * op);
+                d[0] = static_cast<uchar>(div255(cvRound(layer.color[0]) * a));
+                d[1] = static_cast<uchar>(div255(cvRound(layer.color[1]) * a));
+                d[2] = static_cast<uchar>(div255(cvRound(layer.color[2]) * a));
+                d[3] = static_cast<uchar>(a);
+            }
+        }
+        layer.cacheOffset = offset;
+        break;
+    }
+    case OverlayLayerType::LiveText:
+    case OverlayLayerType::Ticker:
+        // 动态文字自行维护覆盖率蒙版，不使用预乘缓存
+        break;
+    }
+    layer.frameSize = layer.cache.size();
+}
+
+bool OverlayCompositor::prepareLayers(cv::Size frameSize, int64_t timeMs, cv::Rect& unionRect)
+{
+    // 重新栅格化脏层，并求所有可见层包围盒的并集
+    const cv::Rect frameRect(0, 0, frameSize.width, frameSize.height);
+    bool any = false;
+    for (auto& layer : layers) {
+        layer.drawRect = cv::Rect();
+        if (!layer.visible) continue;
+        if (layer.type == OverlayLayerType::LiveText) {
+            layer.liveMask = layer.liveText->coverage();
+            layer.drawRect = cv::Rect(layer.x, layer.y, layer.liveMask.cols, layer.liveMask.rows);
+        } else if (layer.type == OverlayLayerType::Ticker) {
+            layer.liveMask = layer.ticker->coverage();
+            if (layer.liveMask.empty()) continue;
+            if (layer.animStartMs < 0) layer.animStartMs = timeMs;
+            // 字幕从右向左移动：随时间增加条带中的取样起点
+            const int64_t moved = static_cast<int64_t>((timeMs - layer.animStartMs) * layer.tickerSpeed / 1000.0);
+            layer.tickerOffset = static_cast<int>(moved % layer.liveMask.cols);
+            layer.drawRect = cv::Rect(0, layer.y, frameSize.width, layer.liveMask.rows);
+        } else {
+            if (layer.dirty) rasterize(layer);
+            if (layer.cache.empty()) continue;
+            layer.drawRect = layer.rect();
+        }
+        if (layer.drawRect.empty()) continue;
+        if (layer.type == OverlayLayerType::Animated && layer.animation.isAnimated()) {
+            // 按时间戳二分查找当前帧，不做任何解码或分配
+            if (layer.animStartMs < 0) layer.animStartMs = timeMs;
+            const int64_t t = (timeMs - layer.animStartMs) % layer.animation.durationMs;
+            const auto& ends = layer.animation.frameEndMs;
+            layer.currentFrame = static_cast<int>(std::upper_bound(ends.begin(), ends.end(), t) - ends.begin());
+            layer.currentFrame = std::min(layer.currentFrame, static_cast<int>(ends.size()) - 1);
+        }
+        cv::Rect r = layer.drawRect & frameRect;
+        if (r.empty()) continue;
+        unionRect = any ? (unionRect | r) : r;
+        any = true;
+    }
+    return any;
+}
+
+template <typename Rows>
+void OverlayCompositor::blendRows(const cv::Rect& unionRect, int frameWidth, Rows& rows)
+{
+    // 逐行遍历并集区域一次，每行内按 z 顺序叠加覆盖到该行的各层
+    for (int y = unionRect.y; y < unionRect.y + unionRect.height; ++y) {
+        rows.seek(y);
+        for (const auto& layer : layers) {
+            const cv::Rect& r = layer.drawRect;
+            if (r.empty() || y < r.y || y >= r.y + r.height) continue;
+            const int x0 = std::max(r.x, 0);
+            const int x1 = std::min(r.x + r.width, frameWidth);
+            if (x0 >= x1) continue;
+
+            if (layer.type == OverlayLayerType::LiveText || layer.type == OverlayLayerType::Ticker) {
+                const uchar bgr[3] = {cv::saturate_cast<uchar>(layer.color[0]),
+                                      cv::saturate_cast<uchar>(layer.color[1]),
+                                      cv::saturate_cast<uchar>(layer.color[2])};
+                const uchar* mask = layer.liveMask.ptr<uchar>(y - r.y);
+                // 没有预乘缓存，不透明度在混合时乘到覆盖率上
+                const int op = cvRound(std::clamp(layer.opacity, 0.0, 1.0) * 255.0);
+                if (op == 0) continue;
+                if (op < 255) {
+                    scaledMask.resize(layer.liveMask.cols);
+                    for (int i = 0; i < layer.liveMask.cols; ++i) {
+                        scaledMask[i] = static_cast<uchar>(div255(mask[i] * op));
+                    }
+                    mask = scaledMask.data();
+                }
+                if (layer.type == OverlayLayerType::LiveText) {
+                    rows.color(x0, mask + (x0 - r.x), x1 - x0, bgr);
+                } else {
+                    // 条带首尾相接，窗口跨越末尾时分两段混合
+                    const int stripWidth = layer.liveMask.cols;
+                    int x = x0;
+                    int sx = layer.tickerOffset;
+                    while (x < x1) {
+                        const int n = std::min(x1 - x, stripWidth - sx);
+                        rows.color(x, mask + sx, n, bgr);
+                        x += n;
+                        sx = 0;
+                    }
+                }
+                continue;
+            }
+
+            const int srcRow = layer.currentFrame * layer.frameSize.height + (y - r.y);
+            rows.premultiplied(x0, layer.cache.ptr<uchar>(srcRow) + (x0 - r.x) * 4, x1 - x0);
+        }
+    }
+}
+
+namespace {
+// BGR 帧的行混合
+struct BgrRows {
+    cv::Mat& frame;
+    uchar* row = nullptr;
+
+    void seek(int y) { row = frame.ptr<uchar>(y); }
+    void color(int x, const uchar* mask, int n, const uchar bgr[3]) { alphaBlendColorRow(row + x * 3, mask, n, bgr); }
+    void premultiplied(int x, const uchar* src, int n) { alphaBlendPremultipliedRow(row + x * 3, src, n); }
+};
+
+// NV12 帧的行混合：偶数行同时写 UV 平面
+struct Nv12Rows {
+    cv::Mat& frame;
+    int height;
+    uchar* yRow = nullptr;
+    uchar* uvRow = nullptr;
+
+    void seek(int y)
+    {
+        yRow = frame.ptr<uchar>(y);
+        uvRow = (y & 1) == 0 ? frame.ptr<uchar>(height + y / 2) : nullptr;
+    }
+    void color(int x, const uchar* mask, int n, const uchar bgr[3]) { alphaBlendColorRowNV12(yRow, uvRow, x, mask, n, bgr); }
+    void premultiplied(int x, const uchar* src, int n) { alphaBlendPremultipliedRowNV12(yRow, uvRow, x, src, n); }
+};
+}
+
+void OverlayCompositor::composite(cv::Mat& frame, int64_t timeMs)
+{
+    if (layers.empty() || frame.empty() || frame.type() != CV_8UC3) {
+        return;
+    }
+    cv::Rect unionRect;
+    if (!prepareLayers(frame.size(), timeMs, unionRect)) {
+        return;
+    }
+    BgrRows rows{frame};
+    blendRows(unionRect, frame.cols, rows);
+}
+
+void OverlayCompositor::compositeNV12(cv::Mat& nv12, int64_t timeMs)
+{
+    if (layers.empty() || nv12.empty() || nv12.type() != CV_8UC1 || nv12.rows % 3 != 0) {
+        return;
+    }
+    const int height = nv12.rows * 2 / 3;
+    cv::Rect unionRect;
+    if (!prepareLayers(cv::Size(nv12.cols, height), timeMs, unionRect)) {
+        return;
+    }
+    Nv12Rows rows{nv12, height};
+    blendRows(unionRect, nv12.cols, rows);
+}
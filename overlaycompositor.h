@@ -0,0 +1,155 @@
+#ifndef OVERLAYCOMPOSITOR_H
+#define OVERLAYCOMPOSITOR_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "animatedsticker.h"
+#include "livetext.h"
+
+/**
+ * @brief 叠加层类型
+ */
+enum class OverlayLayerType {
+    Image,  // 图片（Logo、前景图）
+    Text,   // 文字（下三分之一字幕等）
+    Solid,  // 纯色块（字幕底板等）
+    Animated, // 动图贴纸（GIF/APNG），所有帧预渲染进帧图集
+    LiveText, // 动态文字（时钟、录制计时），只重画变化的字符
+    Ticker    // 滚动字幕，整条预渲染后只移动取样窗口
+};
+
+/**
+ * @brief 单个叠加层
+ *
+ * cache 为预乘 alpha 的 BGRA 缓冲（已乘上 opacity），只有内容相关属性变化时才重新栅格化；
+ * 仅修改位置不会触发重绘。
+ */
+struct OverlayLayer {
+    int id = 0;
+    OverlayLayerType type = OverlayLayerType::Image;
+    int z = 0;
+    int x = 0;
+    int y = 0;
+    double opacity = 1.0;
+    double scale = 1.0;
+    bool visible = true;
+
+    // 图片层
+    cv::Mat image;
+    // 文字层
+    std::string text;
+    int fontSize = 40;
+    std::string fontName = "微软雅黑";
+    // 文字/纯色层颜色（BGR）
+    cv::Scalar color = cv::Scalar(255, 255, 255);
+    // 纯色层尺寸
+    cv::Size solidSize;
+    // 动图层源帧
+    AnimatedFrames animation;
+    // 动态文字/滚动字幕层（以覆盖率蒙版 + color 直接混合，不经过预乘缓存）
+    std::shared_ptr<LiveText> liveText;
+    std::shared_ptr<TickerStrip> ticker;
+    double tickerSpeed = 120.0; // 像素/秒
+
+    // 栅格化缓存
+    cv::Mat cache;            // CV_8UC4，预乘BGRA；动图层为所有帧纵向拼接的图集
+    cv::Size frameSize;       // 单帧尺寸（非动图层等于 cache 尺寸）
+    cv::Point cacheOffset;    // 缓存左上角相对(x, y)的偏移（文字裁边后）
+    bool dirty = true;
+    int currentFrame = 0;     // 动图层当前帧在图集中的序号
+    int64_t animStartMs = -1; // 动图层/滚动字幕开始播放的时间戳
+
+    // 每次合成时计算的绘制状态
+    cv::Rect drawRect;        // 本帧在画面中的区域（未裁剪）
+    cv::Mat liveMask;         // 动态文字/滚动字幕本帧使用的覆盖率蒙版
+    int tickerOffset = 0;     // 滚动字幕在条带中的起始列
+
+    cv::Rect rect() const {
+        return cv::Rect(x + cacheOffset.x, y + cacheOffset.y, frameSize.width, frameSize.height);
+    }
+};
+
+/**
+ * @brief 多图层叠加合成器
+ *
+ * 按 z 顺序管理图片/文字/纯色层，每层预渲染为预乘缓存，合成时只遍历所有可见层包围盒的并集一次。
+ */
+class OverlayCompositor {
+public:
+    int addImageLayer(const cv::Mat& image, int x = 0, int y = 0, int z = 0);
+    int addTextLayer(const std::string& text, int x, int y, int fontSize,
+                     const std::string& fontName, const cv::Scalar& color, int z = 0);
+    int addSolidLayer(const cv::Size& size, const cv::Scalar& color, int x, int y, int z = 0);
+    int addAnimatedLayer(AnimatedFrames animation, int x = 0, int y = 0, int z = 0);
+    int addLiveTextLayer(const std::string& text, int x, int y, int fontSize,
+                         const std::string& fontName, const cv::Scalar& color, int z = 0);
+    /**
+     * @brief 添加横贯画面的滚动字幕层
+     * @param y 字幕顶部位置
+     * @param speed 滚动速度（像素/秒）
+     */
+    int addTickerLayer(const std::string& text, int y, int fontSize, const std::string& fontName,
+                       const cv::Scalar& color, double speed, int z = 0);
+
+    void removeLayer(int id);
+    void clear();
+    bool hasLayer(int id) const;
+    bool empty() const { return layers.empty(); }
+
+    void setPosition(int id, int x, int y);
+    void moveBy(int id, int dx, int dy);
+    void setZ(int id, int z);
+    void setOpacity(int id, double opacity);
+    void setScale(int id, double scale);
+    /**
+     * @brief 修改纯色层尺寸
+     */
+    void setSolidSize(int id, const cv::Size& size);
+    void setVisible(int id, bool visible);
+    void setImage(int id, const cv::Mat& image);
+    void setText(int id, const std::string& text);
+    void setFont(int id, const std::string& fontName, int fontSize);
+    void setColor(int id, const cv::Scalar& color);
+    void setTickerSpeed(int id, double speed);
+    /**
+     * @brief 设置每个动图层的内存上限（源帧 + 缩放后的预乘图集），超出时缩小实际缩放比例
+     */
+    void setAnimationMemoryCap(size_t bytes) { animationMemoryCap = bytes; }
+    /**
+     * @brief 获取层在上一帧中的绘制区域（用于根据文字宽度调整位置）
+     */
+    cv::Size layerSize(int id) const;
+
+    /**
+     * @brief 将所有可见层合成到帧上（帧为BGR）
+     * @param frame 目标帧，原地修改
+     * @param timeMs 当前时间戳（毫秒），用于选择动图层的帧
+     */
+    void composite(cv::Mat& frame, int64_t timeMs = 0);
+
+    /**
+     * @brief 将所有可见层直接合成到 NV12 帧上，不经过 BGR 转换
+     * @param nv12 目标帧（CV_8UC1，高为图像高度的 1.5 倍），原地修改
+     */
+    void compositeNV12(cv::Mat& nv12, int64_t timeMs = 0);
+
+private:
+    OverlayLayer* find(int id);
+    const OverlayLayer* find(int id) const;
+    int insertLayer(OverlayLayer layer);
+    void sortLayers();
+    void rasterize(OverlayLayer& layer) const;
+    bool prepareLayers(cv::Size frameSize, int64_t timeMs, cv::Rect& unionRect);
+    template <typename Rows>
+    void blendRows(const cv::Rect& unionRect, int frameWidth, Rows& rows);
+
+    std::vector<OverlayLayer> layers; // 按 z 升序
+    int nextId = 1;
+    size_t animationMemoryCap = 256 * 1024 * 1024;
+    std::vector<uchar> scaledMask; // 半透明动态文字当前行乘上不透明度后的覆盖率，跨帧复用
+};
+
+#endif // OVERLAYCOMPOSITOR_H
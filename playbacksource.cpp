@@ -0,0 +1,205 @@
+#include "playbacksource.h"
+#include "mediaclock.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+void PlaybackSource::startPlayback(cv::Size size, double fps)
+{
+    format.size = size;
+    format.fps = fps > 0 ? fps : 30.0;
+    format.fourcc.clear();
+    start(pacing == SourcePacing::AsFastAsPossible);
+}
+
+void PlaybackSource::run()
+{
+    const int64_t intervalUs = std::llround(1000000.0 / format.fps);
+    const int64_t startUs = mediaClockUs();
+    for (int64_t n = 0; running; ++n) {
+        const int64_t captureUs = startUs + n * intervalUs;
+        if (pacing == SourcePacing::RealTime) {
+            const int64_t waitUs = captureUs - mediaClockUs();
+            if (waitUs > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+            }
+        }
+        // 每帧使用新的 Mat：上一帧可能仍被处理线程或编码队列引用
+        cv::Mat frame;
+        if (!nextFrame(frame) || frame.empty()) {
+            running = false;
+            break;
+        }
+        ++captured;
+        publish(std::move(frame), captureUs, ++nextSequence);
+    }
+}
+
+VideoFileSource::~VideoFileSource()
+{
+    release();
+}
+
+bool VideoFileSource::open(const std::string& path, bool loop)
+{
+    release();
+    if (!video.open(path) || !video.isOpened()) {
+        return false;
+    }
+    this->loop = loop;
+    const cv::Size size(static_cast<int>(video.get(cv::CAP_PROP_FRAME_WIDTH)),
+                        static_cast<int>(video.get(cv::CAP_PROP_FRAME_HEIGHT)));
+    startPlayback(size, video.get(cv::CAP_PROP_FPS));
+    return true;
+}
+
+void VideoFileSource::release()
+{
+    FrameSource::release();
+    if (video.isOpened()) {
+        video.release();
+    }
+}
+
+bool VideoFileSource::nextFrame(cv::Mat& frame)
+{
+    if (video.read(frame) && !frame.empty()) {
+        return true;
+    }
+    if (!loop) {
+        return false;
+    }
+    video.set(cv::CAP_PROP_POS_FRAMES, 0);
+    return video.read(frame) && !frame.empty();
+}
+
+ImageSequenceSource::~ImageSequenceSource()
+{
+    release();
+}
+
+bool ImageSequenceSource::open(const std::string& directory, double fps)
+{
+    release();
+    files.clear();
+    nextIndex = 0;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(fs::u8path(directory), ec)) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+        std::string ext = entry.path().extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp") {
+            files.push_back(entry.path().u8string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    // 以第一张能读出的图片确定帧尺寸
+    cv::Size size;
+    for (const std::string& file : files) {
+        const cv::Mat first = readImage(file);
+        if (!first.empty()) {
+            size = first.size();
+            break;
+        }
+    }
+    if (size.empty()) {
+        files.clear();
+        return false;
+    }
+    startPlayback(size, fps);
+    return true;
+}
+
+void ImageSequenceSource::release()
+{
+    FrameSource::release();
+}
+
+cv::Mat ImageSequenceSource::readImage(const std::string& path)
+{
+    // 经文件流读入再解码，Windows 下的中文路径也能打开
+    std::ifstream file(fs::u8path(path), std::ios::binary);
+    if (!file) {
+        return cv::Mat();
+    }
+    std::vector<uchar> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return data.empty() ? cv::Mat() : cv::imdecode(data, cv::IMREAD_COLOR);
+}
+
+bool ImageSequenceSource::nextFrame(cv::Mat& frame)
+{
+    // 跳过读不出的文件；整轮都失败才停止
+    for (size_t attempt = 0; attempt < files.size(); ++attempt) {
+        cv::Mat image = readImage(files[nextIndex]);
+        nextIndex = (nextIndex + 1) % files.size();
+        if (image.empty()) {
+            continue;
+        }
+        if (image.size() != format.size) {
+            cv::resize(image, frame, format.size);
+        } else {
+            frame = std::move(image);
+        }
+        return true;
+    }
+    return false;
+}
+
+SyntheticSource::~SyntheticSource()
+{
+    release();
+}
+
+bool SyntheticSource::open(cv::Size size, double fps)
+{
+    release();
+    if (size.width < 64 || size.height < 64) {
+        return false;
+    }
+    // 背景为从上到下的蓝灰渐变，只生成一次
+    background.create(size, CV_8UC3);
+    for (int y = 0; y < size.height; ++y) {
+        const double t = static_cast<double>(y) / size.height;
+        background.row(y).setTo(cv::Scalar(200 - 80 * t, 170 - 60 * t, 140 - 60 * t));
+    }
+    frameIndex = 0;
+    startPlayback(size, fps);
+    return true;
+}
+
+bool SyntheticSource::nextFrame(cv::Mat& frame)
+{
+    const cv::Size size = format.size;
+    const double t = static_cast<double>(frameIndex) / format.fps;
+    background.copyTo(frame);
+
+    // 人形每 6 秒左右往返一次，手臂每秒挥动一次
+    const int unit = size.height / 10;
+    const int cx = size.width / 2 + static_cast<int>(size.width / 4 * std::sin(2.0 * CV_PI * t / 6.0));
+    const int headY = size.height / 2 - unit * 2;
+    const cv::Scalar skin(120, 160, 220);
+    const cv::Scalar shirt(60, 90, 40);
+    cv::ellipse(frame, cv::Point(cx, size.height), cv::Size(unit * 2, unit * 4), 0, 180, 360, shirt, cv::FILLED, cv::LINE_AA);
+    cv::rectangle(frame, cv::Rect(cx - unit / 3, headY + unit, unit * 2 / 3, unit), skin, cv::FILLED);
+    cv::circle(frame, cv::Point(cx, headY), unit, skin, cv::FILLED, cv::LINE_AA);
+    const double angle = CV_PI / 4 * std::sin(2.0 * CV_PI * t);
+    const cv::Point shoulder(cx + unit * 3 / 2, size.height - unit * 3);
+    const cv::Point hand(shoulder.x + static_cast<int>(unit * 2 * std::sin(angle)),
+                         shoulder.y - static_cast<int>(unit * 2 * std::cos(angle)));
+    cv::line(frame, shoulder, hand, shirt, std::max(2, unit / 2), cv::LINE_AA);
+    cv::circle(frame, hand, unit / 3, skin, cv::FILLED, cv::LINE_AA);
+
+    cv::putText(frame, "#" + std::to_string(frameIndex), cv::Point(16, 40), cv::FONT_HERSHEY_SIMPLEX, 1.0,
+                cv::Scalar(255, 255, 255), 2, cv::LINE_AA);
+    ++frameIndex;
+    return true;
+}
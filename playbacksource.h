@@ -0,0 +1,97 @@
+#ifndef PLAYBACKSOURCE_H
+#define PLAYBACKSOURCE_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "framesource.h"
+
+/**
+ * @brief 不依赖摄像头的帧源基类（视频文件、图片序列、合成画面）
+ *
+ * 时间戳按帧号推算：第 n 帧为起播时刻 + n / fps。RealTime 下时间戳与墙钟一致，可以和麦克风音频一起录制；
+ * AsFastAsPossible 下时间戳跑在墙钟前面，录制时视频以第一帧为零点、不录音频，
+ * 文件中的帧间隔与机器速度无关（从哪一帧开始录取决于开始录制的时刻）。
+ * RealTime 下按时间戳等待后出帧；AsFastAsPossible 下不等待，但上一帧被取走前不出下一帧，
+ * 每一帧都会经过完整的处理管线，便于在无硬件的机器上复现问题和做基准测试。
+ */
+class PlaybackSource : public FrameSource {
+public:
+    /**
+     * @brief 设置出帧节奏，需在 open 之前调用
+     */
+    void setPacing(SourcePacing pacing) { this->pacing = pacing; }
+    SourcePacing framePacing() const { return pacing; }
+    bool wallClockTimestamps() const override { return pacing == SourcePacing::RealTime; }
+
+protected:
+    /**
+     * @brief 记录帧格式并启动工作线程，由派生类在 open 成功后调用
+     */
+    void startPlayback(cv::Size size, double fps);
+
+    /**
+     * @brief 生成下一帧（在工作线程中调用）
+     * @return 无法继续出帧时返回 false，帧源随即停止
+     */
+    virtual bool nextFrame(cv::Mat& frame) = 0;
+
+private:
+    void run() override;
+
+    SourcePacing pacing = SourcePacing::RealTime;
+};
+
+/**
+ * @brief 视频文件帧源，播放到结尾后从头循环
+ */
+class VideoFileSource : public PlaybackSource {
+public:
+    ~VideoFileSource() override;
+    bool open(const std::string& path, bool loop = true);
+    void release() override;
+
+private:
+    bool nextFrame(cv::Mat& frame) override;
+
+    cv::VideoCapture video;
+    bool loop = true;
+};
+
+/**
+ * @brief 图片序列帧源：按文件名顺序循环播放目录中的图片，尺寸与第一张不同的图片缩放到第一张的尺寸
+ */
+class ImageSequenceSource : public PlaybackSource {
+public:
+    ~ImageSequenceSource() override;
+    /**
+     * @param directory 图片目录（UTF-8，支持中文路径）
+     */
+    bool open(const std::string& directory, double fps = 30.0);
+    void release() override;
+
+private:
+    bool nextFrame(cv::Mat& frame) override;
+    static cv::Mat readImage(const std::string& path);
+
+    std::vector<std::string> files;
+    size_t nextIndex = 0;
+};
+
+/**
+ * @brief 合成画面帧源：渐变背景前一个左右移动、挥手的人形，画面只由帧号决定
+ */
+class SyntheticSource : public PlaybackSource {
+public:
+    ~SyntheticSource() override;
+    bool open(cv::Size size = cv::Size(1280, 720), double fps = 30.0);
+
+private:
+    bool nextFrame(cv::Mat& frame) override;
+
+    cv::Mat background;
+    uint64_t frameIndex = 0;
+};
+
+#endif // PLAYBACKSOURCE_H
@@ -1,4 +1,4 @@
-#include "PreviewWidget.h"
+#include "previewwidget.h"
 #include <QVBoxLayout>
 #include <QScrollArea>
 #include <QLabel>
@@ -0,0 +1,262 @@
+#include "recordingencoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+RecordingEncoder::RecordingEncoder(size_t capacity, QueueOverflowPolicy policy)
+    : capacity(capacity > 0 ? capacity : 1), policy(policy)
+{
+}
+
+RecordingEncoder::~RecordingEncoder()
+{
+    close();
+}
+
+bool RecordingEncoder::open(const std::string& path, const RecordingOptions& options, const MuxerAudioFormat* audio)
+{
+    close();
+    basePath = path;
+    this->options = options;
+    hasAudio = audio != nullptr;
+    if (audio) {
+        audioFormat = *audio;
+    }
+    segmentUs = static_cast<int64_t>(std::max(0, options.segmentMinutes)) * 60 * 1000000;
+    segmentStartUs = -1;
+    audioRing.reset(audio ? new AudioRing(audio->channels, audio->sampleRate) : nullptr);
+
+    const std::string firstPath = segmentPath(1);
+    auto first = std::make_unique<MediaMuxer>();
+    first->setPacketTap(packetTap);
+    const bool opened = first->open(firstPath, options, audio);
+    {
+        std::lock_guard<std::mutex> lock(muxerMutex);
+        muxer = std::move(first);
+    }
+    if (!opened) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.clear();
+        stopping = false;
+        frameIntervalUs = options.fps > 0 ? static_cast<int64_t>(1000000 / options.fps) : 0;
+        nextFrameUs = 0;
+        maxQueueDepth = 0;
+        encodedFrames = 0;
+        droppedFrames = 0;
+        lastEncodeMs = 0.0;
+        totalEncodeMs = 0.0;
+        segmentPaths.assign(1, firstPath);
+    }
+    running = true;
+    worker = std::thread(&RecordingEncoder::run, this);
+    return true;
+}
+
+bool RecordingEncoder::push(const cv::Mat& frame, int64_t captureUs)
+{
+    if (!running || frame.empty()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    // 帧率上限：允许 1/4 帧间隔的抖动，落后时以当前帧为新的起点
+    if (captureUs + frameIntervalUs / 4 < nextFrameUs) {
+        return false;
+    }
+    nextFrameUs = std::max(nextFrameUs + frameIntervalUs, captureUs);
+    if (queue.size() >= capacity) {
+        if (policy == QueueOverflowPolicy::Block) {
+            notFull.wait(lock, [this] { return queue.size() < capacity || stopping; });
+            if (stopping) {
+                return false;
+            }
+        } else {
+            ++droppedFrames;
+            queue.pop_front();
+        }
+    }
+    queue.push_back({frame, captureUs});
+    maxQueueDepth = std::max(maxQueueDepth, queue.size());
+    lock.unlock();
+    notEmpty.notify_one();
+    return true;
+}
+
+void RecordingEncoder::run()
+{
+    // 音频不经过条件变量通知，没有视频帧时按固定间隔取出
+    const auto audioPoll = std::chrono::milliseconds(10);
+    for (;;) {
+        Item item;
+        bool finished = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait_for(lock, audioPoll, [this] { return !queue.empty() || stopping; });
+            if (!queue.empty()) {
+                item = std::move(queue.front());
+                queue.pop_front();
+            } else {
+                finished = stopping; // stopping 且队列已排空
+            }
+        }
+        if (!item.frame.empty()) {
+            notFull.notify_one();
+        }
+        drainAudio();
+        if (finished) {
+            break;
+        }
+        if (item.frame.empty()) {
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        if (segmentStartUs < 0) {
+            segmentStartUs = item.captureUs;
+        } else if (segmentUs > 0 && item.captureUs - segmentStartUs >= segmentUs) {
+            rollover(item.captureUs);
+        }
+        muxer->writeVideo(item.frame, item.captureUs);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++encodedFrames;
+        lastEncodeMs = ms;
+        totalEncodeMs += ms;
+    }
+}
+
+bool RecordingEncoder::pushAudio(const int16_t* samples, int frames, int64_t arrivalUs)
+{
+    if (!running || !audioRing) {
+        return false;
+    }
+    return audioRing->write(samples, frames, arrivalUs);
+}
+
+void RecordingEncoder::drainAudio()
+{
+    if (!audioRing) {
+        return;
+    }
+    AudioRing::Chunk chunk;
+    while (audioRing->peek(chunk)) {
+        muxer->writeAudio(chunk.samples, chunk.frames, chunk.arrivalUs);
+        audioRing->pop();
+    }
+}
+
+void RecordingEncoder::rollover(int64_t captureUs)
+{
+    const int index = static_cast<int>(segments().size()) + 1;
+    const std::string path = segmentPath(index);
+    auto next = std::make_unique<MediaMuxer>();
+    next->setPacketTap(packetTap);
+    // 新文件以切换帧的采集时间为零点，而不是编码线程打开文件的时刻
+    if (!next->open(path, options, hasAudio ? &audioFormat : nullptr, captureUs)) {
+        // 新分段创建失败时继续写当前文件，下一个周期再重试
+        std::cerr << "[RecordingEncoder] 创建分段失败：" << next->lastError() << std::endl;
+        segmentStartUs = captureUs;
+        return;
+    }
+    std::unique_ptr<MediaMuxer> previous;
+    {
+        std::lock_guard<std::mutex> lock(muxerMutex);
+        previous = std::move(muxer);
+        muxer = std::move(next);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        segmentPaths.push_back(path);
+    }
+    segmentStartUs = captureUs;
+    previous->close();
+    std::cout << "[RecordingEncoder] 切换到分段 " << path << std::endl;
+}
+
+std::string RecordingEncoder::segmentPath(int index) const
+{
+    if (segmentUs <= 0) {
+        return basePath;
+    }
+    const size_t dot = basePath.find_last_of('.');
+    const size_t slash = basePath.find_last_of("/\\");
+    const bool hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    const std::string stem = hasExtension ? basePath.substr(0, dot) : basePath;
+    const std::string extension = hasExtension ? basePath.substr(dot) : std::string();
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_part%03d", index);
+    return stem + suffix + extension;
+}
+
+std::vector<std::string> RecordingEncoder::segments() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return segmentPaths;
+}
+
+std::string RecordingEncoder::lastError() const
+{
+    std::lock_guard<std::mutex> lock(muxerMutex);
+    return muxer ? muxer->lastError() : std::string();
+}
+
+const AVCodecContext* RecordingEncoder::videoContext() const
+{
+    std::lock_guard<std::mutex> lock(muxerMutex);
+    return muxer ? muxer->videoContext() : nullptr;
+}
+
+const AVCodecContext* RecordingEncoder::audioContext() const
+{
+    std::lock_guard<std::mutex> lock(muxerMutex);
+    return muxer ? muxer->audioContext() : nullptr;
+}
+
+std::string RecordingEncoder::videoEncoderName() const
+{
+    std::lock_guard<std::mutex> lock(muxerMutex);
+    return muxer ? muxer->videoEncoderName() : std::string();
+}
+
+void RecordingEncoder::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    notEmpty.notify_all();
+    notFull.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    running = false;
+    std::lock_guard<std::mutex> lock(muxerMutex);
+    if (muxer && muxer->isOpened()) {
+        muxer->close();
+        std::cout << "[RecordingEncoder] 编码 " << encodedFrames << " 帧，丢弃 " << droppedFrames
+                  << " 帧，最大队列深度 " << maxQueueDepth;
+        if (audioRing && audioRing->droppedFrames() > 0) {
+            std::cout << "，丢弃音频 " << audioRing->droppedFrames() << " 采样帧";
+        }
+        std::cout << std::endl;
+    }
+}
+
+EncoderStats RecordingEncoder::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    EncoderStats s;
+    s.queueDepth = queue.size();
+    s.maxQueueDepth = maxQueueDepth;
+    s.capacity = capacity;
+    s.encodedFrames = encodedFrames;
+    s.droppedFrames = droppedFrames;
+    s.droppedAudioFrames = audioRing ? audioRing->droppedFrames() : 0;
+    s.lastEncodeMs = lastEncodeMs;
+    s.avgEncodeMs = encodedFrames > 0 ? totalEncodeMs / encodedFrames : 0.0;
+    return s;
+}
@@ -0,0 +1,146 @@
+#ifndef RECORDINGENCODER_H
+#define RECORDINGENCODER_H
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "audioring.h"
+#include "mediamuxer.h"
+
+/**
+ * @brief 编码队列满时的处理策略
+ */
+enum class QueueOverflowPolicy {
+    DropOldest, // 丢弃队列中最旧的帧，采集线程永不等待
+    Block       // 采集线程等待编码线程腾出空间，不丢帧
+};
+
+/**
+ * @brief 编码线程运行指标
+ */
+struct EncoderStats {
+    size_t queueDepth = 0;      // 当前队列深度
+    size_t maxQueueDepth = 0;   // 本次录制的最大队列深度
+    size_t capacity = 0;        // 队列容量
+    uint64_t encodedFrames = 0; // 已编码帧数
+    uint64_t droppedFrames = 0; // 因队列满丢弃的帧数
+    uint64_t droppedAudioFrames = 0; // 因音频缓冲满丢弃的采样帧数
+    double lastEncodeMs = 0.0;  // 最近一帧编码耗时
+    double avgEncodeMs = 0.0;   // 平均编码耗时
+};
+
+/**
+ * @brief 独立编码线程：采集/预览线程只负责入队，编码在后台完成
+ *
+ * 麦克风 PCM 由采集线程写入无锁环形缓冲，AAC 编码同样在编码线程完成，采集线程只做内存拷贝。
+ *
+ * 开启分段时，编码线程按采集时间戳滚动到新文件：先打开新分段，再在锁内切换，
+ * 旧分段的冲刷和文件尾写入都在编码线程完成，不阻塞采集循环。
+ */
+class RecordingEncoder {
+public:
+    explicit RecordingEncoder(size_t capacity = 8, QueueOverflowPolicy policy = QueueOverflowPolicy::DropOldest);
+    ~RecordingEncoder();
+
+    /**
+     * @brief 打开输出文件并启动编码线程
+     * @param audio 麦克风 PCM 格式，为空时只录制视频
+     * @return 失败时返回 false，原因见 lastError()
+     */
+    bool open(const std::string& path, const RecordingOptions& options, const MuxerAudioFormat* audio);
+
+    /**
+     * @brief 提交一帧（入队后调用方不得再修改该帧数据）
+     *
+     * 帧以采集时间戳作为 PTS 写入，不再重复编码同一帧补足帧率；到达速度超过输出帧率时按时间戳抽帧。
+     * @param frame BGR 帧，任意尺寸；与输出分辨率不同时由编码线程在颜色转换时缩放
+     * @param captureUs 采集时间戳（mediaClockUs）
+     * @return 是否入队（被帧率限制跳过或 Block 策略下关闭时返回 false）
+     */
+    bool push(const cv::Mat& frame, int64_t captureUs);
+
+    /**
+     * @brief 写入麦克风 PCM（交错 16 位），只拷贝进环形缓冲，由编码线程编码
+     *
+     * 同一编码器只能有一个线程调用。
+     * @param arrivalUs 数据到达时间（mediaClockUs）
+     * @return 缓冲已满被丢弃时返回 false
+     */
+    bool pushAudio(const int16_t* samples, int frames, int64_t arrivalUs);
+
+    /**
+     * @brief 编码完队列中剩余的帧后停止线程并关闭文件
+     */
+    void close();
+
+    /**
+     * @brief 设置编码输出回调（转交给每个分段的 MediaMuxer），需在 open 之前调用
+     */
+    void setPacketTap(MediaMuxer::PacketTap tap) { packetTap = std::move(tap); }
+
+    /**
+     * @brief 当前分段的编码器上下文（用于读取码流参数），不分段时在 close 之前一直有效
+     */
+    const AVCodecContext* videoContext() const;
+    const AVCodecContext* audioContext() const;
+
+    bool isOpened() const { return running; }
+    std::string lastError() const;
+    std::string videoEncoderName() const;
+    EncoderStats stats() const;
+
+    /**
+     * @brief 本次录制写出的所有文件（未分段时只有一个）
+     */
+    std::vector<std::string> segments() const;
+
+private:
+    struct Item {
+        cv::Mat frame;
+        int64_t captureUs;
+    };
+
+    void run();
+    void drainAudio();
+    void rollover(int64_t captureUs);
+    std::string segmentPath(int index) const;
+
+    size_t capacity;
+    QueueOverflowPolicy policy;
+    std::unique_ptr<MediaMuxer> muxer;
+    MediaMuxer::PacketTap packetTap;
+    mutable std::mutex muxerMutex;   // 保护 muxer 指针的切换（其他线程读取编码器信息）
+    std::unique_ptr<AudioRing> audioRing;
+    std::string basePath;
+    RecordingOptions options;
+    MuxerAudioFormat audioFormat;
+    bool hasAudio = false;
+    int64_t segmentUs = 0;           // 分段时长，0 表示不分段
+    int64_t segmentStartUs = -1;     // 当前分段第一帧的采集时间
+    std::vector<std::string> segmentPaths; // 受 mutex 保护
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<Item> queue;
+    bool stopping = false;
+    std::atomic<bool> running{false};
+    int64_t frameIntervalUs = 0;  // 输出帧率对应的最小帧间隔
+    int64_t nextFrameUs = 0;      // 下一帧最早可接收的采集时间
+
+    // 指标（受 mutex 保护）
+    size_t maxQueueDepth = 0;
+    uint64_t encodedFrames = 0;
+    uint64_t droppedFrames = 0;
+    double lastEncodeMs = 0.0;
+    double totalEncodeMs = 0.0;
+};
+
+#endif // RECORDINGENCODER_H
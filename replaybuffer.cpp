@@ -0,0 +1,325 @@
+#include "replaybuffer.h"
+#include <algorithm>
+#include <iostream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace {
+const AVRational kMicroseconds{1, 1000000};
+
+std::string avError(int code)
+{
+    char buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+    av_strerror(code, buf, sizeof(buf));
+    return buf;
+}
+
+AVRational timeBase(const ReplayStream& stream)
+{
+    return AVRational{stream.timeBaseNum, stream.timeBaseDen};
+}
+
+ReplayStream describe(const AVCodecContext* codec)
+{
+    ReplayStream stream;
+    if (!codec) {
+        return stream;
+    }
+    AVCodecParameters* params = avcodec_parameters_alloc();
+    if (!params || avcodec_parameters_from_context(params, codec) < 0) {
+        avcodec_parameters_free(&params);
+        return stream;
+    }
+    stream.params.reset(params, [](AVCodecParameters* p) { avcodec_parameters_free(&p); });
+    stream.timeBaseNum = codec->time_base.num;
+    stream.timeBaseDen = codec->time_base.den;
+    return stream;
+}
+
+// 数据包的解码时间（微秒），没有 DTS 时用 PTS
+int64_t packetUs(const AVPacket* packet, const ReplayStream& stream)
+{
+    const int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    return ts == AV_NOPTS_VALUE ? 0 : av_rescale_q(ts, timeBase(stream), kMicroseconds);
+}
+}
+
+// ---------------------------------------------------------------------------
+// ReplayClip
+// ---------------------------------------------------------------------------
+
+ReplayClip::~ReplayClip()
+{
+    release();
+}
+
+ReplayClip::ReplayClip(ReplayClip&& other) noexcept
+    : video(std::move(other.video)), audio(std::move(other.audio)), packets(std::move(other.packets)),
+      firstUs(other.firstUs), lastUs(other.lastUs)
+{
+    other.packets.clear();
+}
+
+ReplayClip& ReplayClip::operator=(ReplayClip&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        video = std::move(other.video);
+        audio = std::move(other.audio);
+        packets = std::move(other.packets);
+        other.packets.clear();
+        firstUs = other.firstUs;
+        lastUs = other.lastUs;
+    }
+    return *this;
+}
+
+void ReplayClip::release()
+{
+    for (Entry& entry : packets) {
+        av_packet_free(&entry.packet);
+    }
+    packets.clear();
+}
+
+double ReplayClip::durationSeconds() const
+{
+    return packets.empty() ? 0.0 : (lastUs - firstUs) / 1e6;
+}
+
+bool ReplayClip::save(const std::string& path, std::string* error) const
+{
+    auto report = [error](const std::string& what, int code) {
+        const std::string message = code < 0 ? what + "：" + avError(code) : what;
+        std::cerr << "[ReplayClip] " << message << std::endl;
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    if (!video.params) {
+        return report("回放缓冲区没有视频流", 0);
+    }
+    // 从第一个视频关键帧开始，之前的数据包无法独立解码
+    const auto first = std::find_if(packets.begin(), packets.end(), [](const Entry& entry) {
+        return entry.video && (entry.packet->flags & AV_PKT_FLAG_KEY);
+    });
+    if (first == packets.end()) {
+        return report("回放缓冲区中还没有关键帧", 0);
+    }
+    const int64_t startUs = packetUs(first->packet, video);
+
+    AVFormatContext* out = nullptr;
+    int ret = avformat_alloc_output_context2(&out, nullptr, nullptr, path.c_str());
+    if (ret < 0 || !out) {
+        return report("无法根据扩展名确定封装格式", ret);
+    }
+    bool ok = true;
+    const ReplayStream* sources[2] = {&video, audio.params ? &audio : nullptr};
+    for (const ReplayStream* source : sources) {
+        if (!source) {
+            continue;
+        }
+        AVStream* stream = avformat_new_stream(out, nullptr);
+        if (!stream || avcodec_parameters_copy(stream->codecpar, source->params.get()) < 0) {
+            ok = report("创建输出流失败", 0);
+            break;
+        }
+        stream->codecpar->codec_tag = 0;
+        stream->time_base = timeBase(*source);
+    }
+    if (ok && !(out->oformat->flags & AVFMT_NOFILE) && (ret = avio_open(&out->pb, path.c_str(), AVIO_FLAG_WRITE)) < 0) {
+        ok = report("无法创建文件 " + path, ret);
+    }
+    if (ok && (ret = avformat_write_header(out, nullptr)) < 0) {
+        ok = report("写入文件头失败", ret);
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    int64_t lastDts[2] = {AV_NOPTS_VALUE, AV_NOPTS_VALUE};
+    for (auto it = first; ok && it != packets.end(); ++it) {
+        const ReplayStream& source = it->video ? video : audio;
+        if (!it->video && (!audio.params || packetUs(it->packet, audio) < startUs)) {
+            continue; // 早于第一个关键帧的音频
+        }
+        const int index = it->video ? 0 : 1;
+        if ((ret = av_packet_ref(packet, it->packet)) < 0) {
+            ok = report("引用数据包失败", ret);
+            break;
+        }
+        // 以第一个关键帧为零点平移时间戳
+        const int64_t offset = av_rescale_q(startUs, kMicroseconds, timeBase(source));
+        if (packet->pts != AV_NOPTS_VALUE) {
+            packet->pts -= offset;
+        }
+        if (packet->dts != AV_NOPTS_VALUE) {
+            packet->dts -= offset;
+        }
+        av_packet_rescale_ts(packet, timeBase(source), out->streams[index]->time_base);
+        if (packet->dts != AV_NOPTS_VALUE) {
+            if (lastDts[index] != AV_NOPTS_VALUE && packet->dts <= lastDts[index]) {
+                const int64_t shift = lastDts[index] + 1 - packet->dts;
+                packet->dts += shift;
+                if (packet->pts != AV_NOPTS_VALUE) {
+                    packet->pts = std::max(packet->pts + shift, packet->dts);
+                }
+            }
+            lastDts[index] = packet->dts;
+        }
+        packet->stream_index = index;
+        packet->pos = -1;
+        ret = av_interleaved_write_frame(out, packet);
+        if (ret < 0) {
+            ok = report("写入数据包失败", ret);
+        }
+    }
+    av_packet_unref(packet);
+
+    if (ok && (ret = av_write_trailer(out)) < 0) {
+        ok = report("写入文件尾失败", ret);
+    }
+    if (!(out->oformat->flags & AVFMT_NOFILE)) {
+        avio_closep(&out->pb);
+    }
+    avformat_free_context(out);
+    av_packet_free(&packet);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// ReplayBuffer
+// ---------------------------------------------------------------------------
+
+ReplayBuffer::ReplayBuffer(double seconds, size_t maxBytes)
+    : windowUs(static_cast<int64_t>(std::max(seconds, 1.0) * 1e6)), maxBytes(maxBytes)
+{
+}
+
+ReplayBuffer::~ReplayBuffer()
+{
+    clear();
+}
+
+void ReplayBuffer::setStreams(const AVCodecContext* videoCodec, const AVCodecContext* audioCodec)
+{
+    ReplayStream v = describe(videoCodec);
+    ReplayStream a = describe(audioCodec);
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!packets.empty()) {
+        popFront();
+    }
+    video = std::move(v);
+    audio = std::move(a);
+}
+
+void ReplayBuffer::push(const AVPacket* packet, bool isVideo)
+{
+    AVPacket* ref = av_packet_clone(packet);
+    if (!ref) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const ReplayStream& stream = isVideo ? video : audio;
+    if (!stream.params) {
+        av_packet_free(&ref);
+        return;
+    }
+    packets.push_back({ref, isVideo, isVideo && (ref->flags & AV_PKT_FLAG_KEY), packetUs(ref, stream)});
+    totalBytes += ref->size;
+    evict();
+}
+
+void ReplayBuffer::evict()
+{
+    if (packets.empty()) {
+        return;
+    }
+    const int64_t newestUs = packets.back().timeUs;
+    for (;;) {
+        const size_t next = nextKeyframe(1);
+        if (next >= packets.size()) {
+            // 只剩一个 GOP：以关键帧开头时整体保留，即使暂时超出内存上限（下一个关键帧到达后整体淘汰），
+            // 逐包丢弃会让队首不再是关键帧，这个 GOP 结束前都无法保存回放。
+            // 还没有关键帧时（编码刚开始）这些包本来就无法解码，超限时可以丢弃
+            while (totalBytes > maxBytes && !packets.empty() && !packets.front().keyframe) {
+                popFront();
+            }
+            return;
+        }
+        // 丢掉第一个 GOP 后剩余内容仍然覆盖完整时长，或者已超出内存上限
+        if (newestUs - packets[next].timeUs < windowUs && totalBytes <= maxBytes) {
+            return;
+        }
+        for (size_t i = 0; i < next; ++i) {
+            popFront();
+        }
+    }
+}
+
+void ReplayBuffer::popFront()
+{
+    Entry& entry = packets.front();
+    totalBytes -= entry.packet->size;
+    av_packet_free(&entry.packet);
+    packets.pop_front();
+}
+
+size_t ReplayBuffer::nextKeyframe(size_t from) const
+{
+    for (size_t i = from; i < packets.size(); ++i) {
+        if (packets[i].keyframe) {
+            return i;
+        }
+    }
+    return packets.size();
+}
+
+ReplayClip ReplayBuffer::snapshot() const
+{
+    ReplayClip clip;
+    std::lock_guard<std::mutex> lock(mutex);
+    clip.video = video;
+    clip.audio = audio;
+    clip.packets.reserve(packets.size());
+    for (const Entry& entry : packets) {
+        if (AVPacket* ref = av_packet_clone(entry.packet)) {
+            clip.packets.push_back({ref, entry.video});
+        }
+    }
+    if (!packets.empty()) {
+        clip.firstUs = packets.front().timeUs;
+        clip.lastUs = packets.back().timeUs;
+    }
+    return clip;
+}
+
+void ReplayBuffer::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!packets.empty()) {
+        popFront();
+    }
+}
+
+void ReplayBuffer::setDuration(double seconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    windowUs = static_cast<int64_t>(std::max(seconds, 1.0) * 1e6);
+    evict();
+}
+
+size_t ReplayBuffer::bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return totalBytes;
+}
+
+double ReplayBuffer::bufferedSeconds() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return packets.empty() ? 0.0 : (packets.back().timeUs - packets.front().timeUs) / 1e6;
+}
@@ -0,0 +1,125 @@
+#ifndef REPLAYBUFFER_H
+#define REPLAYBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct AVPacket;
+struct AVCodecContext;
+struct AVCodecParameters;
+
+/**
+ * @brief 回放流的码流参数
+ */
+struct ReplayStream {
+    std::shared_ptr<AVCodecParameters> params;
+    int timeBaseNum = 0;        // 数据包时间戳的时间基（编码器 time_base）
+    int timeBaseDen = 1;
+};
+
+/**
+ * @brief 回放片段：回放缓冲区某一时刻的快照
+ *
+ * 数据包通过引用计数与缓冲区共享，快照不复制码流数据，保存时也不重新编码。
+ */
+class ReplayClip {
+public:
+    ReplayClip() = default;
+    ~ReplayClip();
+    ReplayClip(ReplayClip&& other) noexcept;
+    ReplayClip& operator=(ReplayClip&& other) noexcept;
+    ReplayClip(const ReplayClip&) = delete;
+    ReplayClip& operator=(const ReplayClip&) = delete;
+
+    bool empty() const { return packets.empty(); }
+    double durationSeconds() const;
+
+    /**
+     * @brief 从第一个视频关键帧开始重新封装为文件（容器由扩展名决定）
+     * @param error 失败原因（可为空）
+     */
+    bool save(const std::string& path, std::string* error = nullptr) const;
+
+private:
+    friend class ReplayBuffer;
+    struct Entry {
+        AVPacket* packet;
+        bool video;
+    };
+    void release();
+
+    ReplayStream video;
+    ReplayStream audio;
+    std::vector<Entry> packets;
+    int64_t firstUs = 0;
+    int64_t lastUs = 0;
+};
+
+/**
+ * @brief 即时回放缓冲区：保存最近 N 秒已编码的音视频数据包（不保存原始帧）
+ *
+ * 按时长和字节数双重限制，淘汰时以 GOP 为单位整体丢弃，队首始终是视频关键帧，
+ * 任何时刻的快照都能直接解码。最新的 GOP 始终完整保留，单个 GOP 超出内存上限时暂时超限。
+ * push 由编码回调在编码线程调用（音频也在编码线程从 AudioRing 取出后编码），
+ * snapshot、setDuration 在 GUI 线程调用，互斥锁保护的是这两个线程之间的访问。
+ */
+class ReplayBuffer {
+public:
+    /**
+     * @param seconds 保留时长
+     * @param maxBytes 内存上限，超出时即使未达到时长也会丢弃最旧的 GOP
+     */
+    ReplayBuffer(double seconds, size_t maxBytes);
+    ~ReplayBuffer();
+    ReplayBuffer(const ReplayBuffer&) = delete;
+    ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+
+    /**
+     * @brief 记录码流参数，在编码器打开后、第一个数据包到达前调用
+     * @param audio 没有音频时为空
+     */
+    void setStreams(const AVCodecContext* video, const AVCodecContext* audio);
+
+    /**
+     * @brief 追加一个编码后的数据包（增加引用，不复制数据）
+     * @param packet 时间戳以对应编码器的 time_base 为单位
+     */
+    void push(const AVPacket* packet, bool video);
+
+    /**
+     * @brief 获取当前缓冲内容的快照，不影响后续写入
+     */
+    ReplayClip snapshot() const;
+
+    void clear();
+    void setDuration(double seconds);
+    size_t bytes() const;
+    double bufferedSeconds() const;
+
+private:
+    struct Entry {
+        AVPacket* packet;
+        bool video;
+        bool keyframe;
+        int64_t timeUs;         // 解码时间（微秒），用于按时长淘汰
+    };
+
+    void evict();
+    void popFront();
+    size_t nextKeyframe(size_t from) const;
+
+    mutable std::mutex mutex;
+    ReplayStream video;
+    ReplayStream audio;
+    std::deque<Entry> packets;
+    int64_t windowUs;
+    size_t maxBytes;
+    size_t totalBytes = 0;
+};
+
+#endif // REPLAYBUFFER_H
@@ -0,0 +1,168 @@
+#include "segmentationservice.h"
+#include "taskscheduler.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+// 显式指定输入输出名称（MODNet官方模型）
+const char* const kInputName = "input";
+const char* const kOutputName = "output";
+}
+
+SegmentationService::SegmentationService(const ORTCHAR_T* modelPath)
+{
+    try {
+        // 进程内所有会话共用一个全局线程池，线程数与 TaskScheduler 一致；
+        // 关闭自旋等待，推理间隙池中线程立即休眠，把核心让给调度器上的帧任务
+        Ort::ThreadingOptions threading;
+        threading.SetGlobalIntraOpNumThreads(TaskScheduler::instance().threadCount());
+        threading.SetGlobalInterOpNumThreads(1);
+        threading.SetGlobalSpinControl(0);
+        env = std::make_unique<Ort::Env>(threading, ORT_LOGGING_LEVEL_WARNING, "SegmentationService");
+
+        Ort::SessionOptions options;
+        options.DisablePerSessionThreads();
+        options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+        session = std::make_unique<Ort::Session>(*env, modelPath, options);
+        // 导出时 batch 维为动态（-1）才能把多路请求拼成一次 Run
+        const std::vector<int64_t> shape = session->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        dynamicBatch = !shape.empty() && shape[0] < 0;
+        std::cout << "[SegmentationService] CPU，" << (dynamicBatch ? "支持批量推理" : "模型 batch 固定为 1") << std::endl;
+    } catch (const Ort::Exception& e) {
+        std::cerr << "No ONNX Model!" << e.what() << std::endl;
+        throw std::runtime_error("No ONNX Model!");
+    } catch (const std::exception& e) {
+        std::cerr << "ONNX model wrong!" << e.what() << std::endl;
+        throw std::runtime_error("ONNX model wrong!");
+    }
+    worker = std::thread(&SegmentationService::run, this);
+}
+
+SegmentationService::~SegmentationService()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pendingChanged.notify_all();
+    worker.join();
+}
+
+void SegmentationService::addClient()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++clients;
+}
+
+void SegmentationService::removeClient()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        clients = std::max(0, clients - 1);
+    }
+    pendingChanged.notify_all(); // 正在等待凑 batch 的工作线程不必再等这一路
+}
+
+void SegmentationService::infer(const float* input, float* output)
+{
+    Request request{input, output, false, nullptr};
+    std::unique_lock<std::mutex> lock(mutex);
+    if (clients <= 1 && pending.empty()) {
+        // 只有一路时直接在调用线程推理（Session::Run 本身线程安全）
+        lock.unlock();
+        runBatch({&request});
+    } else {
+        pending.push_back(&request);
+        pendingChanged.notify_all();
+        requestDone.wait(lock, [&request] { return request.done; });
+    }
+    if (request.error) {
+        std::rethrow_exception(request.error);
+    }
+}
+
+void SegmentationService::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        pendingChanged.wait(lock, [this] { return !pending.empty() || stopping; });
+        if (stopping) {
+            break;
+        }
+        // 第一个请求到达后最多再等一个窗口，等其余摄像头的请求；各路都到齐就立即推理
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(BATCH_WINDOW_US);
+        pendingChanged.wait_until(lock, deadline, [this] {
+            return stopping || pending.size() >= std::min<size_t>(std::max(clients, 1), MAX_BATCH);
+        });
+        std::vector<Request*> batch;
+        while (!pending.empty() && batch.size() < MAX_BATCH) {
+            batch.push_back(pending.front());
+            pending.pop_front();
+        }
+        lock.unlock();
+        if (dynamicBatch) {
+            runBatch(batch);
+        } else {
+            for (Request* request : batch) {
+                runBatch({request});
+            }
+        }
+        lock.lock();
+        for (Request* request : batch) {
+            request->done = true;
+        }
+        requestDone.notify_all();
+    }
+    // 退出前让仍在等待的调用方返回
+    for (Request* request : pending) {
+        request->error = std::make_exception_ptr(std::runtime_error("segmentation service stopped"));
+        request->done = true;
+    }
+    pending.clear();
+    requestDone.notify_all();
+}
+
+void SegmentationService::runBatch(const std::vector<Request*>& batch)
+{
+    const int64_t count = static_cast<int64_t>(batch.size());
+    const size_t inputSize = static_cast<size_t>(3) * inputHeight() * inputWidth();
+    const size_t outputSize = static_cast<size_t>(inputHeight()) * inputWidth();
+    // 单个请求直接使用调用方的缓冲；多个请求拼接到连续的 batch 缓冲中
+    const float* input = batch.front()->input;
+    float* output = batch.front()->output;
+    if (count > 1) {
+        batchInput.resize(inputSize * count);
+        batchOutput.resize(outputSize * count);
+        for (int64_t i = 0; i < count; ++i) {
+            std::memcpy(batchInput.data() + inputSize * i, batch[i]->input, inputSize * sizeof(float));
+        }
+        input = batchInput.data();
+        output = batchOutput.data();
+    }
+    try {
+        const std::array<int64_t, 4> inputShape = {count, 3, inputHeight(), inputWidth()};
+        const std::array<int64_t, 4> outputShape = {count, 1, inputHeight(), inputWidth()};
+        Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeCPU);
+        Ort::Value inputTensor = Ort::Value::CreateTensor<float>(
+            memoryInfo, const_cast<float*>(input), inputSize * count, inputShape.data(), inputShape.size());
+        Ort::Value outputTensor = Ort::Value::CreateTensor<float>(
+            memoryInfo, output, outputSize * count, outputShape.data(), outputShape.size());
+        session->Run(Ort::RunOptions{nullptr}, &kInputName, &inputTensor, 1, &kOutputName, &outputTensor, 1);
+    } catch (...) {
+        for (Request* request : batch) {
+            request->error = std::current_exception();
+        }
+        return;
+    }
+    if (count > 1) {
+        for (int64_t i = 0; i < count; ++i) {
+            std::memcpy(batch[i]->output, batchOutput.data() + outputSize * i, outputSize * sizeof(float));
+        }
+    }
+    ++runs;
+    frames += static_cast<uint64_t>(count);
+}
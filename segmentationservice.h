@@ -0,0 +1,87 @@
+#ifndef SEGMENTATIONSERVICE_H
+#define SEGMENTATIONSERVICE_H
+
+#include <onnxruntime_cxx_api.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 共享的人像分割推理服务（一个 ONNX Runtime 会话）
+ *
+ * 多路摄像头各自做预处理和背景合成，只把模型输入交给同一个服务：多个客户端同时提交时，
+ * 工作线程在很短的窗口内收集请求，拼成一个 batch 调用一次 Run，再把各自的输出拷回。
+ * 只有一个客户端时直接在调用线程推理，不经过工作线程也不等待。
+ * 模型的 batch 维固定为 1 时退化为同一会话上逐个推理，仍然只占一份模型内存和一个线程池。
+ * ONNX Runtime 使用进程级的全局线程池（不自旋），线程数与 TaskScheduler 相同，不再按会话各建一套。
+ */
+class SegmentationService {
+public:
+    /**
+     * @brief 加载模型
+     * @throws std::runtime_error 模型不存在或加载失败
+     */
+    explicit SegmentationService(const ORTCHAR_T* modelPath = ORT_TSTR("modnet.onnx"));
+    ~SegmentationService();
+    SegmentationService(const SegmentationService&) = delete;
+    SegmentationService& operator=(const SegmentationService&) = delete;
+
+    int inputWidth() const { return 384; }   // MODNet输入宽度
+    int inputHeight() const { return 192; }  // MODNet输入高度
+
+    /**
+     * @brief 登记/注销一路使用者；登记数决定凑 batch 时等待多少个请求
+     */
+    void addClient();
+    void removeClient();
+
+    /**
+     * @brief 推理一帧（阻塞直到结果写回）
+     * @param input 归一化后的 3xHxW（CHW）浮点输入
+     * @param output HxW 浮点输出（人像概率）
+     */
+    void infer(const float* input, float* output);
+
+    /**
+     * @brief 累计的 Run 调用次数与推理帧数，两者之比为平均 batch 大小
+     */
+    uint64_t runCount() const { return runs; }
+    uint64_t frameCount() const { return frames; }
+
+private:
+    struct Request {
+        const float* input;
+        float* output;
+        bool done = false;
+        std::exception_ptr error;
+    };
+
+    void run();
+    void runBatch(const std::vector<Request*>& batch);
+
+    std::unique_ptr<Ort::Env> env;   // 使用全局线程池（见构造函数），需比 session 后释放
+    std::unique_ptr<Ort::Session> session;
+    bool dynamicBatch = false;
+    static constexpr size_t MAX_BATCH = 4;
+    static constexpr int BATCH_WINDOW_US = 4000; // 等待其他摄像头请求的最长时间
+
+    std::mutex mutex;
+    std::condition_variable pendingChanged;
+    std::condition_variable requestDone;
+    std::deque<Request*> pending;
+    int clients = 0;
+    bool stopping = false;
+    std::thread worker;
+    std::vector<float> batchInput;  // 只在工作线程中使用
+    std::vector<float> batchOutput;
+    std::atomic<uint64_t> runs{0};
+    std::atomic<uint64_t> frames{0};
+};
+
+#endif // SEGMENTATIONSERVICE_H
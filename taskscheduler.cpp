@@ -0,0 +1,271 @@
+#include "taskscheduler.h"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+#if __has_include(<opencv2/core/parallel/parallel_backend.hpp>)
+#include <opencv2/core/parallel/parallel_backend.hpp>
+#define BGCAM_HAVE_CV_PARALLEL_BACKEND
+#endif
+
+namespace {
+thread_local int currentIndex = 0; // 工作线程为 1..N
+thread_local TaskPriority runningPriority = TaskPriority::Frame;
+
+#ifdef BGCAM_HAVE_CV_PARALLEL_BACKEND
+/**
+ * OpenCV 的 parallel_for_ 转交给调度器：分段继承调用方的优先级，
+ * 后台任务里的 cv::resize 等不会挤占帧任务的线程
+ */
+class SchedulerParallelBackend : public cv::parallel::ParallelForAPI {
+public:
+    void parallel_for(int tasks, FN_parallel_for_body_cb_t body_callback, void* callback_data) override
+    {
+        TaskScheduler::instance().parallelFor(0, tasks, [body_callback, callback_data](int begin, int end) {
+            body_callback(begin, end, callback_data);
+        }, TaskScheduler::currentPriority());
+    }
+    int getThreadNum() const override { return TaskScheduler::currentThreadIndex(); }
+    int getNumThreads() const override { return TaskScheduler::instance().threadCount(); }
+    int setNumThreads(int) override { return getNumThreads(); } // 线程数由调度器统一决定
+    const char* getName() const override { return "bgcam"; }
+};
+#endif
+}
+
+TaskScheduler& TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler()
+{
+    // 调用 parallelFor 的线程也参与计算，工作线程比核心数少一个；
+    // 至少两个工作线程，后台任务最多占一半，始终留有线程给帧任务（单核、双核机器也一样）
+    const int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int count = std::max(2, cores - 1);
+    backgroundLimit = std::max(1, count / 2);
+    for (int i = 0; i < count; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < count; ++i) {
+        workers[i]->thread = std::thread(&TaskScheduler::run, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+TaskPriority TaskScheduler::currentPriority()
+{
+    return runningPriority;
+}
+
+int TaskScheduler::currentThreadIndex()
+{
+    return currentIndex;
+}
+
+bool TaskScheduler::installOpenCvBackend()
+{
+#ifdef BGCAM_HAVE_CV_PARALLEL_BACKEND
+    cv::parallel::setParallelForBackend(std::make_shared<SchedulerParallelBackend>(), false);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void TaskScheduler::submit(std::function<void()> task, TaskPriority priority)
+{
+    const int p = static_cast<int>(priority);
+    const int self = currentIndex - 1;
+    if (self >= 0) {
+        // 工作线程提交的任务放进自己的队列，自己从尾部取，空闲线程从头部窃取
+        Worker& worker = *workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[p].push_back({std::move(task), priority});
+    } else {
+        std::lock_guard<std::mutex> lock(globalMutex);
+        globalQueues[p].push_back({std::move(task), priority});
+    }
+    ++queued[p];
+    wakeOne();
+}
+
+void TaskScheduler::parallelFor(int begin, int end, const std::function<void(int, int)>& body,
+                                TaskPriority priority)
+{
+    if (end <= begin) {
+        return;
+    }
+    // 分段数为线程数的几倍，各段耗时不均时先完成的线程继续领取
+    const int range = end - begin;
+    const int chunks = std::min(range, threadCount() * 4);
+    if (chunks <= 1) {
+        body(begin, end);
+        return;
+    }
+
+    struct Loop {
+        const std::function<void(int, int)>* body;
+        int begin;
+        int range;
+        int chunks;
+        std::atomic<int> next{0};
+        std::atomic<int> remaining{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    // 来得太晚的辅助任务可能在 parallelFor 返回后才执行，共享状态由它们共同持有
+    auto loop = std::make_shared<Loop>();
+    loop->body = &body;
+    loop->begin = begin;
+    loop->range = range;
+    loop->chunks = chunks;
+    loop->remaining = chunks;
+    auto work = [](Loop& state) {
+        for (;;) {
+            const int chunk = state.next.fetch_add(1);
+            if (chunk >= state.chunks) {
+                return;
+            }
+            const int first = state.begin + static_cast<int>(static_cast<int64_t>(state.range) * chunk / state.chunks);
+            const int last = state.begin + static_cast<int>(static_cast<int64_t>(state.range) * (chunk + 1) / state.chunks);
+            try {
+                (*state.body)(first, last);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                if (!state.error) {
+                    state.error = std::current_exception();
+                }
+            }
+            if (state.remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.finished.notify_all();
+            }
+        }
+    };
+
+    const int helpers = std::min(chunks - 1, static_cast<int>(workers.size()));
+    for (int i = 0; i < helpers; ++i) {
+        submit([loop, work]() { work(*loop); }, priority);
+    }
+    // 调用线程自己领完剩余分段，只等待其他线程手上正在执行的分段
+    work(*loop);
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop] { return loop->remaining.load() == 0; });
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
+
+void TaskScheduler::run(int index)
+{
+    currentIndex = index + 1;
+    Task task;
+    for (;;) {
+        if (takeTask(index, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || hasRunnableWork(); });
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+bool TaskScheduler::takeTask(int self, Task& task)
+{
+    const int count = static_cast<int>(workers.size());
+    for (int p = 0; p < PRIORITY_COUNT; ++p) {
+        const bool background = p == static_cast<int>(TaskPriority::Background);
+        // 先占住后台名额再取任务，名额用完时后台任务留在队列中，空出的线程只接帧任务
+        if (background && runningBackground.fetch_add(1) >= backgroundLimit) {
+            --runningBackground;
+            continue;
+        }
+        bool found = takeFrom(workers[self]->queues[p], workers[self]->mutex, true, task)
+                     || takeFrom(globalQueues[p], globalMutex, false, task);
+        for (int i = 1; !found && i < count; ++i) {
+            Worker& victim = *workers[(self + i) % count];
+            if (takeFrom(victim.queues[p], victim.mutex, false, task)) {
+                found = true;
+                ++stolen;
+            }
+        }
+        if (found) {
+            return true;
+        }
+        if (background) {
+            --runningBackground;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::takeFrom(std::deque<Task>& queue, std::mutex& mutex, bool back, Task& task)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty()) {
+        return false;
+    }
+    if (back) {
+        task = std::move(queue.back());
+        queue.pop_back();
+    } else {
+        task = std::move(queue.front());
+        queue.pop_front();
+    }
+    --queued[static_cast<int>(task.priority)];
+    return true;
+}
+
+bool TaskScheduler::hasRunnableWork() const
+{
+    return queued[static_cast<int>(TaskPriority::Frame)] > 0
+           || (queued[static_cast<int>(TaskPriority::Background)] > 0 && runningBackground < backgroundLimit);
+}
+
+void TaskScheduler::execute(Task& task)
+{
+    runningPriority = task.priority;
+    try {
+        task.run();
+    } catch (const std::exception& e) {
+        std::cerr << "[TaskScheduler] 任务异常：" << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[TaskScheduler] 任务异常" << std::endl;
+    }
+    task.run = nullptr; // 尽早释放任务捕获的资源
+    runningPriority = TaskPriority::Frame;
+    ++executed;
+    if (task.priority == TaskPriority::Background) {
+        --runningBackground;
+        if (queued[static_cast<int>(TaskPriority::Background)] > 0) {
+            wakeOne(); // 空出了后台名额
+        }
+    }
+}
+
+void TaskScheduler::wakeOne()
+{
+    // 先经过一次锁，保证检查完条件、即将休眠的线程不会错过这次唤醒
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
@@ -0,0 +1,117 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 任务优先级
+ */
+enum class TaskPriority {
+    Frame = 0,      // 正在处理的帧（解码、分割前后处理、合成、OpenCV 并行循环）
+    Background = 1  // 不影响当前帧的后台工作（缩略图、素材加载等）
+};
+
+/**
+ * @brief 进程内共享的任务调度器（工作窃取）
+ *
+ * 管线各阶段、OpenCV 的 parallel_for（通过 installOpenCvBackend 接管）共用同一组工作线程，
+ * 线程总数与核心数一致（至少两个工作线程），不再各自维护线程池互相抢占。每个工作线程有自己的双端队列：
+ * 自己提交的任务从尾部取（缓存热），空闲线程从其他线程队列头部窃取；非工作线程提交的任务进入全局队列。
+ * 工作线程总是先取 Frame 任务；Background 任务最多同时占用一半工作线程，
+ * 后台工作再多，新到的帧任务也总有空闲线程立即执行。
+ * 可在任意线程使用。
+ */
+class TaskScheduler {
+public:
+    static TaskScheduler& instance();
+
+    /**
+     * @brief 提交一个任务，不等待完成；任务抛出的异常会被记录并丢弃
+     */
+    void submit(std::function<void()> task, TaskPriority priority = TaskPriority::Frame);
+
+    /**
+     * @brief 把 [begin, end) 切成若干段并行执行 body(段起点, 段终点)，返回时全部完成
+     *
+     * 调用线程自己也领取分段，在工作线程内嵌套调用不会死锁；body 抛出的第一个异常在调用线程重新抛出。
+     */
+    void parallelFor(int begin, int end, const std::function<void(int, int)>& body,
+                     TaskPriority priority = TaskPriority::Frame);
+
+    /**
+     * @brief 参与计算的线程数（工作线程 + 调用线程）
+     */
+    int threadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+    /**
+     * @brief 当前线程正在执行的任务优先级；非工作线程视为 Frame
+     */
+    static TaskPriority currentPriority();
+
+    /**
+     * @brief 当前线程编号：工作线程为 1..N，其他线程为 0
+     */
+    static int currentThreadIndex();
+
+    /**
+     * @brief 把 OpenCV 的并行后端换成本调度器，需在启动处理线程之前调用一次
+     * @return OpenCV 版本不支持自定义后端（早于 4.5.2）时返回 false
+     */
+    bool installOpenCvBackend();
+
+    /**
+     * @brief 累计执行的任务数与其中被其他线程窃取的任务数
+     */
+    uint64_t executedTasks() const { return executed; }
+    uint64_t stolenTasks() const { return stolen; }
+
+private:
+    static constexpr int PRIORITY_COUNT = 2;
+
+    struct Task {
+        std::function<void()> run;
+        TaskPriority priority = TaskPriority::Frame;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queues[PRIORITY_COUNT];
+        std::thread thread;
+    };
+
+    TaskScheduler();
+    ~TaskScheduler();
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void run(int index);
+    bool takeTask(int self, Task& task);
+    bool takeFrom(std::deque<Task>& queue, std::mutex& mutex, bool back, Task& task);
+    bool hasRunnableWork() const;
+    void execute(Task& task);
+    void wakeOne();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex globalMutex;
+    std::deque<Task> globalQueues[PRIORITY_COUNT];
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queued[PRIORITY_COUNT] = {};
+    std::atomic<int> runningBackground{0};
+    int backgroundLimit = 1;
+    bool stopping = false;
+
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> stolen{0};
+};
+
+#endif // TASKSCHEDULER_H
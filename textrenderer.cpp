@@ -0,0 +1,412 @@
+#include "textrenderer.h"
+#include "alphablend.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#ifndef _WIN32
+#include <fontconfig/fontconfig.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr int kAtlasWidth = 1024;
+constexpr int kAtlasInitialHeight = 256;
+constexpr int kGlyphPadding = 1;
+#ifdef _WIN32
+const char* const kFallbackFont = "微软雅黑";
+#else
+const char* const kFallbackFont = ":lang=zh-cn";
+#endif
+
+// 排版后单个字形的位置（位图左上角，相对文字区域左上角）
+struct Placement {
+    const GlyphInfo* glyph;
+    int x;
+    int y;
+};
+
+// 逐行排版，返回所有字形位置及墨迹包围盒
+cv::Rect layoutText(GlyphAtlas& atlas, const std::u32string& text, std::vector<Placement>& out)
+{
+    out.clear();
+    cv::Rect bounds;
+    bool any = false;
+    int penX = 0;
+    int baseline = atlas.ascender();
+    const GlyphInfo* prev = nullptr;
+    for (char32_t cp : text) {
+        if (cp == U'\n') {
+            penX = 0;
+            baseline += atlas.lineHeight();
+            prev = nullptr;
+            continue;
+        }
+        const GlyphInfo& g = atlas.glyph(cp);
+        if (prev) {
+            penX += atlas.kerning(*prev, g);
+        }
+        if (!g.rect.empty()) {
+            Placement p{&g, penX + g.bearingX, baseline - g.bearingY};
+            cv::Rect r(p.x, p.y, g.rect.width, g.rect.height);
+            bounds = any ? (bounds | r) : r;
+            any = true;
+            out.push_back(p);
+        }
+        penX += g.advance;
+        prev = &g;
+    }
+    return bounds;
+}
+
+// 以覆盖率为 alpha 将纯色混合到目标图（整数运算，自动裁剪）
+void blendGlyph(cv::Mat& dst, const cv::Mat& atlas, const cv::Rect& src, cv::Point at, const int color[3])
+{
+    const cv::Rect target = cv::Rect(at.x, at.y, src.width, src.height) & cv::Rect(0, 0, dst.cols, dst.rows);
+    if (target.empty()) {
+        return;
+    }
+    const int cn = dst.channels();
+    for (int y = target.y; y < target.y + target.height; ++y) {
+        const uchar* c = atlas.ptr<uchar>(src.y + y - at.y) + src.x + (target.x - at.x);
+        uchar* d = dst.ptr<uchar>(y) + target.x * cn;
+        if (cn == 3) {
+            const uchar bgr[3] = {static_cast<uchar>(color[0]), static_cast<uchar>(color[1]),
+                                  static_cast<uchar>(color[2])};
+            alphaBlendColorRow(d, c, target.width, bgr);
+            continue;
+        }
+        for (int x = 0; x < target.width; ++x, d += cn) {
+            const int a = c[x];
+            if (a == 0) continue;
+            const int inv = 255 - a;
+            for (int n = 0; n < cn; ++n) {
+                d[n] = static_cast<uchar>(div255(color[n] * a + d[n] * inv));
+            }
+        }
+    }
+}
+}
+
+// ==================== GlyphAtlas ====================
+
+GlyphAtlas::GlyphAtlas(FT_Face face, FT_Face fallback, int pixelSize)
+    : face(face), fallback(fallback), pixelSize(pixelSize)
+{
+    FT_Set_Pixel_Sizes(face, 0, pixelSize);
+    ascent = static_cast<int>(face->size->metrics.ascender >> 6);
+    lineGap = static_cast<int>(face->size->metrics.height >> 6);
+    if (lineGap <= 0) {
+        lineGap = pixelSize;
+    }
+    atlas = cv::Mat::zeros(kAtlasInitialHeight, kAtlasWidth, CV_8UC1);
+}
+
+cv::Rect GlyphAtlas::allocate(int w, int h)
+{
+    w += kGlyphPadding;
+    h += kGlyphPadding;
+    if (shelfX + w > atlas.cols) {
+        shelfY += shelfHeight;
+        shelfX = 0;
+        shelfHeight = 0;
+    }
+    if (shelfY + h > atlas.rows) {
+        // 图集按高度翻倍扩容，已有字形坐标不变
+        int newRows = atlas.rows * 2;
+        while (shelfY + h > newRows) newRows *= 2;
+        cv::Mat grown = cv::Mat::zeros(newRows, atlas.cols, CV_8UC1);
+        atlas.copyTo(grown.rowRange(0, atlas.rows));
+        atlas = grown;
+    }
+    cv::Rect r(shelfX, shelfY, w - kGlyphPadding, h - kGlyphPadding);
+    shelfX += w;
+    shelfHeight = std::max(shelfHeight, h);
+    return r;
+}
+
+const GlyphInfo& GlyphAtlas::glyph(char32_t codepoint)
+{
+    auto it = glyphs.find(codepoint);
+    if (it != glyphs.end()) {
+        return it->second;
+    }
+
+    GlyphInfo info;
+    FT_Face source = face;
+    FT_UInt index = FT_Get_Char_Index(face, codepoint);
+    if (index == 0 && fallback) {
+        FT_UInt fallbackIndex = FT_Get_Char_Index(fallback, codepoint);
+        if (fallbackIndex != 0) {
+            source = fallback;
+            index = fallbackIndex;
+        }
+    }
+    info.index = index;
+    info.face = source;
+
+    FT_Set_Pixel_Sizes(source, 0, pixelSize);
+    if (FT_Load_Glyph(source, index, FT_LOAD_RENDER) == 0) {
+        const FT_GlyphSlot slot = source->glyph;
+        const FT_Bitmap& bmp = slot->bitmap;
+        info.bearingX = slot->bitmap_left;
+        info.bearingY = slot->bitmap_top;
+        info.advance = static_cast<int>(slot->advance.x >> 6);
+        if (bmp.width > 0 && bmp.rows > 0 && bmp.pixel_mode == FT_PIXEL_MODE_GRAY) {
+            info.rect = allocate(static_cast<int>(bmp.width), static_cast<int>(bmp.rows));
+            for (unsigned int y = 0; y < bmp.rows; ++y) {
+                std::memcpy(atlas.ptr<uchar>(info.rect.y + static_cast<int>(y)) + info.rect.x,
+                            bmp.buffer + static_cast<ptrdiff_t>(y) * bmp.pitch, bmp.width);
+            }
+        }
+    }
+    return glyphs.emplace(codepoint, info).first->second;
+}
+
+int GlyphAtlas::kerning(const GlyphInfo& left, const GlyphInfo& right)
+{
+    if (left.face != right.face || !left.face || !FT_HAS_KERNING(left.face)) {
+        return 0;
+    }
+    const unsigned long long key = (static_cast<unsigned long long>(left.index) << 32) | right.index;
+    auto it = kernings.find(key);
+    if (it != kernings.end()) {
+        return it->second;
+    }
+    FT_Vector delta{0, 0};
+    FT_Set_Pixel_Sizes(left.face, 0, pixelSize);
+    FT_Get_Kerning(left.face, left.index, right.index, FT_KERNING_DEFAULT, &delta);
+    const int value = static_cast<int>(delta.x >> 6);
+    kernings.emplace(key, value);
+    return value;
+}
+
+// ==================== TextRenderer ====================
+
+TextRenderer& TextRenderer::instance()
+{
+    static TextRenderer renderer;
+    return renderer;
+}
+
+TextRenderer::TextRenderer()
+{
+    if (FT_Init_FreeType(&library) != 0) {
+        std::cerr << "Error: [TextRenderer] FreeType 初始化失败" << std::endl;
+        library = nullptr;
+    }
+}
+
+TextRenderer::~TextRenderer()
+{
+    atlases.clear();
+    for (auto& kv : faces) {
+        if (kv.second) FT_Done_Face(kv.second);
+    }
+    faces.clear();
+    if (library) {
+        FT_Done_FreeType(library);
+    }
+}
+
+std::string TextRenderer::resolveFontPath(const std::string& fontName)
+{
+    std::error_code ec;
+    if (!fontName.empty() && fontName[0] != ':' && fs::is_regular_file(fs::u8path(fontName), ec)) {
+        return fontName;
+    }
+#ifdef _WIN32
+    static const std::map<std::string, std::string> knownFonts = {
+        {"微软雅黑", "msyh.ttc"}, {"Microsoft YaHei", "msyh.ttc"},
+        {"宋体", "simsun.ttc"}, {"SimSun", "simsun.ttc"},
+        {"黑体", "simhei.ttf"}, {"SimHei", "simhei.ttf"},
+        {"楷体", "simkai.ttf"}, {"KaiTi", "simkai.ttf"},
+        {"仿宋", "simfang.ttf"}, {"FangSong", "simfang.ttf"},
+        {"Arial", "arial.ttf"},
+    };
+    const char* windir = std::getenv("WINDIR");
+    const fs::path fontDir = fs::path(windir ? windir : "C:\\Windows") / "Fonts";
+    std::vector<std::string> candidates;
+    auto it = knownFonts.find(fontName);
+    if (it != knownFonts.end()) {
+        candidates.push_back(it->second);
+    }
+    candidates.push_back(fontName + ".ttf");
+    candidates.push_back(fontName + ".ttc");
+    for (const auto& name : candidates) {
+        const fs::path p = fontDir / fs::u8path(name);
+        if (fs::is_regular_file(p, ec)) {
+            return p.string();
+        }
+    }
+    return std::string();
+#else
+    // Linux 下交给 fontconfig 匹配（找不到同名字体时会返回最接近的可用字体）
+    std::string result;
+    if (!FcInit()) {
+        return result;
+    }
+    FcPattern* pattern = FcNameParse(reinterpret_cast<const FcChar8*>(fontName.c_str()));
+    if (!pattern) {
+        return result;
+    }
+    FcConfigSubstitute(nullptr, pattern, FcMatchPattern);
+    FcDefaultSubstitute(pattern);
+    FcResult res = FcResultNoMatch;
+    FcPattern* match = FcFontMatch(nullptr, pattern, &res);
+    if (match) {
+        FcChar8* file = nullptr;
+        if (FcPatternGetString(match, FC_FILE, 0, &file) == FcResultMatch && file) {
+            result = reinterpret_cast<const char*>(file);
+        }
+        FcPatternDestroy(match);
+    }
+    FcPatternDestroy(pattern);
+    return result;
+#endif
+}
+
+FT_Face TextRenderer::loadFace(const std::string& fontName)
+{
+    auto it = faces.find(fontName);
+    if (it != faces.end()) {
+        return it->second;
+    }
+    FT_Face face = nullptr;
+    const std::string path = resolveFontPath(fontName);
+    if (library && !path.empty()) {
+        if (FT_New_Face(library, path.c_str(), 0, &face) != 0) {
+            std::cerr << "Error: [TextRenderer] 无法加载字体: " << path << std::endl;
+            face = nullptr;
+        } else {
+            FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+        }
+    }
+    faces.emplace(fontName, face);
+    return face;
+}
+
+GlyphAtlas* TextRenderer::atlas(const std::string& fontName, int fontSize)
+{
+    const auto key = std::make_pair(fontName, fontSize);
+    auto it = atlases.find(key);
+    if (it != atlases.end()) {
+        return it->second.get();
+    }
+    if (!fallbackResolved) {
+        fallbackFace = loadFace(kFallbackFont);
+        fallbackResolved = true;
+    }
+    FT_Face face = loadFace(fontName);
+    if (!face) {
+        face = fallbackFace;
+    }
+    if (!face || fontSize <= 0) {
+        return nullptr;
+    }
+    auto created = std::make_unique<GlyphAtlas>(face, face == fallbackFace ? nullptr : fallbackFace, fontSize);
+    GlyphAtlas* result = created.get();
+    atlases.emplace(key, std::move(created));
+    return result;
+}
+
+std::u32string TextRenderer::decodeUtf8(const std::string& utf8)
+{
+    std::u32string out;
+    out.reserve(utf8.size());
+    const auto* p = reinterpret_cast<const unsigned char*>(utf8.data());
+    const size_t len = utf8.size();
+    size_t i = 0;
+    while (i < len) {
+        const unsigned char c = p[i];
+        char32_t cp;
+        size_t extra;
+        if (c < 0x80) {
+            cp = c;
+            extra = 0;
+        } else if ((c & 0xE0) == 0xC0) {
+            cp = c & 0x1F;
+            extra = 1;
+        } else if ((c & 0xF0) == 0xE0) {
+            cp = c & 0x0F;
+            extra = 2;
+        } else if ((c & 0xF8) == 0xF0) {
+            cp = c & 0x07;
+            extra = 3;
+        } else {
+            ++i; // 非法首字节，跳过
+            continue;
+        }
+        if (i + extra >= len) {
+            break; // 末尾截断的多字节序列
+        }
+        bool valid = true;
+        for (size_t k = 1; k <= extra; ++k) {
+            if ((p[i + k] & 0xC0) != 0x80) {
+                valid = false;
+                break;
+            }
+            cp = (cp << 6) | (p[i + k] & 0x3F);
+        }
+        if (!valid) {
+            ++i;
+            continue;
+        }
+        if (cp != U'\r') {
+            out.push_back(cp);
+        }
+        i += extra + 1;
+    }
+    return out;
+}
+
+bool TextRenderer::draw(cv::Mat& dst, const std::string& utf8, cv::Point org, const cv::Scalar& color,
+                        int fontSize, const std::string& fontName)
+{
+    CV_Assert(!dst.empty() && dst.depth() == CV_8U && (dst.channels() == 1 || dst.channels() == 3));
+    std::lock_guard<std::mutex> lock(mutex);
+    GlyphAtlas* glyphAtlas = atlas(fontName, fontSize);
+    if (!glyphAtlas) {
+        return false;
+    }
+    std::vector<Placement> placements;
+    layoutText(*glyphAtlas, decodeUtf8(utf8), placements);
+
+    const int bgr[3] = {cvRound(color[0]), cvRound(color[1]), cvRound(color[2])};
+    for (const auto& p : placements) {
+        blendGlyph(dst, glyphAtlas->coverage(), p.glyph->rect, cv::Point(org.x + p.x, org.y + p.y), bgr);
+    }
+    return true;
+}
+
+bool TextRenderer::renderCoverage(const std::string& utf8, int fontSize, const std::string& fontName,
+                                  cv::Mat& coverage, cv::Point& offset)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    GlyphAtlas* glyphAtlas = atlas(fontName, fontSize);
+    if (!glyphAtlas) {
+        return false;
+    }
+    std::vector<Placement> placements;
+    const cv::Rect bounds = layoutText(*glyphAtlas, decodeUtf8(utf8), placements);
+    if (bounds.empty()) {
+        coverage.release();
+        offset = cv::Point(0, 0);
+        return true;
+    }
+    coverage.create(bounds.size(), CV_8UC1);
+    coverage.setTo(0);
+    const cv::Mat& src = glyphAtlas->coverage();
+    for (const auto& p : placements) {
+        const cv::Rect r = p.glyph->rect;
+        cv::Mat target = coverage(cv::Rect(p.x - bounds.x, p.y - bounds.y, r.width, r.height));
+        // 字形可能相互重叠（字距调整后），取最大覆盖率
+        cv::max(target, src(r), target);
+    }
+    offset = bounds.tl();
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include <opencv2/opencv.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_* FT_Face;
+
+/**
+ * @brief 单个字形在图集中的位置与排版度量（像素）
+ */
+struct GlyphInfo {
+    cv::Rect rect;      // 覆盖率位图在图集中的区域（可能为空，如空格）
+    int bearingX = 0;   // 笔位置到位图左边的距离
+    int bearingY = 0;   // 基线到位图顶部的距离
+    int advance = 0;    // 水平步进
+    unsigned int index = 0; // 字形索引（用于字距调整）
+    FT_Face face = nullptr; // 实际提供该字形的字体（可能是回退字体）
+};
+
+/**
+ * @brief 某个(字体, 字号)下的字形覆盖率图集
+ *
+ * 字形首次使用时用 FreeType 栅格化并按行（shelf）打包进单通道图集，之后只做查表。
+ */
+class GlyphAtlas {
+public:
+    GlyphAtlas(FT_Face face, FT_Face fallback, int pixelSize);
+
+    /**
+     * @brief 获取字形，未缓存时栅格化并放入图集
+     * @param codepoint Unicode 码点
+     * @return 字形信息；字体中不存在时返回回退字体的字形或空字形
+     */
+    const GlyphInfo& glyph(char32_t codepoint);
+
+    const cv::Mat& coverage() const { return atlas; }
+    int ascender() const { return ascent; }
+    int lineHeight() const { return lineGap; }
+    int kerning(const GlyphInfo& left, const GlyphInfo& right);
+
+private:
+    cv::Rect allocate(int w, int h);
+
+    FT_Face face;
+    FT_Face fallback;
+    int pixelSize;
+    int ascent = 0;
+    int lineGap = 0;
+    cv::Mat atlas;                   // CV_8UC1 覆盖率
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfHeight = 0;
+    std::unordered_map<char32_t, GlyphInfo> glyphs;
+    std::unordered_map<unsigned long long, int> kernings;
+};
+
+/**
+ * @brief 基于 FreeType 的跨平台文字渲染器（支持中文）
+ *
+ * 字体文件和每个(字体, 字号)的字形图集常驻内存，稳定状态下绘制文字只是从图集拷贝覆盖率并混合。
+ * 输入文字与字体名均为 UTF-8。
+ */
+class TextRenderer {
+public:
+    static TextRenderer& instance();
+
+    /**
+     * @brief 在图像上绘制文字（支持多行，'\n' 换行）
+     * @param dst 目标图像（CV_8UC1 或 CV_8UC3）
+     * @param utf8 文字内容（UTF-8）
+     * @param org 文字区域左上角
+     * @param color 颜色（BGR）
+     * @param fontSize 字号（像素）
+     * @param fontName 字体名称或字体文件路径
+     * @return 字体不可用时返回 false
+     */
+    bool draw(cv::Mat& dst, const std::string& utf8, cv::Point org, const cv::Scalar& color,
+              int fontSize, const std::string& fontName);
+
+    /**
+     * @brief 渲染文字的覆盖率蒙版（CV_8UC1，紧贴文字包围盒）
+     * @param offset 输出蒙版左上角相对文字区域左上角的偏移
+     */
+    bool renderCoverage(const std::string& utf8, int fontSize, const std::string& fontName,
+                        cv::Mat& coverage, cv::Point& offset);
+
+    /**
+     * @brief 持锁访问(字体, 字号)对应的图集，供需要逐字排版的调用方使用
+     *
+     * 图集与字体在各线程间共享，查字形可能扩容图集，只能在 fn 内使用图集及其覆盖率，不得保存引用。
+     * @return 字体不可用时不调用 fn 并返回 false
+     */
+    template <typename Fn>
+    bool withAtlas(const std::string& fontName, int fontSize, Fn&& fn)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        GlyphAtlas* glyphAtlas = atlas(fontName, fontSize);
+        if (!glyphAtlas) {
+            return false;
+        }
+        fn(*glyphAtlas);
+        return true;
+    }
+
+    static std::u32string decodeUtf8(const std::string& utf8);
+
+private:
+    GlyphAtlas* atlas(const std::string& fontName, int fontSize); // 调用方需持有 mutex
+
+    TextRenderer();
+    ~TextRenderer();
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer& operator=(const TextRenderer&) = delete;
+
+    FT_Face loadFace(const std::string& fontName);
+    static std::string resolveFontPath(const std::string& fontName);
+
+    std::mutex mutex;
+    FT_Library library = nullptr;
+    FT_Face fallbackFace = nullptr;
+    bool fallbackResolved = false;
+    std::map<std::string, FT_Face> faces;
+    std::map<std::pair<std::string, int>, std::unique_ptr<GlyphAtlas>> atlases;
+};
+
+#endif // TEXTRENDERER_H
@@ -0,0 +1,151 @@
+// 无界面渲染：用 BgCamEngine 把视频文件 / 图片序列 / 合成画面换背景后编码成文件，供没有显示器的渲染节点使用
+// 用法：bgcamrender [--source synthetic|视频文件|图片目录] [--background 背景图片] [--output out.mp4]
+//                   [--frames N] [--size WxH] [--fps F] [--realtime] [--vcam]
+// 模型文件 modnet.onnx 需位于当前目录
+#include "bgcamengine.h"
+#include "framepool.h"
+#include "playbacksource.h"
+#include "taskscheduler.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    std::string sourceArg = "synthetic";
+    std::string background;
+    std::string output = "bgcamrender.mp4";
+    long long maxFrames = 300;
+    cv::Size size(1280, 720);
+    double fps = 30.0;
+    bool realtime = false;
+    bool vcam = false;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--source") == 0 && hasValue) {
+            sourceArg = argv[++i];
+        } else if (std::strcmp(argv[i], "--background") == 0 && hasValue) {
+            background = argv[++i];
+        } else if (std::strcmp(argv[i], "--output") == 0 && hasValue) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            maxFrames = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &size.width, &size.height) != 2) {
+                std::fprintf(stderr, "无效的分辨率：%s\n", argv[i]);
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--fps") == 0 && hasValue) {
+            fps = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        } else if (std::strcmp(argv[i], "--vcam") == 0) {
+            vcam = true;
+        } else {
+            std::fprintf(stderr, "未知参数：%s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    FramePool::instance().install();
+    TaskScheduler::instance().installOpenCvBackend();
+    std::mutex mutex;
+    std::condition_variable frameArrived;
+    bool framePending = false;
+    auto notify = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            framePending = true;
+        }
+        frameArrived.notify_one();
+    };
+
+    try {
+        // 先加载模型和背景再打开帧源：帧源一打开就开始出帧并打时间戳，
+        // 加载期间积压的帧会早于录制文件的零点
+        BgCamEngine engine;
+        if (!background.empty()) {
+            engine.segmentor().setBackground(background, "image");
+            engine.setBackgroundEnabled(true);
+        }
+
+        // 不限速时每一帧都会处理，输出文件与机器速度无关
+        const SourcePacing pacing = realtime ? SourcePacing::RealTime : SourcePacing::AsFastAsPossible;
+        std::unique_ptr<PlaybackSource> source;
+        bool opened = false;
+        if (sourceArg == "synthetic") {
+            auto synthetic = std::make_unique<SyntheticSource>();
+            synthetic->setFrameCallback(notify);
+            synthetic->setPacing(pacing);
+            opened = synthetic->open(size, fps);
+            source = std::move(synthetic);
+        } else if (std::filesystem::is_directory(std::filesystem::u8path(sourceArg))) {
+            auto images = std::make_unique<ImageSequenceSource>();
+            images->setFrameCallback(notify);
+            images->setPacing(pacing);
+            opened = images->open(sourceArg, fps);
+            source = std::move(images);
+        } else {
+            auto video = std::make_unique<VideoFileSource>();
+            video->setFrameCallback(notify);
+            video->setPacing(pacing);
+            opened = video->open(sourceArg, false);
+            source = std::move(video);
+        }
+        if (!opened) {
+            std::fprintf(stderr, "无法打开帧源：%s\n", sourceArg.c_str());
+            return 1;
+        }
+
+        const CaptureFormat format = source->negotiated();
+        engine.setSource(std::move(source));
+
+        RecordingOptions options;
+        options.frameSize = format.size;
+        options.fps = format.fps > 0 ? format.fps : fps;
+        std::string error;
+        if (!engine.startRecording(output, options, nullptr, 8, QueueOverflowPolicy::Block, &error)) {
+            std::fprintf(stderr, "无法创建输出文件：%s\n", error.c_str());
+            return 1;
+        }
+        if (vcam && !engine.startVirtualCamera()) {
+            std::fprintf(stderr, "虚拟摄像头启动失败，继续渲染\n");
+        }
+        std::printf("%dx%d @%.2f -> %s\n", format.size.width, format.size.height, options.fps, output.c_str());
+
+        const auto start = std::chrono::steady_clock::now();
+        cv::Mat frame;
+        int64_t captureUs = 0;
+        while (maxFrames <= 0 || static_cast<long long>(engine.processedFrames()) < maxFrames) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                frameArrived.wait_for(lock, std::chrono::milliseconds(100), [&] { return framePending; });
+                framePending = false;
+            }
+            if (!engine.processFrame(frame, captureUs) && !engine.isSourceOpen()) {
+                break; // 视频播放到结尾
+            }
+        }
+        engine.closeSource();
+        const std::vector<std::string> files = engine.stopRecording();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("完成：%llu 帧，%.1f 秒（%.1f fps），%zu 个文件\n",
+                    static_cast<unsigned long long>(engine.processedFrames()), seconds,
+                    seconds > 0 ? engine.processedFrames() / seconds : 0.0, files.size());
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+// 虚拟摄像头参考读端：从共享内存帧环读取 BgCam 的输出，显示画面并统计帧率、端到端延迟和撕裂帧
+// 用法：vcamconsumer [共享内存名称] [--headless]
+#include "mediaclock.h"
+#include "vcamshm.h"
+#include <opencv2/opencv.hpp>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+bool validHeader(const SharedMemoryRegion& shm)
+{
+    const auto* header = reinterpret_cast<const VcamHeader*>(shm.data());
+    if (header->magic != VCAM_MAGIC || header->version != VCAM_VERSION || header->fourcc != VCAM_FOURCC_I420
+        || header->slotCount == 0 || header->slotCount > VCAM_SLOTS) {
+        return false;
+    }
+    const size_t needed = header->dataOffset + static_cast<size_t>(header->frameBytes) * header->slotCount;
+    return header->active.load(std::memory_order_acquire) != 0 && needed <= shm.size();
+}
+
+/**
+ * 按顺序锁拷贝第 sequence 帧；拷贝期间被写端覆盖时返回 false
+ */
+bool readFrame(const SharedMemoryRegion& shm, uint64_t sequence, cv::Mat& i420, int64_t& timestampUs)
+{
+    auto* header = reinterpret_cast<VcamHeader*>(shm.data());
+    const uint32_t slotIndex = static_cast<uint32_t>(sequence % header->slotCount);
+    VcamSlot& slot = header->slots[slotIndex];
+    if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+        return false;
+    }
+    i420.create(static_cast<int>(header->height) * 3 / 2, static_cast<int>(header->width), CV_8UC1);
+    std::memcpy(i420.data, shm.data() + header->dataOffset + static_cast<size_t>(slotIndex) * header->frameBytes,
+                header->frameBytes);
+    timestampUs = slot.timestampUs;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    std::string name = VCAM_DEFAULT_NAME;
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else {
+            name = argv[i];
+        }
+    }
+
+    SharedMemoryRegion shm;
+    uint64_t lastSequence = 0;
+    int64_t lastFrameUs = 0;
+    int frames = 0;
+    int torn = 0;
+    int skipped = 0;
+    double latencyMsSum = 0.0;
+    auto statsStart = std::chrono::steady_clock::now();
+    cv::Mat i420;
+    cv::Mat bgr;
+    std::printf("等待共享内存 %s ...\n", name.c_str());
+    for (;;) {
+        // 写端关闭（active 为 0）或 2 秒没有新帧时重新打开，写端重启后能自动接上
+        if (!shm.data() || !validHeader(shm) || (lastFrameUs > 0 && mediaClockUs() - lastFrameUs > 2000000)) {
+            shm.close();
+            lastFrameUs = 0;
+            if (!shm.open(name) || !validHeader(shm)) {
+                shm.close();
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+                continue;
+            }
+            const auto* header = reinterpret_cast<const VcamHeader*>(shm.data());
+            std::printf("已连接：%ux%u I420，%u 个槽位\n", header->width, header->height, header->slotCount);
+            lastSequence = header->latest.load(std::memory_order_acquire);
+            lastFrameUs = mediaClockUs();
+        }
+
+        const auto* header = reinterpret_cast<const VcamHeader*>(shm.data());
+        const uint64_t latest = header->latest.load(std::memory_order_acquire);
+        if (latest == lastSequence) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+        if (latest > lastSequence + 1) {
+            skipped += static_cast<int>(latest - lastSequence - 1);
+        }
+        lastSequence = latest;
+        int64_t timestampUs = 0;
+        if (!readFrame(shm, latest, i420, timestampUs)) {
+            ++torn;
+            continue;
+        }
+        lastFrameUs = mediaClockUs();
+        latencyMsSum += (lastFrameUs - timestampUs) / 1000.0; // 同机同一单调时钟，可直接相减
+        ++frames;
+
+        if (!headless) {
+            cv::cvtColor(i420, bgr, cv::COLOR_YUV2BGR_I420);
+            cv::imshow("vcamconsumer", bgr);
+            if (cv::waitKey(1) == 27) {
+                break;
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(now - statsStart).count();
+        if (seconds >= 1.0) {
+            std::printf("%.1f fps  延迟 %.1f ms  跳过 %d  撕裂 %d\n", frames / seconds,
+                        frames > 0 ? latencyMsSum / frames : 0.0, skipped, torn);
+            frames = 0;
+            torn = 0;
+            skipped = 0;
+            latencyMsSum = 0.0;
+            statsStart = now;
+        }
+    }
+    return 0;
+}
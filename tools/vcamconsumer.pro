@@ -0,0 +1,26 @@
+# 虚拟摄像头参考读端：读取 BgCam 共享内存帧环并显示
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+SOURCES += \
+    vcamconsumer.cpp \
+    ../vcamshm.cpp
+
+HEADERS += \
+    ../mediaclock.h \
+    ../vcamshm.h
+
+INCLUDEPATH += $${PWD}/..
+
+win32 {
+    INCLUDEPATH += C:\Qt\opencv\forQt/install/include
+    LIBS += C:\Qt\opencv\forQt/install/x64/mingw/lib/libopencv_*.a
+}
+unix {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += opencv4
+}
+unix:!macx {
+    LIBS += -lrt
+}
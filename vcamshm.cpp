@@ -0,0 +1,142 @@
+#include "vcamshm.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+std::wstring mappingName(const std::string& name)
+{
+    // 名称只用 ASCII；Local\ 命名空间不需要管理员权限
+    return L"Local\\" + std::wstring(name.begin(), name.end());
+}
+#else
+std::string mappingName(const std::string& name)
+{
+    return "/" + name;
+}
+#endif
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    close();
+}
+
+bool SharedMemoryRegion::create(const std::string& name, size_t bytes)
+{
+    close();
+#ifdef _WIN32
+    const uint64_t size = bytes;
+    handle = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                static_cast<DWORD>(size >> 32), static_cast<DWORD>(size & 0xFFFFFFFF),
+                                mappingName(name).c_str());
+    if (!handle) {
+        return false;
+    }
+    // 名称已存在时（读端仍持有上一次的映射）沿用它，只要容量足够；读端每帧都会核对头部的尺寸
+    const bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+    ptr = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info{};
+    if (ptr && existed && (VirtualQuery(ptr, &info, sizeof(info)) == 0 || info.RegionSize < bytes)) {
+        UnmapViewOfFile(ptr);
+        ptr = nullptr;
+    }
+#else
+    // 先删除旧名称：仍持有旧映射的读端不受影响，会在看到 active 为 0 后重新打开
+    shm_unlink(mappingName(name).c_str());
+    fd = shm_open(mappingName(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ::close(fd);
+        fd = -1;
+        shm_unlink(mappingName(name).c_str());
+        return false;
+    }
+    ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        ptr = nullptr;
+    }
+#endif
+    this->name = name;
+    this->bytes = bytes;
+    owner = true;
+    if (!ptr) {
+        close();
+        return false;
+    }
+    std::memset(ptr, 0, bytes);
+    return true;
+}
+
+bool SharedMemoryRegion::open(const std::string& name)
+{
+    close();
+#ifdef _WIN32
+    handle = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, mappingName(name).c_str());
+    if (!handle) {
+        return false;
+    }
+    ptr = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info{};
+    if (ptr && VirtualQuery(ptr, &info, sizeof(info)) != 0) {
+        bytes = info.RegionSize;
+    }
+#else
+    fd = shm_open(mappingName(name).c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        bytes = static_cast<size_t>(st.st_size);
+        ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED) {
+            ptr = nullptr;
+        }
+    }
+#endif
+    this->name = name;
+    owner = false;
+    if (!ptr || bytes < sizeof(VcamHeader)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SharedMemoryRegion::close()
+{
+#ifdef _WIN32
+    if (ptr) {
+        UnmapViewOfFile(ptr);
+    }
+    if (handle) {
+        CloseHandle(handle);
+    }
+    handle = nullptr;
+#else
+    if (ptr) {
+        munmap(ptr, bytes);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = -1;
+    if (owner) {
+        shm_unlink(mappingName(name).c_str());
+    }
+#endif
+    ptr = nullptr;
+    bytes = 0;
+    owner = false;
+}
@@ -0,0 +1,91 @@
+#ifndef VCAMSHM_H
+#define VCAMSHM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * 虚拟摄像头共享内存布局（写端为 BgCam，读端为会议软件插件或 tools/vcamconsumer）
+ *
+ * 映射开头是 VcamHeader，之后是 slotCount 个帧槽，每槽 frameBytes 字节（I420）。
+ * 写端按序号轮流写槽位，每个槽位用序号做顺序锁：写之前把槽位序号清 0，写完后填入帧序号；
+ * 读端拷贝前后各读一次槽位序号，两次都等于 latest 才说明读到的是完整的一帧。
+ * 写端正常关闭时把 active 置 0，读端看到后应重新打开映射。
+ */
+constexpr uint32_t VCAM_MAGIC = 0x43564742;     // "BGVC"
+constexpr uint32_t VCAM_VERSION = 1;
+constexpr uint32_t VCAM_SLOTS = 3;
+constexpr uint32_t VCAM_FOURCC_I420 = 0x30323449; // "I420"
+constexpr const char* VCAM_DEFAULT_NAME = "BgCamVirtualCamera";
+
+struct VcamSlot {
+    std::atomic<uint64_t> sequence;     // 0 表示正在写入
+    int64_t timestampUs;                // 采集时间戳（mediaClockUs）
+};
+
+struct VcamHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t fourcc;
+    uint32_t frameBytes;                // 每帧字节数（I420 为 w*h*3/2）
+    uint32_t slotCount;
+    uint32_t dataOffset;                // 第一个帧槽相对映射起点的偏移
+    std::atomic<uint32_t> active;
+    uint32_t reserved;
+    std::atomic<uint64_t> latest;       // 最近写完的帧序号，0 表示还没有帧
+    VcamSlot slots[VCAM_SLOTS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "共享内存中的原子量必须无锁");
+
+/**
+ * @brief 帧槽数据的起始偏移（按 64 字节对齐）
+ */
+inline size_t vcamDataOffset()
+{
+    return (sizeof(VcamHeader) + 63) & ~static_cast<size_t>(63);
+}
+
+/**
+ * @brief 命名共享内存映射（Windows 为 Local\ 命名空间的文件映射，其余平台为 POSIX shm）
+ */
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion();
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    /**
+     * @brief 创建（或替换同名的）映射，内容清零
+     */
+    bool create(const std::string& name, size_t bytes);
+    /**
+     * @brief 打开已有映射，大小取自映射本身
+     */
+    bool open(const std::string& name);
+    /**
+     * @brief 解除映射；创建者同时删除名称，已打开的读端保留旧映射直到自行关闭
+     */
+    void close();
+
+    uint8_t* data() const { return static_cast<uint8_t*>(ptr); }
+    size_t size() const { return bytes; }
+
+private:
+    std::string name;
+    bool owner = false;
+    void* ptr = nullptr;
+    size_t bytes = 0;
+#ifdef _WIN32
+    void* handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+#endif // VCAMSHM_H
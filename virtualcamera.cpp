@@ -0,0 +1,177 @@
+#include "virtualcamera.h"
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+VirtualCamera::~VirtualCamera()
+{
+    close();
+}
+
+bool VirtualCamera::open(cv::Size size, const std::string& name, bool loopback)
+{
+    close();
+    size.width &= ~1;
+    size.height &= ~1;
+    if (size.width <= 0 || size.height <= 0) {
+        return false;
+    }
+    frameBytes = static_cast<size_t>(size.width) * size.height * 3 / 2;
+    if (!shm.create(name, vcamDataOffset() + frameBytes * VCAM_SLOTS)) {
+        std::cerr << "[VirtualCamera] 无法创建共享内存 " << name << std::endl;
+        return false;
+    }
+    header = reinterpret_cast<VcamHeader*>(shm.data());
+    header->magic = VCAM_MAGIC;
+    header->version = VCAM_VERSION;
+    header->width = static_cast<uint32_t>(size.width);
+    header->height = static_cast<uint32_t>(size.height);
+    header->fourcc = VCAM_FOURCC_I420;
+    header->frameBytes = static_cast<uint32_t>(frameBytes);
+    header->slotCount = VCAM_SLOTS;
+    header->dataOffset = static_cast<uint32_t>(vcamDataOffset());
+    header->latest.store(0, std::memory_order_relaxed);
+    header->active.store(1, std::memory_order_release);
+    this->size = size;
+    shmName = name;
+    sequence = 0;
+    if (loopback) {
+        openLoopback();
+    }
+    std::cout << "[VirtualCamera] " << size.width << "x" << size.height << " -> " << name
+              << (loopbackPath.empty() ? "" : " + " + loopbackPath) << std::endl;
+    return true;
+}
+
+void VirtualCamera::close()
+{
+    if (header) {
+        header->active.store(0, std::memory_order_release);
+        header = nullptr;
+    }
+    shm.close();
+#ifdef __linux__
+    if (loopbackFd >= 0) {
+        ::close(loopbackFd);
+    }
+#endif
+    loopbackFd = -1;
+    loopbackPath.clear();
+}
+
+bool VirtualCamera::openLoopback()
+{
+#ifdef __linux__
+    DIR* dir = opendir("/dev");
+    if (!dir) {
+        return false;
+    }
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "video", 5) != 0) {
+            continue;
+        }
+        const std::string path = std::string("/dev/") + entry->d_name;
+        const int fd = ::open(path.c_str(), O_WRONLY | O_NONBLOCK);
+        if (fd < 0) {
+            continue;
+        }
+        v4l2_capability cap{};
+        if (ioctl(fd, VIDIOC_QUERYCAP, &cap) != 0
+            || std::strcmp(reinterpret_cast<const char*>(cap.driver), "v4l2 loopback") != 0) {
+            ::close(fd);
+            continue;
+        }
+        // 输出格式与共享内存一致（I420），每帧一次 write
+        v4l2_format format{};
+        format.type = V4L2_BUF_TYPE_VIDEO_OUTPUT;
+        format.fmt.pix.width = static_cast<uint32_t>(size.width);
+        format.fmt.pix.height = static_cast<uint32_t>(size.height);
+        format.fmt.pix.pixelformat = V4L2_PIX_FMT_YUV420;
+        format.fmt.pix.field = V4L2_FIELD_NONE;
+        format.fmt.pix.bytesperline = static_cast<uint32_t>(size.width);
+        format.fmt.pix.sizeimage = static_cast<uint32_t>(frameBytes);
+        format.fmt.pix.colorspace = V4L2_COLORSPACE_SMPTE170M;
+        if (ioctl(fd, VIDIOC_S_FMT, &format) != 0) {
+            ::close(fd);
+            continue;
+        }
+        loopbackFd = fd;
+        loopbackPath = path;
+        break;
+    }
+    closedir(dir);
+    return loopbackFd >= 0;
+#else
+    return false;
+#endif
+}
+
+bool VirtualCamera::publish(const cv::Mat& frame, int64_t captureUs)
+{
+    if (!header || frame.empty()) {
+        return false;
+    }
+    const bool nv12 = frame.type() == CV_8UC1 && frame.rows % 3 == 0;
+    if (!nv12 && frame.type() != CV_8UC3) {
+        return false;
+    }
+    const cv::Size frameSize(frame.cols, nv12 ? frame.rows * 2 / 3 : frame.rows);
+    const cv::Mat* source = &frame;
+    bool sourceNv12 = nv12;
+    if (frameSize != size) {
+        // 尺寸不同（很少见）时先转 BGR 再缩放
+        if (nv12) {
+            cv::cvtColor(frame, scaled, cv::COLOR_YUV2BGR_NV12);
+            cv::resize(scaled, scaled, size);
+        } else {
+            cv::resize(frame, scaled, size);
+        }
+        source = &scaled;
+        sourceNv12 = false;
+    }
+
+    const uint64_t next = sequence + 1;
+    VcamSlot& slot = header->slots[next % VCAM_SLOTS];
+    // 顺序锁：先标记槽位正在写入，读端据此丢弃读到一半的数据
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint8_t* data = shm.data() + vcamDataOffset() + (next % VCAM_SLOTS) * frameBytes;
+    const int w = size.width;
+    const int h = size.height;
+    // 槽位本身包装成 Mat，颜色转换直接写入共享内存
+    cv::Mat i420(h * 3 / 2, w, CV_8UC1, data);
+    if (sourceNv12) {
+        cv::Mat y = i420.rowRange(0, h);
+        source->rowRange(0, h).copyTo(y);
+        const cv::Mat uv(h / 2, w / 2, CV_8UC2, const_cast<uchar*>(source->ptr<uchar>(h)), source->step);
+        cv::Mat planes[] = {cv::Mat(h / 2, w / 2, CV_8UC1, data + static_cast<size_t>(w) * h),
+                            cv::Mat(h / 2, w / 2, CV_8UC1, data + static_cast<size_t>(w) * h * 5 / 4)};
+        cv::split(uv, planes);
+    } else {
+        cv::cvtColor(*source, i420, cv::COLOR_BGR2YUV_I420);
+    }
+
+    slot.timestampUs = captureUs;
+    slot.sequence.store(next, std::memory_order_release);
+    header->latest.store(next, std::memory_order_release);
+    sequence = next;
+
+#ifdef __linux__
+    if (loopbackFd >= 0 && ::write(loopbackFd, data, frameBytes) < 0 && errno != EAGAIN) {
+        std::cerr << "[VirtualCamera] 写入 " << loopbackPath << " 失败，停止输出到该设备" << std::endl;
+        ::close(loopbackFd);
+        loopbackFd = -1;
+        loopbackPath.clear();
+    }
+#endif
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef VIRTUALCAMERA_H
+#define VIRTUALCAMERA_H
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include "vcamshm.h"
+
+/**
+ * @brief 虚拟摄像头输出
+ *
+ * 把合成后的每一帧发布到命名共享内存的帧环（布局见 vcamshm.h），供同机的会议软件插件或测试程序读取；
+ * Linux 下检测到 v4l2loopback 设备时同时写入该设备，其他程序可以直接把它当摄像头打开。
+ * 帧以 I420 存放，颜色转换的结果直接写进共享内存槽位，除这一次转换外没有额外拷贝。
+ */
+class VirtualCamera {
+public:
+    VirtualCamera() = default;
+    ~VirtualCamera();
+    VirtualCamera(const VirtualCamera&) = delete;
+    VirtualCamera& operator=(const VirtualCamera&) = delete;
+
+    /**
+     * @brief 创建共享内存帧环
+     * @param size 输出分辨率（宽高向下取偶数）
+     * @param loopback 是否同时写入找到的第一个 v4l2loopback 设备（仅 Linux）
+     */
+    bool open(cv::Size size, const std::string& name = VCAM_DEFAULT_NAME, bool loopback = true);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    /**
+     * @brief 发布一帧
+     * @param frame BGR（CV_8UC3）或 NV12（CV_8UC1，高为图像高度的 1.5 倍）；尺寸与输出不同时先缩放
+     * @param captureUs 采集时间戳（mediaClockUs）
+     */
+    bool publish(const cv::Mat& frame, int64_t captureUs);
+
+    cv::Size frameSize() const { return size; }
+    std::string name() const { return shmName; }
+    /**
+     * @brief 正在写入的 v4l2loopback 设备路径，没有时为空
+     */
+    std::string loopbackDevice() const { return loopbackPath; }
+    uint64_t publishedFrames() const { return sequence; }
+
+private:
+    bool openLoopback();
+
+    SharedMemoryRegion shm;
+    VcamHeader* header = nullptr;
+    std::string shmName;
+    cv::Size size;
+    size_t frameBytes = 0;
+    uint64_t sequence = 0;
+    cv::Mat scaled;             // 输入尺寸不同时的缩放结果
+    int loopbackFd = -1;
+    std::string loopbackPath;
+};
+
+#endif // VIRTUALCAMERA_H